@@ -0,0 +1,717 @@
+#ifndef M42_BAND_MATRIX_HPP
+#define M42_BAND_MATRIX_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "banded.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class VectorView;
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    template <Arithmetic T>
+    class BandLU;
+
+    /**
+     * @brief Square matrix whose nonzero elements lie on a few diagonals
+     *
+     * Stores kl subdiagonals and ku superdiagonals, (kl + ku + 1) * n
+     * elements instead of n * n. Every diagonal is a contiguous array so the
+     * product with a vector vectorizes along the diagonals; diagonal(d) gives
+     * direct access to them, d > 0 above the main diagonal.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class BandMatrix
+    {
+    private:
+        size_t _size;
+        size_t _lower;
+        size_t _upper;
+        std::vector<T> _diagonals;
+
+    public:
+        using value_type = T;
+
+        BandMatrix(size_t size, size_t lower, size_t upper);
+        BandMatrix(const MatrixView<T> &dense, size_t lower, size_t upper);
+
+        size_t size() const;
+        size_t lower() const;
+        size_t upper() const;
+        VectorView<T> diagonal(std::ptrdiff_t d);
+        const VectorView<T> diagonal(std::ptrdiff_t d) const;
+        Matrix<T> toDense() const;
+        BandLU<T> lu() const;
+        void multiply(const VectorView<T> &x, VectorView<T> &y) const;
+
+        T &operator()(size_t column, size_t row);
+        T operator()(size_t column, size_t row) const;
+        Vector<T> operator*(const VectorView<T> &vector) const;
+    };
+
+    /**
+     * @brief LU factorization with partial pivoting of a band matrix
+     *
+     * Factoring and every solve run in O(n * kl * (kl + ku)) time and the
+     * factors take (2 * kl + ku + 1) * n elements: row interchanges widen U
+     * by kl superdiagonals. Integer matrices are factored in double
+     * precision.
+     *
+     * @tparam T Type of components of the factored matrix
+     */
+    template <Arithmetic T>
+    class BandLU
+    {
+    public:
+        using value_type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+    private:
+        size_t _size;
+        size_t _lower;
+        size_t _upper;
+        std::vector<value_type> _factors;
+        std::vector<size_t> _pivots;
+        bool _singular;
+
+    public:
+        explicit BandLU(const BandMatrix<T> &matrix);
+
+        size_t size() const;
+        bool isSingular() const;
+        value_type determinant() const;
+        Vector<value_type> solve(const VectorView<value_type> &b) const;
+        void solveInPlace(VectorView<value_type> b) const;
+        void solveInPlace(MatrixView<value_type> b) const;
+    };
+
+    /**
+     * @brief Tridiagonal matrix solved with the Thomas algorithm
+     *
+     * The three diagonals are stored as vectors of n - 1, n and n - 1
+     * elements. Solves eliminate without pivoting in O(n), which is stable
+     * for the diagonally dominant or symmetric positive definite matrices
+     * produced by finite differences; use BandMatrix and BandLU otherwise,
+     * they also factor integer matrices in double precision.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class TridiagonalMatrix
+    {
+    private:
+        Vector<T> _lower;
+        Vector<T> _diagonal;
+        Vector<T> _upper;
+
+    public:
+        using value_type = T;
+
+        explicit TridiagonalMatrix(size_t size);
+        TridiagonalMatrix(const VectorView<T> &lower, const VectorView<T> &diagonal, const VectorView<T> &upper);
+
+        size_t size() const;
+        VectorView<T> &lower();
+        const VectorView<T> &lower() const;
+        VectorView<T> &diagonal();
+        const VectorView<T> &diagonal() const;
+        VectorView<T> &upper();
+        const VectorView<T> &upper() const;
+        Matrix<T> toDense() const;
+        void multiply(const VectorView<T> &x, VectorView<T> &y) const;
+        Vector<T> solve(const VectorView<T> &b) const
+            requires std::floating_point<T>;
+        void solveInPlace(VectorView<T> b) const
+            requires std::floating_point<T>;
+        void solveInPlace(MatrixView<T> b) const
+            requires std::floating_point<T>;
+
+        Vector<T> operator*(const VectorView<T> &vector) const;
+    };
+
+    /**
+     * @brief Construct a zero band matrix
+     *
+     * An empty matrix has no off-diagonals, so both bandwidths must be 0.
+     *
+     * @param size Number of rows and columns
+     * @param lower Number of subdiagonals
+     * @param upper Number of superdiagonals
+     */
+    template <Arithmetic T>
+    BandMatrix<T>::BandMatrix(size_t size, size_t lower, size_t upper)
+        : _size(size), _lower(lower), _upper(upper), _diagonals((lower + upper + 1) * size, T(0))
+    {
+        if (lower >= std::max<size_t>(size, 1) || upper >= std::max<size_t>(size, 1))
+            throw std::invalid_argument("Bandwidth must be smaller than the matrix size");
+    }
+
+    /**
+     * @brief Copy the band of a dense square matrix, elements outside it are ignored
+     *
+     * @param dense Square matrix or block
+     * @param lower Number of subdiagonals
+     * @param upper Number of superdiagonals
+     */
+    template <Arithmetic T>
+    BandMatrix<T>::BandMatrix(const MatrixView<T> &dense, size_t lower, size_t upper)
+        : BandMatrix(dense.width(), lower, upper)
+    {
+        if (!dense.isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        for (size_t j = 0; j < _size; j++)
+        {
+            size_t i0 = j > _upper ? j - _upper : 0;
+            size_t i1 = std::min(_size, j + _lower + 1);
+            for (size_t i = i0; i < i1; i++)
+                (*this)(j, i) = dense.data()[j * dense.stride() + i];
+        }
+    }
+
+    /**
+     * @brief Get the number of rows and columns
+     *
+     * @return size_t Size of the matrix
+     */
+    template <Arithmetic T>
+    size_t BandMatrix<T>::size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief Get the number of subdiagonals
+     *
+     * @return size_t Lower bandwidth
+     */
+    template <Arithmetic T>
+    size_t BandMatrix<T>::lower() const
+    {
+        return _lower;
+    }
+
+    /**
+     * @brief Get the number of superdiagonals
+     *
+     * @return size_t Upper bandwidth
+     */
+    template <Arithmetic T>
+    size_t BandMatrix<T>::upper() const
+    {
+        return _upper;
+    }
+
+    /**
+     * @brief Return a view of a diagonal
+     *
+     * @param d 0 for the main diagonal, d > 0 above it, d < 0 below it
+     * @return VectorView<T> The n - |d| elements of the diagonal
+     */
+    template <Arithmetic T>
+    VectorView<T> BandMatrix<T>::diagonal(std::ptrdiff_t d)
+    {
+        if (d > static_cast<std::ptrdiff_t>(_upper) || -d > static_cast<std::ptrdiff_t>(_lower))
+            throw std::out_of_range("Diagonal outside the band");
+        size_t length = _size - static_cast<size_t>(d < 0 ? -d : d);
+        size_t r = static_cast<size_t>(static_cast<std::ptrdiff_t>(_upper) - d);
+        return VectorView<T>(_diagonals.data() + r * _size, length);
+    }
+
+    /**
+     * @brief Return a view of a diagonal
+     *
+     * @param d 0 for the main diagonal, d > 0 above it, d < 0 below it
+     * @return const VectorView<T> The n - |d| elements of the diagonal
+     */
+    template <Arithmetic T>
+    const VectorView<T> BandMatrix<T>::diagonal(std::ptrdiff_t d) const
+    {
+        return const_cast<BandMatrix *>(this)->diagonal(d);
+    }
+
+    /**
+     * @brief Return the dense matrix with the same elements
+     *
+     * @return Matrix<T> Dense matrix
+     */
+    template <Arithmetic T>
+    Matrix<T> BandMatrix<T>::toDense() const
+    {
+        Matrix<T> result(_size, _size);
+        std::fill(result.data(), result.data() + _size * _size, T(0));
+        for (size_t j = 0; j < _size; j++)
+        {
+            size_t i0 = j > _upper ? j - _upper : 0;
+            size_t i1 = std::min(_size, j + _lower + 1);
+            for (size_t i = i0; i < i1; i++)
+                result.data()[j * _size + i] = (*this)(j, i);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Return the LU factorization of the matrix with partial pivoting
+     *
+     * @return BandLU<T> Factorization, reusable for determinants and solves
+     */
+    template <Arithmetic T>
+    BandLU<T> BandMatrix<T>::lu() const
+    {
+        return BandLU<T>(*this);
+    }
+
+    /**
+     * @brief Compute y = A * x into caller-supplied storage
+     *
+     * @param x Vector of size() elements
+     * @param y Vector of size() elements, overwritten
+     */
+    template <Arithmetic T>
+    void BandMatrix<T>::multiply(const VectorView<T> &x, VectorView<T> &y) const
+    {
+        if (x.size() != _size || y.size() != _size)
+            throw std::invalid_argument("Vector size must match matrix size");
+        scratch::contiguousProduct(x, y, [&](const T *in, T *out)
+                                   { banded::dgbmv(_size, _lower, _upper, _diagonals.data(), in, out); });
+    }
+
+    /**
+     * @brief Get an element inside the band
+     *
+     * @param column Column index
+     * @param row Row index
+     * @return T& Element, throws std::out_of_range outside the band
+     */
+    template <Arithmetic T>
+    T &BandMatrix<T>::operator()(size_t column, size_t row)
+    {
+        if (column >= _size || row >= _size)
+            throw std::out_of_range("Index out of range");
+        if (column > row + _upper || row > column + _lower)
+            throw std::out_of_range("Element outside the band");
+        // element k of diagonal d starts at row max(0, -d), that is min(row, column)
+        return _diagonals[(_upper + row - column) * _size + std::min(row, column)];
+    }
+
+    /**
+     * @brief Get an element, zero outside the band
+     *
+     * @param column Column index
+     * @param row Row index
+     * @return T Element
+     */
+    template <Arithmetic T>
+    T BandMatrix<T>::operator()(size_t column, size_t row) const
+    {
+        if (column >= _size || row >= _size)
+            throw std::out_of_range("Index out of range");
+        if (column > row + _upper || row > column + _lower)
+            return T(0);
+        return _diagonals[(_upper + row - column) * _size + std::min(row, column)];
+    }
+
+    /**
+     * @brief Multiply the matrix by a vector
+     *
+     * @param vector Vector to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> BandMatrix<T>::operator*(const VectorView<T> &vector) const
+    {
+        Vector<T> result(_size);
+        multiply(vector, result);
+        return result;
+    }
+
+    /**
+     * @brief Factor a band matrix
+     *
+     * @param matrix Band matrix to factor
+     */
+    template <Arithmetic T>
+    BandLU<T>::BandLU(const BandMatrix<T> &matrix)
+        : _size(matrix.size()), _lower(matrix.lower()), _upper(matrix.upper()),
+          _factors((2 * matrix.lower() + matrix.upper() + 1) * matrix.size(), value_type(0)),
+          _pivots(matrix.size()), _singular(false)
+    {
+        size_t ldab = 2 * _lower + _upper + 1;
+        size_t kv = _lower + _upper;
+        for (size_t j = 0; j < _size; j++)
+        {
+            size_t i0 = j > _upper ? j - _upper : 0;
+            size_t i1 = std::min(_size, j + _lower + 1);
+            for (size_t i = i0; i < i1; i++)
+                _factors[j * ldab + kv + i - j] = static_cast<value_type>(matrix(j, i));
+        }
+        _singular = !banded::gbtrf(_size, _lower, _upper, _factors.data(), ldab, _pivots.data());
+    }
+
+    /**
+     * @brief Get the size of the factored matrix
+     *
+     * @return size_t Number of rows and columns
+     */
+    template <Arithmetic T>
+    size_t BandLU<T>::size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief Check whether a zero pivot was found
+     *
+     * @return true The matrix is singular
+     * @return false The matrix is invertible
+     */
+    template <Arithmetic T>
+    bool BandLU<T>::isSingular() const
+    {
+        return _singular;
+    }
+
+    /**
+     * @brief Calculate the determinant from the diagonal of U
+     *
+     * @return value_type Determinant of the factored matrix
+     */
+    template <Arithmetic T>
+    typename BandLU<T>::value_type BandLU<T>::determinant() const
+    {
+        if (_singular)
+            return 0;
+        size_t ldab = 2 * _lower + _upper + 1;
+        size_t kv = _lower + _upper;
+        value_type result = 1;
+        for (size_t j = 0; j < _size; j++)
+        {
+            result *= _factors[j * ldab + kv];
+            if (_pivots[j] != j)
+                result = -result;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Solve A * x = b with the stored factors
+     *
+     * @param b Right-hand side
+     * @return Vector<value_type> Solution
+     */
+    template <Arithmetic T>
+    Vector<typename BandLU<T>::value_type> BandLU<T>::solve(const VectorView<value_type> &b) const
+    {
+        Vector<value_type> x(b);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief Overwrite b with the solution of A * x = b
+     *
+     * @param b Right-hand side, replaced by the solution
+     */
+    template <Arithmetic T>
+    void BandLU<T>::solveInPlace(VectorView<value_type> b) const
+    {
+        if (b.size() != _size)
+            throw std::invalid_argument("Vector size must match matrix height");
+        if (_singular)
+            throw std::invalid_argument("Matrix must be invertible");
+        if (!b.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<value_type> x(b);
+            solveInPlace(x);
+            b = x;
+            return;
+        }
+        banded::gbtrs(_size, _lower, _upper, 1, _factors.data(), 2 * _lower + _upper + 1,
+                      _pivots.data(), b.data(), _size);
+    }
+
+    /**
+     * @brief Overwrite every column of B with the solution of A * X = B
+     *
+     * @param b Right-hand sides, replaced by the solutions
+     */
+    template <Arithmetic T>
+    void BandLU<T>::solveInPlace(MatrixView<value_type> b) const
+    {
+        if (b.height() != _size)
+            throw std::invalid_argument("Matrix heights must match");
+        if (_singular)
+            throw std::invalid_argument("Matrix must be invertible");
+        banded::gbtrs(_size, _lower, _upper, b.width(), _factors.data(), 2 * _lower + _upper + 1,
+                      _pivots.data(), b.data(), b.stride());
+    }
+
+    /**
+     * @brief Construct a zero tridiagonal matrix
+     *
+     * @param size Number of rows and columns, at least 1
+     */
+    template <Arithmetic T>
+    TridiagonalMatrix<T>::TridiagonalMatrix(size_t size)
+        : _lower(size == 0 ? 0 : size - 1), _diagonal(size), _upper(size == 0 ? 0 : size - 1)
+    {
+        if (size == 0)
+            throw std::invalid_argument("Matrix size must be positive");
+        std::fill(_lower.data(), _lower.data() + size - 1, T(0));
+        std::fill(_diagonal.data(), _diagonal.data() + size, T(0));
+        std::fill(_upper.data(), _upper.data() + size - 1, T(0));
+    }
+
+    /**
+     * @brief Construct a tridiagonal matrix from its diagonals
+     *
+     * @param lower Subdiagonal, n - 1 elements
+     * @param diagonal Diagonal, n elements
+     * @param upper Superdiagonal, n - 1 elements
+     */
+    template <Arithmetic T>
+    TridiagonalMatrix<T>::TridiagonalMatrix(const VectorView<T> &lower, const VectorView<T> &diagonal, const VectorView<T> &upper)
+        : _lower(lower), _diagonal(diagonal), _upper(upper)
+    {
+        if (diagonal.size() == 0 || lower.size() + 1 != diagonal.size() || upper.size() + 1 != diagonal.size())
+            throw std::invalid_argument("Off-diagonals must be one element shorter than the diagonal");
+    }
+
+    /**
+     * @brief Get the number of rows and columns
+     *
+     * @return size_t Size of the matrix
+     */
+    template <Arithmetic T>
+    size_t TridiagonalMatrix<T>::size() const
+    {
+        return _diagonal.size();
+    }
+
+    /**
+     * @brief Get the subdiagonal
+     *
+     * @return VectorView<T>& Elements (i + 1, i)
+     */
+    template <Arithmetic T>
+    VectorView<T> &TridiagonalMatrix<T>::lower()
+    {
+        return _lower;
+    }
+
+    /**
+     * @brief Get the subdiagonal
+     *
+     * @return const VectorView<T>& Elements (i + 1, i)
+     */
+    template <Arithmetic T>
+    const VectorView<T> &TridiagonalMatrix<T>::lower() const
+    {
+        return _lower;
+    }
+
+    /**
+     * @brief Get the main diagonal
+     *
+     * @return VectorView<T>& Elements (i, i)
+     */
+    template <Arithmetic T>
+    VectorView<T> &TridiagonalMatrix<T>::diagonal()
+    {
+        return _diagonal;
+    }
+
+    /**
+     * @brief Get the main diagonal
+     *
+     * @return const VectorView<T>& Elements (i, i)
+     */
+    template <Arithmetic T>
+    const VectorView<T> &TridiagonalMatrix<T>::diagonal() const
+    {
+        return _diagonal;
+    }
+
+    /**
+     * @brief Get the superdiagonal
+     *
+     * @return VectorView<T>& Elements (i, i + 1)
+     */
+    template <Arithmetic T>
+    VectorView<T> &TridiagonalMatrix<T>::upper()
+    {
+        return _upper;
+    }
+
+    /**
+     * @brief Get the superdiagonal
+     *
+     * @return const VectorView<T>& Elements (i, i + 1)
+     */
+    template <Arithmetic T>
+    const VectorView<T> &TridiagonalMatrix<T>::upper() const
+    {
+        return _upper;
+    }
+
+    /**
+     * @brief Return the dense matrix with the same elements
+     *
+     * @return Matrix<T> Dense matrix
+     */
+    template <Arithmetic T>
+    Matrix<T> TridiagonalMatrix<T>::toDense() const
+    {
+        size_t n = size();
+        Matrix<T> result(n, n);
+        std::fill(result.data(), result.data() + n * n, T(0));
+        for (size_t i = 0; i < n; i++)
+        {
+            result.data()[i * n + i] = _diagonal[i];
+            if (i + 1 < n)
+            {
+                result.data()[i * n + i + 1] = _lower[i];
+                result.data()[(i + 1) * n + i] = _upper[i];
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Compute y = A * x into caller-supplied storage
+     *
+     * @param x Vector of size() elements
+     * @param y Vector of size() elements, overwritten
+     */
+    template <Arithmetic T>
+    void TridiagonalMatrix<T>::multiply(const VectorView<T> &x, VectorView<T> &y) const
+    {
+        size_t n = size();
+        if (x.size() != n || y.size() != n)
+            throw std::invalid_argument("Vector size must match matrix size");
+        scratch::contiguousProduct(x, y, [&](const T *in, T *out)
+                                   {
+                                       std::fill(out, out + n, T(0));
+                                       simd::multiplyAccumulate(_diagonal.data(), in, out, n);
+                                       simd::multiplyAccumulate(_upper.data(), in + 1, out, n - 1);
+                                       simd::multiplyAccumulate(_lower.data(), in, out + 1, n - 1); });
+    }
+
+    /**
+     * @brief Solve A * x = b
+     *
+     * @param b Right-hand side
+     * @return Vector<T> Solution
+     */
+    template <Arithmetic T>
+    Vector<T> TridiagonalMatrix<T>::solve(const VectorView<T> &b) const
+        requires std::floating_point<T>
+    {
+        Vector<T> x(b);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief Overwrite b with the solution of A * x = b
+     *
+     * @param b Right-hand side, replaced by the solution
+     */
+    template <Arithmetic T>
+    void TridiagonalMatrix<T>::solveInPlace(VectorView<T> b) const
+        requires std::floating_point<T>
+    {
+        if (b.size() != size())
+            throw std::invalid_argument("Vector size must match matrix height");
+        if (!b.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<T> x(b);
+            solveInPlace(x);
+            b = x;
+            return;
+        }
+        ScratchScope scope;
+        T *scratch = ScratchAllocator<T>().allocate(2 * size());
+        if (!banded::gtsv(size(), 1, _lower.data(), _diagonal.data(), _upper.data(), b.data(), size(), scratch))
+            throw std::invalid_argument("Zero pivot in tridiagonal solve");
+    }
+
+    /**
+     * @brief Overwrite every column of B with the solution of A * X = B
+     *
+     * The elimination is computed once for all columns.
+     *
+     * @param b Right-hand sides, replaced by the solutions
+     */
+    template <Arithmetic T>
+    void TridiagonalMatrix<T>::solveInPlace(MatrixView<T> b) const
+        requires std::floating_point<T>
+    {
+        if (b.height() != size())
+            throw std::invalid_argument("Matrix heights must match");
+        ScratchScope scope;
+        T *scratch = ScratchAllocator<T>().allocate(2 * size());
+        if (!banded::gtsv(size(), b.width(), _lower.data(), _diagonal.data(), _upper.data(), b.data(), b.stride(), scratch))
+            throw std::invalid_argument("Zero pivot in tridiagonal solve");
+    }
+
+    /**
+     * @brief Multiply the matrix by a vector
+     *
+     * @param vector Vector to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> TridiagonalMatrix<T>::operator*(const VectorView<T> &vector) const
+    {
+        Vector<T> result(size());
+        multiply(vector, result);
+        return result;
+    }
+
+    /**
+     * @brief Solve many independent tridiagonal systems of the same size
+     *
+     * Row k of every operand describes system k and column i its equation
+     * i, so lower(k, 0) and upper(k, n - 1) are never read. The systems are
+     * swept together, vectorized across rows.
+     *
+     * @param lower Subdiagonals, one system per row
+     * @param diagonal Diagonals, one system per row
+     * @param upper Superdiagonals, one system per row
+     * @param b Right-hand sides, one system per row, replaced by the solutions
+     */
+    template <std::floating_point T>
+    void solveTridiagonalBatch(const MatrixView<T> &lower, const MatrixView<T> &diagonal,
+                               const MatrixView<T> &upper, MatrixView<T> &b)
+    {
+        size_t n = b.width();
+        size_t count = b.height();
+        for (const MatrixView<T> *m : {&lower, &diagonal, &upper})
+            if (m->width() != n || m->height() != count)
+                throw std::invalid_argument("Coefficients and right-hand sides must have the same dimensions");
+        ScratchScope scope;
+        T *scratch = ScratchAllocator<T>().allocate(n * count);
+        if (!banded::gtsvBatch(n, count, lower.data(), lower.stride(), diagonal.data(), diagonal.stride(),
+                               upper.data(), upper.stride(), b.data(), b.stride(), scratch))
+            throw std::invalid_argument("Zero pivot in tridiagonal solve");
+    }
+
+}
+
+#endif
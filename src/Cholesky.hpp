@@ -0,0 +1,298 @@
+#ifndef M42_CHOLESKY_HPP
+#define M42_CHOLESKY_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "blas.hpp"
+#include "simd.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    template <Arithmetic T>
+    class VectorView;
+
+    /**
+     * @brief Cholesky factorization of a symmetric positive definite matrix, A = L * L^T
+     *
+     * Only the lower triangle of A is read. The factor is stored with L on
+     * and below the diagonal and L^T mirrored above it, so both triangular
+     * solves run on contiguous columns. Integer matrices are factored in
+     * double precision.
+     *
+     * @tparam T Type of components of the factored matrix
+     */
+    template <Arithmetic T>
+    class Cholesky
+    {
+    public:
+        using value_type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+        /**
+         * @brief Number of columns factored by the unblocked panel kernel
+         */
+        static constexpr size_t blockSize = 64;
+
+    private:
+        Matrix<value_type> _factor;
+
+        void factorPanel(size_t k0, size_t kb);
+        void substitute(value_type *b, size_t ldb, size_t nrhs) const;
+
+    public:
+        explicit Cholesky(const MatrixView<T> &matrix, Execution policy = Execution::Parallel);
+
+        size_t size() const;
+        const Matrix<value_type> &packed() const;
+        Matrix<value_type> lower() const;
+        value_type determinant() const;
+        value_type logDeterminant() const;
+        Vector<value_type> solve(const VectorView<value_type> &b) const;
+        Matrix<value_type> solve(const MatrixView<value_type> &b) const;
+        void solveInPlace(VectorView<value_type> b) const;
+        void solveInPlace(MatrixView<value_type> b) const;
+    };
+
+    /**
+     * @brief Factor a symmetric positive definite matrix
+     *
+     * The factorization is right-looking and blocked: each panel of
+     * blockSize columns is factored with vectorized column operations, then
+     * the lower triangle of the trailing matrix is updated with GEMM, one
+     * block column at a time so the upper triangle costs no flops.
+     *
+     * @param matrix Square matrix, only its lower triangle is read
+     * @param policy Execution policy of the trailing updates
+     */
+    template <Arithmetic T>
+    Cholesky<T>::Cholesky(const MatrixView<T> &matrix, Execution policy) : _factor(matrix.width(), matrix.height())
+    {
+        if (!matrix.isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        size_t n = matrix.height();
+        value_type *a = _factor.data();
+        // the trailing GEMM reads the upper triangle of each diagonal block, zero it
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < n; i++)
+                a[j * n + i] = i >= j ? matrix.data()[j * matrix.stride() + i] : value_type(0);
+
+        // L21 transposed, the right-hand operand of the trailing update
+        ScratchScope scope;
+        value_type *transposed = ScratchAllocator<value_type>().allocate(std::min(blockSize, n) * n);
+        for (size_t k0 = 0; k0 < n; k0 += blockSize)
+        {
+            size_t kb = std::min(blockSize, n - k0);
+            factorPanel(k0, kb);
+            size_t rest = n - k0 - kb;
+            if (rest == 0)
+                continue;
+            const value_type *l21 = a + k0 * n + k0 + kb;
+            blas::transpose(rest, kb, l21, n, transposed, kb, policy);
+            // A22 -= L21 * L21^T, lower triangle only, block columns are independent tasks
+            parallel::forRange(policy, (rest + blockSize - 1) / blockSize, 1, [&](size_t begin, size_t end)
+                               {
+                                   for (size_t j0 = begin * blockSize; j0 < std::min(rest, end * blockSize); j0 += blockSize)
+                                   {
+                                       size_t jb = std::min(blockSize, rest - j0);
+                                       blas::gemm(rest - j0, jb, kb,
+                                                  value_type(-1), l21 + j0, n,
+                                                  transposed + j0 * kb, kb,
+                                                  value_type(1), a + (k0 + kb + j0) * n + k0 + kb + j0, n, policy);
+                                   } });
+        }
+
+        // mirror L^T above the diagonal
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < j; i++)
+                a[j * n + i] = a[i * n + j];
+    }
+
+    /**
+     * @brief Factor columns [k0, k0 + kb) on and below the diagonal
+     *
+     * Inside the panel the columns are updated left-looking with axpy on
+     * contiguous columns, the columns left of the panel were already applied
+     * by the trailing updates.
+     *
+     * @param k0 First column of the panel
+     * @param kb Number of columns in the panel
+     */
+    template <Arithmetic T>
+    void Cholesky<T>::factorPanel(size_t k0, size_t kb)
+    {
+        size_t n = _factor.height();
+        value_type *a = _factor.data();
+        for (size_t j = k0; j < k0 + kb; j++)
+        {
+            value_type *column = a + j * n;
+            for (size_t p = k0; p < j; p++)
+                simd::axpy(-a[p * n + j], a + p * n + j, column + j, n - j);
+            if (!(column[j] > value_type(0)))
+                throw std::invalid_argument("Matrix must be positive definite");
+            column[j] = std::sqrt(column[j]);
+            simd::multiply(column + j + 1, value_type(1) / column[j], column + j + 1, n - j - 1);
+        }
+    }
+
+    /**
+     * @brief Overwrite B with A^-1 * B using the factor
+     *
+     * @param b Pointer to the n x nrhs column-major right-hand sides
+     * @param ldb Leading dimension of B
+     * @param nrhs Number of right-hand sides
+     */
+    template <Arithmetic T>
+    void Cholesky<T>::substitute(value_type *b, size_t ldb, size_t nrhs) const
+    {
+        size_t n = size();
+        blas::trsmLower(n, nrhs, _factor.data(), n, b, ldb);
+        blas::trsmUpper(n, nrhs, _factor.data(), n, b, ldb);
+    }
+
+    /**
+     * @brief Return the order of the factored matrix
+     *
+     * @return size_t Order of the matrix
+     */
+    template <Arithmetic T>
+    size_t Cholesky<T>::size() const
+    {
+        return _factor.height();
+    }
+
+    /**
+     * @brief Return L below and L^T above the diagonal packed into one matrix
+     *
+     * @return const Matrix<value_type>& Packed factor
+     */
+    template <Arithmetic T>
+    const Matrix<typename Cholesky<T>::value_type> &Cholesky<T>::packed() const
+    {
+        return _factor;
+    }
+
+    /**
+     * @brief Return the lower triangular factor L
+     *
+     * @return Matrix<value_type> L with zeros above the diagonal
+     */
+    template <Arithmetic T>
+    Matrix<typename Cholesky<T>::value_type> Cholesky<T>::lower() const
+    {
+        size_t n = size();
+        Matrix<value_type> result(_factor);
+        for (size_t j = 1; j < n; j++)
+            std::fill(result.data() + j * n, result.data() + j * n + j, value_type(0));
+        return result;
+    }
+
+    /**
+     * @brief Return the determinant of the factored matrix
+     *
+     * @return value_type Determinant
+     */
+    template <Arithmetic T>
+    typename Cholesky<T>::value_type Cholesky<T>::determinant() const
+    {
+        size_t n = size();
+        value_type result = 1;
+        for (size_t i = 0; i < n; i++)
+            result *= _factor.data()[i * n + i] * _factor.data()[i * n + i];
+        return result;
+    }
+
+    /**
+     * @brief Return the natural logarithm of the determinant
+     *
+     * The determinant of a positive definite matrix is positive, unlike
+     * determinant() this does not overflow for large matrices.
+     *
+     * @return value_type log(det)
+     */
+    template <Arithmetic T>
+    typename Cholesky<T>::value_type Cholesky<T>::logDeterminant() const
+    {
+        size_t n = size();
+        value_type result = 0;
+        for (size_t i = 0; i < n; i++)
+            result += std::log(_factor.data()[i * n + i]);
+        return 2 * result;
+    }
+
+    /**
+     * @brief Solve A * x = b with the stored factor
+     *
+     * @param b Right-hand side
+     * @return Vector<value_type> Solution
+     */
+    template <Arithmetic T>
+    Vector<typename Cholesky<T>::value_type> Cholesky<T>::solve(const VectorView<value_type> &b) const
+    {
+        Vector<value_type> x(b);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief Solve A * X = B for every column of B with the stored factor
+     *
+     * @param b Right-hand sides, one per column
+     * @return Matrix<value_type> Solutions, one per column
+     */
+    template <Arithmetic T>
+    Matrix<typename Cholesky<T>::value_type> Cholesky<T>::solve(const MatrixView<value_type> &b) const
+    {
+        Matrix<value_type> x(b);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief Overwrite b with the solution of A * x = b
+     *
+     * @param b Right-hand side, a vector or a view into a larger matrix, replaced by the solution
+     */
+    template <Arithmetic T>
+    void Cholesky<T>::solveInPlace(VectorView<value_type> b) const
+    {
+        if (b.size() != size())
+            throw std::invalid_argument("Vector size must match matrix height");
+        // the triangular solves need unit stride, rows and diagonals go through a copy
+        if (!b.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<value_type> x(b);
+            substitute(x.data(), size(), 1);
+            b = x;
+            return;
+        }
+        substitute(b.data(), size(), 1);
+    }
+
+    /**
+     * @brief Overwrite every column of B with the solution of A * X = B
+     *
+     * @param b Right-hand sides, a matrix or a block of one, replaced by the solutions
+     */
+    template <Arithmetic T>
+    void Cholesky<T>::solveInPlace(MatrixView<value_type> b) const
+    {
+        if (b.height() != size())
+            throw std::invalid_argument("Matrix heights must match");
+        substitute(b.data(), b.stride(), b.width());
+    }
+
+}
+
+#endif
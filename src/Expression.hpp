@@ -0,0 +1,817 @@
+#ifndef M42_EXPRESSION_HPP
+#define M42_EXPRESSION_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+#include "ThreadPool.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class VectorView;
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    /**
+     * @brief Lazy element-wise expression nodes
+     *
+     * Nodes are small value types: leaves refer to existing buffers and inner
+     * nodes hold their operands by value. Every node exposes size(), scalar
+     * access through operator[] and packet access through packet(); nothing
+     * is computed until the whole tree is evaluated in a single loop.
+     */
+    namespace expression
+    {
+
+        struct Add
+        {
+            template <typename V>
+            static void apply(V &out, const V &a, const V &b) { out = a + b; }
+        };
+
+        struct Subtract
+        {
+            template <typename V>
+            static void apply(V &out, const V &a, const V &b) { out = a - b; }
+        };
+
+        struct Multiply
+        {
+            template <typename V>
+            static void apply(V &out, const V &a, const V &b) { out = a * b; }
+        };
+
+        struct Divide
+        {
+            template <typename V>
+            static void apply(V &out, const V &a, const V &b) { out = a / b; }
+        };
+
+        struct Negate
+        {
+            template <typename V>
+            static void apply(V &out, const V &a) { out = -a; }
+        };
+
+        /**
+         * @brief Reference to memory with a constant stride
+         *
+         * packet() is only valid on unit-stride leaves, evaluation falls back
+         * to operator[] when any leaf is strided.
+         *
+         * @tparam T Type of elements
+         */
+        template <Arithmetic T>
+        class Leaf
+        {
+        private:
+            const T *_data;
+            size_t _size;
+            size_t _stride;
+
+        public:
+            using value_type = T;
+
+            Leaf(const T *data, size_t size, size_t stride = 1) : _data(data), _size(size), _stride(stride) {}
+
+            size_t size() const { return _size; }
+            bool contiguous() const { return _stride == 1; }
+            T operator[](size_t i) const { return _data[i * _stride]; }
+            void packet(size_t i, simd::Packet<T> &out) const { out = simd::packet(_data + i); }
+        };
+
+        /**
+         * @brief Reference to a column-major matrix whose columns may be padded
+         *
+         * Elements are numbered column by column. Without padding the matrix
+         * is one flat contiguous range; with padding the expression is
+         * evaluated one column at a time through column().
+         *
+         * @tparam T Type of elements
+         */
+        template <Arithmetic T>
+        class MatrixLeaf
+        {
+        private:
+            const T *_data;
+            size_t _width;
+            size_t _height;
+            size_t _stride;
+
+        public:
+            using value_type = T;
+
+            MatrixLeaf(const T *data, size_t width, size_t height, size_t stride)
+                : _data(data), _width(width), _height(height), _stride(stride) {}
+
+            size_t size() const { return _width * _height; }
+            bool contiguous() const { return _stride == _height; }
+            T operator[](size_t i) const { return contiguous() ? _data[i] : _data[i / _height * _stride + i % _height]; }
+            void packet(size_t i, simd::Packet<T> &out) const { out = simd::packet(_data + i); }
+            Leaf<T> column(size_t j) const { return Leaf<T>(_data + j * _stride, _height); }
+        };
+
+        /**
+         * @brief Element-wise binary operation of two expressions
+         */
+        template <typename L, typename R, typename Op>
+        class Binary
+        {
+        private:
+            L _left;
+            R _right;
+
+        public:
+            using value_type = typename L::value_type;
+
+            Binary(const L &left, const R &right, Op) : _left(left), _right(right) {}
+
+            size_t size() const { return _left.size(); }
+            bool contiguous() const { return _left.contiguous() && _right.contiguous(); }
+
+            value_type operator[](size_t i) const
+            {
+                value_type out;
+                Op::apply(out, _left[i], _right[i]);
+                return out;
+            }
+
+            void packet(size_t i, simd::Packet<value_type> &out) const
+            {
+                simd::Packet<value_type> left;
+                simd::Packet<value_type> right;
+                _left.packet(i, left);
+                _right.packet(i, right);
+                Op::apply(out, left, right);
+            }
+
+            auto column(size_t j) const
+            {
+                return Binary<decltype(_left.column(j)), decltype(_right.column(j)), Op>(_left.column(j), _right.column(j), Op{});
+            }
+        };
+
+        /**
+         * @brief Element-wise operation of an expression and a scalar
+         */
+        template <typename E, typename Op>
+        class Scalar
+        {
+        public:
+            using value_type = typename E::value_type;
+
+        private:
+            E _expression;
+            value_type _scalar;
+
+        public:
+            Scalar(const E &expression, value_type scalar, Op) : _expression(expression), _scalar(scalar) {}
+
+            size_t size() const { return _expression.size(); }
+            bool contiguous() const { return _expression.contiguous(); }
+
+            value_type operator[](size_t i) const
+            {
+                value_type out;
+                Op::apply(out, _expression[i], _scalar);
+                return out;
+            }
+
+            void packet(size_t i, simd::Packet<value_type> &out) const
+            {
+                simd::Packet<value_type> value;
+                simd::Packet<value_type> scalar = simd::Packet<value_type>{} + _scalar;
+                _expression.packet(i, value);
+                Op::apply(out, value, scalar);
+            }
+
+            auto column(size_t j) const
+            {
+                return Scalar<decltype(_expression.column(j)), Op>(_expression.column(j), _scalar, Op{});
+            }
+        };
+
+        /**
+         * @brief Element-wise unary operation of an expression
+         */
+        template <typename E, typename Op>
+        class Unary
+        {
+        private:
+            E _expression;
+
+        public:
+            using value_type = typename E::value_type;
+
+            Unary(const E &expression, Op) : _expression(expression) {}
+
+            size_t size() const { return _expression.size(); }
+            bool contiguous() const { return _expression.contiguous(); }
+
+            value_type operator[](size_t i) const
+            {
+                value_type out;
+                Op::apply(out, _expression[i]);
+                return out;
+            }
+
+            void packet(size_t i, simd::Packet<value_type> &out) const
+            {
+                simd::Packet<value_type> value;
+                _expression.packet(i, value);
+                Op::apply(out, value);
+            }
+
+            auto column(size_t j) const
+            {
+                return Unary<decltype(_expression.column(j)), Op>(_expression.column(j), Op{});
+            }
+        };
+
+        /**
+         * @brief Evaluate elements [begin, end) of an expression into memory in a single pass
+         *
+         * The destination may alias any leaf of the expression: element i is
+         * only computed from elements i of the operands. Packets are used
+         * only when the destination and every leaf have unit stride.
+         *
+         * @param destination Pointer to the element 0 of the destination
+         * @param stride Distance between two destination elements
+         * @param expression Expression to evaluate
+         * @param begin First element to evaluate
+         * @param end One past the last element to evaluate
+         */
+        template <typename E>
+        M42_SIMD_DISPATCH void evaluate(typename E::value_type *destination, size_t stride, const E &expression, size_t begin, size_t end)
+        {
+            using T = typename E::value_type;
+            size_t i = begin;
+            if (stride != 1 || !expression.contiguous())
+            {
+                for (; i < end; i++)
+                    destination[i * stride] = expression[i];
+                return;
+            }
+            if constexpr (simd::Vectorizable<T>)
+                for (; i + simd::lanes<T> <= end; i += simd::lanes<T>)
+                {
+                    simd::Packet<T> value;
+                    expression.packet(i, value);
+                    simd::packet(destination + i) = value;
+                }
+            for (; i < end; i++)
+                destination[i] = expression[i];
+        }
+
+        /**
+         * @brief Evaluate a whole expression, in chunks on the shared pool when it is long
+         *
+         * @param destination Pointer to the first element to write
+         * @param stride Distance between two destination elements
+         * @param expression Expression to evaluate
+         * @param policy Execution policy
+         */
+        template <typename E>
+        void evaluate(typename E::value_type *destination, size_t stride, const E &expression, Execution policy)
+        {
+            parallel::forRange(policy, expression.size(), parallel::grainSize, [&](size_t begin, size_t end)
+                               { evaluate(destination, stride, expression, begin, end); });
+        }
+
+        /**
+         * @brief Dot product of elements [begin, end) of two expressions without evaluating them
+         */
+        template <typename L, typename R>
+        M42_SIMD_DISPATCH typename L::value_type dot(const L &left, const R &right, size_t begin, size_t end)
+        {
+            using T = typename L::value_type;
+            T result = 0;
+            size_t i = begin;
+            if constexpr (simd::Vectorizable<T>)
+                if (left.contiguous() && right.contiguous())
+                {
+                    simd::Packet<T> acc = {};
+                    for (; i + simd::lanes<T> <= end; i += simd::lanes<T>)
+                    {
+                        simd::Packet<T> a;
+                        simd::Packet<T> b;
+                        left.packet(i, a);
+                        right.packet(i, b);
+                        acc += a * b;
+                    }
+                    result = simd::reduceAdd<T>(acc);
+                }
+            for (; i < end; i++)
+                result += left[i] * right[i];
+            return result;
+        }
+
+        /**
+         * @brief Dot product of two expressions, partial sums computed on the shared pool when they are long
+         */
+        template <typename L, typename R>
+        typename L::value_type dot(const L &left, const R &right, Execution policy)
+        {
+            using T = typename L::value_type;
+            return parallel::reduce(
+                policy, left.size(), parallel::grainSize, T(0),
+                [&](size_t begin, size_t end)
+                { return dot(left, right, begin, end); },
+                [](T a, T b)
+                { return a + b; });
+        }
+
+    }
+
+    /**
+     * @brief Lazy vector-valued expression
+     *
+     * Produced by arithmetic on vectors and evaluated only when assigned to a
+     * VectorView, Vector or converted to a Vector.
+     *
+     * The expression refers to its operands without copying them, so it must
+     * not outlive them: never keep one with auto past the end of the
+     * statement that built it from temporaries. Store the result in a Vector
+     * or call eval() instead.
+     *
+     * @tparam E Expression tree
+     */
+    template <typename E>
+    class VectorExpression
+    {
+    private:
+        E _expression;
+
+    public:
+        using value_type = typename E::value_type;
+
+        explicit VectorExpression(const E &expression) : _expression(expression) {}
+
+        size_t size() const { return _expression.size(); }
+        value_type operator[](size_t i) const { return _expression[i]; }
+        const E &expression() const { return _expression; }
+
+        /**
+         * @brief Evaluate the expression into memory
+         *
+         * @param destination Pointer to the first element to write
+         * @param stride Distance between two destination elements
+         * @param policy Execution policy
+         */
+        void evaluateTo(value_type *destination, size_t stride = 1, Execution policy = Execution::Parallel) const
+        {
+            expression::evaluate(destination, stride, _expression, policy);
+        }
+
+        /**
+         * @brief Evaluate the expression into a new vector
+         *
+         * @return Vector<value_type> Result of the expression
+         */
+        operator Vector<value_type>() const
+        {
+            Vector<value_type> result(size());
+            evaluateTo(result.data());
+            return result;
+        }
+
+        /**
+         * @brief Evaluate the expression into a new vector with another allocator
+         *
+         * @return Vector<value_type, Allocator> Result of the expression
+         */
+        template <typename Allocator>
+        operator Vector<value_type, Allocator>() const
+        {
+            Vector<value_type, Allocator> result(size());
+            evaluateTo(result.data());
+            return result;
+        }
+
+        /**
+         * @brief Evaluate the expression into a new vector
+         *
+         * Gives access to the members of Vector, such as (a + b).eval().norm().
+         *
+         * @return Vector<value_type> Result of the expression
+         */
+        Vector<value_type> eval() const
+        {
+            return *this;
+        }
+
+        /**
+         * @brief Return a string representation of the evaluated vector
+         *
+         * @return std::string String representation of the vector
+         */
+        operator std::string() const
+        {
+            return static_cast<std::string>(eval());
+        }
+    };
+
+    /**
+     * @brief Lazy matrix-valued element-wise expression
+     *
+     * Matrices are stored in column-major order, so element-wise matrix
+     * expressions are evaluated over the flat buffer, or column by column
+     * when an operand is a block or has padded columns.
+     *
+     * The expression refers to its operands without copying them, so it must
+     * not outlive them: never keep one with auto past the end of the
+     * statement that built it from temporaries. Store the result in a Matrix
+     * or call eval() instead.
+     *
+     * @tparam E Expression tree
+     */
+    template <typename E>
+    class MatrixExpression
+    {
+    private:
+        E _expression;
+        size_t _width;
+        size_t _height;
+
+    public:
+        using value_type = typename E::value_type;
+
+        MatrixExpression(const E &expression, size_t width, size_t height)
+            : _expression(expression), _width(width), _height(height) {}
+
+        size_t width() const { return _width; }
+        size_t height() const { return _height; }
+        const E &expression() const { return _expression; }
+
+        /**
+         * @brief Evaluate the expression into column-major memory
+         *
+         * @param destination Pointer to the first element of the destination
+         * @param stride Leading dimension of the destination, at least height()
+         * @param policy Execution policy
+         */
+        void evaluateTo(value_type *destination, size_t stride, Execution policy = Execution::Parallel) const
+        {
+            if (stride == _height && _expression.contiguous())
+            {
+                expression::evaluate(destination, size_t(1), _expression, policy);
+                return;
+            }
+            parallel::forRange(policy, _width, parallel::grainSize / std::max<size_t>(_height, 1), [&](size_t begin, size_t end)
+                               {
+                                   for (size_t j = begin; j < end; j++)
+                                       expression::evaluate(destination + j * stride, size_t(1), _expression.column(j), 0, _height); });
+        }
+
+        /**
+         * @brief Evaluate the expression into contiguous column-major memory
+         *
+         * @param destination Pointer to width() * height() elements
+         * @param policy Execution policy
+         */
+        void evaluateTo(value_type *destination, Execution policy = Execution::Parallel) const
+        {
+            evaluateTo(destination, _height, policy);
+        }
+
+        /**
+         * @brief Evaluate the expression into a new matrix
+         *
+         * @return Matrix<value_type> Result of the expression
+         */
+        operator Matrix<value_type>() const
+        {
+            Matrix<value_type> result(_width, _height);
+            evaluateTo(result.data());
+            return result;
+        }
+
+        /**
+         * @brief Evaluate the expression into a new matrix with another allocator
+         *
+         * @return Matrix<value_type, Allocator> Result of the expression
+         */
+        template <typename Allocator>
+        operator Matrix<value_type, Allocator>() const
+        {
+            Matrix<value_type, Allocator> result(_width, _height);
+            evaluateTo(result.data());
+            return result;
+        }
+
+        /**
+         * @brief Evaluate the expression into a new matrix
+         *
+         * Gives access to the members of Matrix, such as (a + b).eval().transpose().
+         *
+         * @return Matrix<value_type> Result of the expression
+         */
+        Matrix<value_type> eval() const
+        {
+            return *this;
+        }
+
+        /**
+         * @brief Return a string representation of the evaluated matrix
+         *
+         * @return std::string String representation of the matrix
+         */
+        operator std::string() const
+        {
+            return static_cast<std::string>(eval());
+        }
+    };
+
+    /**
+     * @brief fmt::formatter specialization for vector expressions
+     *
+     * @param v Expression to evaluate and format
+     * @return auto Evaluated vector formatted as a string
+     */
+    template <typename E>
+    auto format_as(const VectorExpression<E> &v)
+    {
+        return static_cast<std::string>(v);
+    }
+
+    /**
+     * @brief Output stream operator for vector expressions
+     *
+     * @param os Output stream
+     * @param v Expression to evaluate and output
+     * @return std::ostream& Output stream
+     */
+    template <typename E>
+    std::ostream &operator<<(std::ostream &os, const VectorExpression<E> &v)
+    {
+        return os << static_cast<std::string>(v);
+    }
+
+    /**
+     * @brief fmt::formatter specialization for matrix expressions
+     *
+     * @param m Expression to evaluate and format
+     * @return auto Evaluated matrix formatted as a string
+     */
+    template <typename E>
+    auto format_as(const MatrixExpression<E> &m)
+    {
+        return static_cast<std::string>(m);
+    }
+
+    /**
+     * @brief Output stream operator for matrix expressions
+     *
+     * @param os Output stream
+     * @param m Expression to evaluate and output
+     * @return std::ostream& Output stream
+     */
+    template <typename E>
+    std::ostream &operator<<(std::ostream &os, const MatrixExpression<E> &m)
+    {
+        return os << static_cast<std::string>(m);
+    }
+
+    template <typename A>
+    inline constexpr bool isVectorExpression = false;
+
+    template <typename E>
+    inline constexpr bool isVectorExpression<VectorExpression<E>> = true;
+
+    template <typename A>
+    inline constexpr bool isMatrixExpression = false;
+
+    template <typename E>
+    inline constexpr bool isMatrixExpression<MatrixExpression<E>> = true;
+
+    /**
+     * @brief Vectors, vector views and lazy vector expressions
+     */
+    template <typename A>
+    concept VectorOperand = isVectorExpression<A> ||
+                            (requires { typename A::value_type; } &&
+                             std::derived_from<A, VectorView<typename A::value_type>>);
+
+    /**
+     * @brief Matrices with any allocator, matrix views and lazy matrix expressions
+     */
+    template <typename A>
+    concept MatrixOperand = isMatrixExpression<A> ||
+                            (requires { typename A::value_type; } &&
+                             std::derived_from<A, MatrixView<typename A::value_type>>);
+
+    namespace expression
+    {
+
+        /**
+         * @brief Expression tree of a vector or matrix operand
+         */
+        template <typename A>
+        auto of(const A &operand)
+        {
+            if constexpr (std::derived_from<A, VectorView<typename A::value_type>>)
+                return Leaf<typename A::value_type>(operand.data(), operand.size(), operand.stride());
+            else if constexpr (std::derived_from<A, MatrixView<typename A::value_type>>)
+                return MatrixLeaf<typename A::value_type>(operand.data(), operand.width(), operand.height(), operand.stride());
+            else
+                return operand.expression();
+        }
+
+        template <VectorOperand A, VectorOperand B>
+        void checkSameSize(const A &a, const B &b)
+        {
+            if (a.size() != b.size())
+                throw std::invalid_argument("Vectors must be of the same size");
+        }
+
+        template <MatrixOperand A, MatrixOperand B>
+        void checkSameSize(const A &a, const B &b)
+        {
+            if (a.width() != b.width() || a.height() != b.height())
+                throw std::invalid_argument("Matrices must have the same size");
+        }
+
+    }
+
+    /**
+     * @brief Add two vectors
+     *
+     * @param a First vector
+     * @param b Vector to add
+     * @return VectorExpression Lazy sum
+     */
+    template <VectorOperand A, VectorOperand B>
+        requires std::same_as<typename A::value_type, typename B::value_type>
+    auto operator+(const A &a, const B &b)
+    {
+        expression::checkSameSize(a, b);
+        return VectorExpression(expression::Binary(expression::of(a), expression::of(b), expression::Add{}));
+    }
+
+    /**
+     * @brief Subtract two vectors
+     *
+     * @param a First vector
+     * @param b Vector to subtract
+     * @return VectorExpression Lazy difference
+     */
+    template <VectorOperand A, VectorOperand B>
+        requires std::same_as<typename A::value_type, typename B::value_type>
+    auto operator-(const A &a, const B &b)
+    {
+        expression::checkSameSize(a, b);
+        return VectorExpression(expression::Binary(expression::of(a), expression::of(b), expression::Subtract{}));
+    }
+
+    /**
+     * @brief Multiply a vector by a scalar
+     *
+     * @param a Vector
+     * @param scalar Scalar to multiply by
+     * @return VectorExpression Lazy product
+     */
+    template <VectorOperand A>
+    auto operator*(const A &a, typename A::value_type scalar)
+    {
+        return VectorExpression(expression::Scalar(expression::of(a), scalar, expression::Multiply{}));
+    }
+
+    /**
+     * @brief Divide a vector by a scalar
+     *
+     * @param a Vector
+     * @param scalar Scalar to divide by
+     * @return VectorExpression Lazy quotient
+     */
+    template <VectorOperand A>
+    auto operator/(const A &a, typename A::value_type scalar)
+    {
+        return VectorExpression(expression::Scalar(expression::of(a), scalar, expression::Divide{}));
+    }
+
+    /**
+     * @brief Negate a vector
+     *
+     * @param a Vector to negate
+     * @return VectorExpression Lazy negation
+     */
+    template <VectorOperand A>
+    auto operator-(const A &a)
+    {
+        return VectorExpression(expression::Unary(expression::of(a), expression::Negate{}));
+    }
+
+    /**
+     * @brief Dot product of two vectors
+     *
+     * @param a First vector
+     * @param b Second vector
+     * @return value_type Dot product
+     */
+    template <VectorOperand A, VectorOperand B>
+        requires std::same_as<typename A::value_type, typename B::value_type>
+    typename A::value_type operator*(const A &a, const B &b)
+    {
+        expression::checkSameSize(a, b);
+        return expression::dot(expression::of(a), expression::of(b), Execution::Parallel);
+    }
+
+    /**
+     * @brief Add two matrices
+     *
+     * @param a First matrix
+     * @param b Matrix to add
+     * @return MatrixExpression Lazy sum
+     */
+    template <MatrixOperand A, MatrixOperand B>
+        requires std::same_as<typename A::value_type, typename B::value_type>
+    auto operator+(const A &a, const B &b)
+    {
+        expression::checkSameSize(a, b);
+        return MatrixExpression(expression::Binary(expression::of(a), expression::of(b), expression::Add{}), a.width(), a.height());
+    }
+
+    /**
+     * @brief Subtract two matrices
+     *
+     * @param a First matrix
+     * @param b Matrix to subtract
+     * @return MatrixExpression Lazy difference
+     */
+    template <MatrixOperand A, MatrixOperand B>
+        requires std::same_as<typename A::value_type, typename B::value_type>
+    auto operator-(const A &a, const B &b)
+    {
+        expression::checkSameSize(a, b);
+        return MatrixExpression(expression::Binary(expression::of(a), expression::of(b), expression::Subtract{}), a.width(), a.height());
+    }
+
+    /**
+     * @brief Multiply a matrix by a scalar
+     *
+     * @param a Matrix
+     * @param scalar Scalar to multiply by
+     * @return MatrixExpression Lazy product
+     */
+    template <MatrixOperand A>
+    auto operator*(const A &a, typename A::value_type scalar)
+    {
+        return MatrixExpression(expression::Scalar(expression::of(a), scalar, expression::Multiply{}), a.width(), a.height());
+    }
+
+    /**
+     * @brief Negate a matrix
+     *
+     * @param a Matrix to negate
+     * @return MatrixExpression Lazy negation
+     */
+    template <MatrixOperand A>
+    auto operator-(const A &a)
+    {
+        return MatrixExpression(expression::Unary(expression::of(a), expression::Negate{}), a.width(), a.height());
+    }
+
+    /**
+     * @brief Multiply a matrix expression by a vector
+     *
+     * The expression is evaluated first, the product itself is not element-wise.
+     *
+     * @param a Matrix expression
+     * @param vector Vector to multiply by
+     * @return Vector<value_type> Result of multiplication
+     */
+    template <typename E>
+    Vector<typename E::value_type> operator*(const MatrixExpression<E> &a, const VectorView<typename E::value_type> &vector)
+    {
+        return Matrix<typename E::value_type>(a) * vector;
+    }
+
+    /**
+     * @brief Multiply a matrix expression by a matrix
+     *
+     * The expression is evaluated first, the product itself is not element-wise.
+     *
+     * @param a Matrix expression
+     * @param other Matrix or block to multiply by
+     * @return Matrix<value_type> Result of multiplication
+     */
+    template <typename E>
+    Matrix<typename E::value_type> operator*(const MatrixExpression<E> &a, const MatrixView<typename E::value_type> &other)
+    {
+        return Matrix<typename E::value_type>(a) * other;
+    }
+
+}
+
+#endif
@@ -0,0 +1,469 @@
+#ifndef M42_FIXED_MATRIX_HPP
+#define M42_FIXED_MATRIX_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "FixedVector.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    /**
+     * @brief Matrix with dimensions known at compile time and inline storage
+     *
+     * Stored in column-major order like Matrix. Products check their shapes
+     * at compile time and are fully unrolled, which suits the 3x3 and 4x4
+     * transforms of graphics code. view() exposes the storage to the dynamic
+     * algorithms such as the factorizations.
+     *
+     * @tparam T Type of matrix components
+     * @tparam W Width of the matrix
+     * @tparam H Height of the matrix
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    class FixedMatrix
+    {
+    private:
+        T _data[W * H]{};
+
+    public:
+        using value_type = T;
+
+        constexpr FixedMatrix() = default;
+        constexpr FixedMatrix(const T (&rows)[H][W]);
+        explicit FixedMatrix(const MatrixView<T> &matrix);
+
+        static constexpr size_t width();
+        static constexpr size_t height();
+        static constexpr bool isSquare();
+        static constexpr FixedMatrix identity()
+            requires(W == H);
+        constexpr T *data();
+        constexpr const T *data() const;
+        MatrixView<T> view();
+        const MatrixView<T> view() const;
+        constexpr FixedVector<T, H> column(size_t i) const;
+        constexpr FixedVector<T, W> row(size_t i) const;
+        constexpr T trace() const
+            requires(W == H);
+        constexpr FixedMatrix<T, H, W> transpose() const;
+
+        constexpr T &operator()(size_t column, size_t row);
+        constexpr const T &operator()(size_t column, size_t row) const;
+        constexpr bool operator==(const FixedMatrix &other) const;
+        constexpr FixedMatrix &operator+=(const FixedMatrix &other);
+        constexpr FixedMatrix &operator-=(const FixedMatrix &other);
+        constexpr FixedMatrix &operator*=(T scalar);
+        operator std::string() const;
+    };
+
+    /**
+     * @brief Construct a fixed matrix from rows written in row-major order
+     *
+     * The array bounds are the shape of the matrix, so a wrong number of
+     * rows or columns does not compile.
+     *
+     * @param rows H rows of W elements
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H>::FixedMatrix(const T (&rows)[H][W])
+    {
+        // row-major order to column-major order
+        fixed::unroll<W>([&](size_t j)
+                         { fixed::unroll<H>([&](size_t i)
+                                            { _data[j * H + i] = rows[i][j]; }); });
+    }
+
+    /**
+     * @brief Construct a fixed matrix from a dynamic matrix of the same shape
+     *
+     * @param matrix Matrix or block to copy
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    FixedMatrix<T, W, H>::FixedMatrix(const MatrixView<T> &matrix)
+    {
+        if (matrix.width() != W || matrix.height() != H)
+            throw std::invalid_argument("Matrix dimensions must match the fixed dimensions");
+        fixed::unroll<W>([&](size_t j)
+                         { fixed::unroll<H>([&](size_t i)
+                                            { _data[j * H + i] = matrix.data()[j * matrix.stride() + i]; }); });
+    }
+
+    /**
+     * @brief Return the width of the matrix
+     *
+     * @return size_t W
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr size_t FixedMatrix<T, W, H>::width()
+    {
+        return W;
+    }
+
+    /**
+     * @brief Return the height of the matrix
+     *
+     * @return size_t H
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr size_t FixedMatrix<T, W, H>::height()
+    {
+        return H;
+    }
+
+    /**
+     * @brief Return whether the matrix is square
+     *
+     * @return bool W == H
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr bool FixedMatrix<T, W, H>::isSquare()
+    {
+        return W == H;
+    }
+
+    /**
+     * @brief Return the identity matrix
+     *
+     * @return FixedMatrix Identity
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H> FixedMatrix<T, W, H>::identity()
+        requires(W == H)
+    {
+        FixedMatrix result;
+        fixed::unroll<W>([&](size_t i)
+                         { result._data[i * H + i] = 1; });
+        return result;
+    }
+
+    /**
+     * @brief Return a pointer to the first element
+     *
+     * @return T* Pointer to the inline storage
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr T *FixedMatrix<T, W, H>::data()
+    {
+        return _data;
+    }
+
+    /**
+     * @brief Return a const pointer to the first element
+     *
+     * @return const T* Pointer to the inline storage
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr const T *FixedMatrix<T, W, H>::data() const
+    {
+        return _data;
+    }
+
+    /**
+     * @brief Return a dynamic view of the matrix
+     *
+     * @return MatrixView<T> View sharing the inline storage
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    MatrixView<T> FixedMatrix<T, W, H>::view()
+    {
+        return MatrixView<T>(_data, W, H);
+    }
+
+    /**
+     * @brief Return a dynamic view of the matrix
+     *
+     * @return const MatrixView<T> View sharing the inline storage
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    const MatrixView<T> FixedMatrix<T, W, H>::view() const
+    {
+        return MatrixView<T>(const_cast<T *>(_data), W, H);
+    }
+
+    /**
+     * @brief Return an i-th column of the matrix
+     *
+     * @param i Index of the column, not checked
+     * @return FixedVector<T, H> Copy of the column
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedVector<T, H> FixedMatrix<T, W, H>::column(size_t i) const
+    {
+        FixedVector<T, H> result;
+        fixed::unroll<H>([&](size_t r)
+                         { result[r] = _data[i * H + r]; });
+        return result;
+    }
+
+    /**
+     * @brief Return an i-th row of the matrix
+     *
+     * @param i Index of the row, not checked
+     * @return FixedVector<T, W> Copy of the row
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedVector<T, W> FixedMatrix<T, W, H>::row(size_t i) const
+    {
+        FixedVector<T, W> result;
+        fixed::unroll<W>([&](size_t c)
+                         { result[c] = _data[c * H + i]; });
+        return result;
+    }
+
+    /**
+     * @brief Return the trace of the matrix
+     *
+     * @return T Trace of the matrix
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr T FixedMatrix<T, W, H>::trace() const
+        requires(W == H)
+    {
+        T result = 0;
+        fixed::unroll<W>([&](size_t i)
+                         { result += _data[i * H + i]; });
+        return result;
+    }
+
+    /**
+     * @brief Return the transpose of the matrix
+     *
+     * @return FixedMatrix<T, H, W> Transpose of the matrix
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, H, W> FixedMatrix<T, W, H>::transpose() const
+    {
+        FixedMatrix<T, H, W> result;
+        fixed::unroll<W>([&](size_t j)
+                         { fixed::unroll<H>([&](size_t i)
+                                            { result(i, j) = _data[j * H + i]; }); });
+        return result;
+    }
+
+    /**
+     * @brief Return the element in the given column and row
+     *
+     * @param column Index of the column, not checked
+     * @param row Index of the row, not checked
+     * @return T& Element
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr T &FixedMatrix<T, W, H>::operator()(size_t column, size_t row)
+    {
+        return _data[column * H + row];
+    }
+
+    /**
+     * @brief Return the element in the given column and row
+     *
+     * @param column Index of the column, not checked
+     * @param row Index of the row, not checked
+     * @return const T& Element
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr const T &FixedMatrix<T, W, H>::operator()(size_t column, size_t row) const
+    {
+        return _data[column * H + row];
+    }
+
+    /**
+     * @brief Return whether the matrix is equal to another matrix
+     *
+     * @param other Matrix to compare to
+     * @return bool Whether all elements are equal
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr bool FixedMatrix<T, W, H>::operator==(const FixedMatrix &other) const
+    {
+        bool equal = true;
+        fixed::unroll<W * H>([&](size_t i)
+                             { equal = equal && _data[i] == other._data[i]; });
+        return equal;
+    }
+
+    /**
+     * @brief Add another matrix to the matrix
+     *
+     * @param other Matrix to add
+     * @return FixedMatrix& Result of addition
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H> &FixedMatrix<T, W, H>::operator+=(const FixedMatrix &other)
+    {
+        fixed::unroll<W * H>([&](size_t i)
+                             { _data[i] += other._data[i]; });
+        return *this;
+    }
+
+    /**
+     * @brief Subtract another matrix from the matrix
+     *
+     * @param other Matrix to subtract
+     * @return FixedMatrix& Result of subtraction
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H> &FixedMatrix<T, W, H>::operator-=(const FixedMatrix &other)
+    {
+        fixed::unroll<W * H>([&](size_t i)
+                             { _data[i] -= other._data[i]; });
+        return *this;
+    }
+
+    /**
+     * @brief Multiply the matrix by a scalar
+     *
+     * @param scalar Scalar to multiply by
+     * @return FixedMatrix& Result of multiplication
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H> &FixedMatrix<T, W, H>::operator*=(T scalar)
+    {
+        fixed::unroll<W * H>([&](size_t i)
+                             { _data[i] *= scalar; });
+        return *this;
+    }
+
+    /**
+     * @brief Return a string representation of the matrix
+     *
+     * @return std::string String representation of the matrix
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    FixedMatrix<T, W, H>::operator std::string() const
+    {
+        return static_cast<std::string>(view());
+    }
+
+    /**
+     * @brief Add two matrices
+     *
+     * @param a First matrix
+     * @param b Matrix to add
+     * @return FixedMatrix<T, W, H> Sum
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H> operator+(FixedMatrix<T, W, H> a, const FixedMatrix<T, W, H> &b)
+    {
+        return a += b;
+    }
+
+    /**
+     * @brief Subtract two matrices
+     *
+     * @param a First matrix
+     * @param b Matrix to subtract
+     * @return FixedMatrix<T, W, H> Difference
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H> operator-(FixedMatrix<T, W, H> a, const FixedMatrix<T, W, H> &b)
+    {
+        return a -= b;
+    }
+
+    /**
+     * @brief Multiply a matrix by a scalar
+     *
+     * @param a Matrix
+     * @param scalar Scalar to multiply by
+     * @return FixedMatrix<T, W, H> Product
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedMatrix<T, W, H> operator*(FixedMatrix<T, W, H> a, std::type_identity_t<T> scalar)
+    {
+        return a *= scalar;
+    }
+
+    /**
+     * @brief Multiply two matrices, the inner dimensions must agree at compile time
+     *
+     * Each result column is a combination of the columns of a, so the
+     * unrolled loop runs over contiguous columns.
+     *
+     * @param a Left matrix, K x H
+     * @param b Right matrix, W x K
+     * @return FixedMatrix<T, W, H> Product
+     */
+    template <Arithmetic T, size_t W, size_t K, size_t H>
+    constexpr FixedMatrix<T, W, H> operator*(const FixedMatrix<T, K, H> &a, const FixedMatrix<T, W, K> &b)
+    {
+        FixedMatrix<T, W, H> result;
+        // three nested unrolls exceed the inliner's budget, the constant outer loop is unrolled anyway
+        for (size_t j = 0; j < W; j++)
+            fixed::unroll<K>([&](size_t k)
+                             { fixed::unroll<H>([&](size_t i)
+                                                { result(j, i) += a(k, i) * b(j, k); }); });
+        return result;
+    }
+
+    /**
+     * @brief Multiply a matrix by a column vector
+     *
+     * @param a Matrix
+     * @param vector Vector of W elements
+     * @return FixedVector<T, H> Product
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedVector<T, H> operator*(const FixedMatrix<T, W, H> &a, const FixedVector<T, W> &vector)
+    {
+        FixedVector<T, H> result;
+        fixed::unroll<W>([&](size_t j)
+                         { fixed::unroll<H>([&](size_t i)
+                                            { result[i] += a(j, i) * vector[j]; }); });
+        return result;
+    }
+
+    /**
+     * @brief Multiply a row vector by a matrix, x^T * A
+     *
+     * @param vector Vector of H elements
+     * @param a Matrix
+     * @return FixedVector<T, W> Product
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    constexpr FixedVector<T, W> operator*(const FixedVector<T, H> &vector, const FixedMatrix<T, W, H> &a)
+    {
+        FixedVector<T, W> result;
+        fixed::unroll<W>([&](size_t j)
+                         { result[j] = a.column(j) * vector; });
+        return result;
+    }
+
+    /**
+     * @brief fmt::formatter specialization for FixedMatrix
+     *
+     * @param m Matrix to format
+     * @return auto Matrix formatted as a string
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    auto format_as(const FixedMatrix<T, W, H> &m)
+    {
+        return static_cast<std::string>(m);
+    }
+
+    /**
+     * @brief Output stream operator for FixedMatrix
+     *
+     * @param os Output stream
+     * @param m Matrix to output
+     * @return std::ostream& Output stream
+     */
+    template <Arithmetic T, size_t W, size_t H>
+    std::ostream &operator<<(std::ostream &os, const FixedMatrix<T, W, H> &m)
+    {
+        return os << static_cast<std::string>(m);
+    }
+
+}
+
+#endif
@@ -0,0 +1,418 @@
+#ifndef M42_FIXED_VECTOR_HPP
+#define M42_FIXED_VECTOR_HPP
+
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "Vector.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class VectorView;
+
+    namespace fixed
+    {
+
+        /**
+         * @brief Call f(0), f(1), ..., f(N - 1) as a fully unrolled sequence
+         *
+         * @tparam N Number of calls, known at compile time
+         * @param f Callable taking the index
+         */
+        template <size_t N, typename F>
+        constexpr void unroll(F &&f)
+        {
+            [&]<size_t... I>(std::index_sequence<I...>)
+            {
+                (f(I), ...);
+            }(std::make_index_sequence<N>{});
+        }
+
+    }
+
+    /**
+     * @brief Vector with a size known at compile time and inline storage
+     *
+     * Meant for small vectors such as 3D points: nothing is allocated, every
+     * operation is unrolled and constexpr, and sizes are checked by the
+     * compiler. view() exposes the storage to the dynamic algorithms.
+     *
+     * @tparam T Type of vector elements
+     * @tparam N Number of elements
+     */
+    template <Arithmetic T, size_t N>
+    class FixedVector
+    {
+    private:
+        T _data[N]{};
+
+    public:
+        using value_type = T;
+
+        constexpr FixedVector() = default;
+        template <std::convertible_to<T>... Args>
+            requires(sizeof...(Args) == N)
+        constexpr FixedVector(Args... args);
+        explicit FixedVector(const VectorView<T> &v);
+
+        static constexpr size_t size();
+        constexpr T *data();
+        constexpr const T *data() const;
+        VectorView<T> view();
+        const VectorView<T> view() const;
+        constexpr T normSquared() const;
+        double norm() const;
+
+        constexpr T &operator[](size_t index);
+        constexpr const T &operator[](size_t index) const;
+        constexpr bool operator==(const FixedVector &other) const;
+        constexpr FixedVector &operator+=(const FixedVector &other);
+        constexpr FixedVector &operator-=(const FixedVector &other);
+        constexpr FixedVector &operator*=(T scalar);
+        constexpr FixedVector &operator/=(T scalar);
+        operator std::string() const;
+    };
+
+    /**
+     * @brief Construct a fixed vector from exactly N elements
+     *
+     * @param args Elements of the vector
+     */
+    template <Arithmetic T, size_t N>
+    template <std::convertible_to<T>... Args>
+        requires(sizeof...(Args) == N)
+    constexpr FixedVector<T, N>::FixedVector(Args... args) : _data{static_cast<T>(args)...}
+    {
+    }
+
+    /**
+     * @brief Construct a fixed vector from a dynamic vector of the same size
+     *
+     * @param v Vector or view to copy
+     */
+    template <Arithmetic T, size_t N>
+    FixedVector<T, N>::FixedVector(const VectorView<T> &v)
+    {
+        if (v.size() != N)
+            throw std::invalid_argument("Vector size must match the fixed size");
+        fixed::unroll<N>([&](size_t i)
+                         { _data[i] = v[i]; });
+    }
+
+    /**
+     * @brief Get the size of the vector
+     *
+     * @return size_t N
+     */
+    template <Arithmetic T, size_t N>
+    constexpr size_t FixedVector<T, N>::size()
+    {
+        return N;
+    }
+
+    /**
+     * @brief Get data pointer
+     *
+     * @return T* Pointer to the inline storage
+     */
+    template <Arithmetic T, size_t N>
+    constexpr T *FixedVector<T, N>::data()
+    {
+        return _data;
+    }
+
+    /**
+     * @brief Get const data pointer
+     *
+     * @return const T* Pointer to the inline storage
+     */
+    template <Arithmetic T, size_t N>
+    constexpr const T *FixedVector<T, N>::data() const
+    {
+        return _data;
+    }
+
+    /**
+     * @brief Return a dynamic view of the vector
+     *
+     * @return VectorView<T> View sharing the inline storage
+     */
+    template <Arithmetic T, size_t N>
+    VectorView<T> FixedVector<T, N>::view()
+    {
+        return VectorView<T>(_data, N);
+    }
+
+    /**
+     * @brief Return a dynamic view of the vector
+     *
+     * @return const VectorView<T> View sharing the inline storage
+     */
+    template <Arithmetic T, size_t N>
+    const VectorView<T> FixedVector<T, N>::view() const
+    {
+        return VectorView<T>(const_cast<T *>(_data), N);
+    }
+
+    /**
+     * @brief Calculate the squared euclidean norm of the vector
+     *
+     * @return T Sum of squares of the elements
+     */
+    template <Arithmetic T, size_t N>
+    constexpr T FixedVector<T, N>::normSquared() const
+    {
+        return (*this) * (*this);
+    }
+
+    /**
+     * @brief Calculate the euclidean norm of the vector
+     *
+     * @return double euclidean norm
+     */
+    template <Arithmetic T, size_t N>
+    double FixedVector<T, N>::norm() const
+    {
+        return std::sqrt(static_cast<double>(normSquared()));
+    }
+
+    /**
+     * @brief Get element at the given index
+     *
+     * @param index Index of element, not checked
+     * @return T& Element at index
+     */
+    template <Arithmetic T, size_t N>
+    constexpr T &FixedVector<T, N>::operator[](size_t index)
+    {
+        return _data[index];
+    }
+
+    /**
+     * @brief Get const reference to the element at the given index
+     *
+     * @param index Index of element, not checked
+     * @return const T& Element at index
+     */
+    template <Arithmetic T, size_t N>
+    constexpr const T &FixedVector<T, N>::operator[](size_t index) const
+    {
+        return _data[index];
+    }
+
+    /**
+     * @brief Compare two vectors for equality
+     *
+     * @param other Vector to compare
+     * @return true Vectors are equal
+     * @return false Vectors are not equal
+     */
+    template <Arithmetic T, size_t N>
+    constexpr bool FixedVector<T, N>::operator==(const FixedVector &other) const
+    {
+        bool equal = true;
+        fixed::unroll<N>([&](size_t i)
+                         { equal = equal && _data[i] == other._data[i]; });
+        return equal;
+    }
+
+    /**
+     * @brief Add another vector to the vector
+     *
+     * @param other Vector to add
+     * @return FixedVector& Result of addition
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> &FixedVector<T, N>::operator+=(const FixedVector &other)
+    {
+        fixed::unroll<N>([&](size_t i)
+                         { _data[i] += other._data[i]; });
+        return *this;
+    }
+
+    /**
+     * @brief Subtract another vector from the vector
+     *
+     * @param other Vector to subtract
+     * @return FixedVector& Result of subtraction
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> &FixedVector<T, N>::operator-=(const FixedVector &other)
+    {
+        fixed::unroll<N>([&](size_t i)
+                         { _data[i] -= other._data[i]; });
+        return *this;
+    }
+
+    /**
+     * @brief Multiply the vector by a scalar
+     *
+     * @param scalar Scalar to multiply by
+     * @return FixedVector& Result of multiplication
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> &FixedVector<T, N>::operator*=(T scalar)
+    {
+        fixed::unroll<N>([&](size_t i)
+                         { _data[i] *= scalar; });
+        return *this;
+    }
+
+    /**
+     * @brief Divide the vector by a scalar
+     *
+     * @param scalar Scalar to divide by
+     * @return FixedVector& Result of division
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> &FixedVector<T, N>::operator/=(T scalar)
+    {
+        fixed::unroll<N>([&](size_t i)
+                         { _data[i] /= scalar; });
+        return *this;
+    }
+
+    /**
+     * @brief Return a string representation of the vector
+     *
+     * @return std::string String representation of the vector
+     */
+    template <Arithmetic T, size_t N>
+    FixedVector<T, N>::operator std::string() const
+    {
+        return static_cast<std::string>(view());
+    }
+
+    /**
+     * @brief Add two vectors
+     *
+     * @param a First vector
+     * @param b Vector to add
+     * @return FixedVector<T, N> Sum
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> operator+(FixedVector<T, N> a, const FixedVector<T, N> &b)
+    {
+        return a += b;
+    }
+
+    /**
+     * @brief Subtract two vectors
+     *
+     * @param a First vector
+     * @param b Vector to subtract
+     * @return FixedVector<T, N> Difference
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> operator-(FixedVector<T, N> a, const FixedVector<T, N> &b)
+    {
+        return a -= b;
+    }
+
+    /**
+     * @brief Negate a vector
+     *
+     * @param a Vector to negate
+     * @return FixedVector<T, N> Negation
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> operator-(const FixedVector<T, N> &a)
+    {
+        FixedVector<T, N> result;
+        fixed::unroll<N>([&](size_t i)
+                         { result[i] = -a[i]; });
+        return result;
+    }
+
+    /**
+     * @brief Multiply a vector by a scalar
+     *
+     * @param a Vector
+     * @param scalar Scalar to multiply by
+     * @return FixedVector<T, N> Product
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> operator*(FixedVector<T, N> a, std::type_identity_t<T> scalar)
+    {
+        return a *= scalar;
+    }
+
+    /**
+     * @brief Multiply a scalar by a vector
+     *
+     * @param scalar Scalar to multiply by
+     * @param a Vector
+     * @return FixedVector<T, N> Product
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> operator*(std::type_identity_t<T> scalar, FixedVector<T, N> a)
+    {
+        return a *= scalar;
+    }
+
+    /**
+     * @brief Divide a vector by a scalar
+     *
+     * @param a Vector
+     * @param scalar Scalar to divide by
+     * @return FixedVector<T, N> Quotient
+     */
+    template <Arithmetic T, size_t N>
+    constexpr FixedVector<T, N> operator/(FixedVector<T, N> a, std::type_identity_t<T> scalar)
+    {
+        return a /= scalar;
+    }
+
+    /**
+     * @brief Dot product of two vectors
+     *
+     * @param a First vector
+     * @param b Second vector
+     * @return T Dot product
+     */
+    template <Arithmetic T, size_t N>
+    constexpr T operator*(const FixedVector<T, N> &a, const FixedVector<T, N> &b)
+    {
+        T result = 0;
+        fixed::unroll<N>([&](size_t i)
+                         { result += a[i] * b[i]; });
+        return result;
+    }
+
+    /**
+     * @brief fmt::formatter specialization for FixedVector
+     *
+     * @param v Vector to format
+     * @return auto Vector formatted as a string
+     */
+    template <Arithmetic T, size_t N>
+    auto format_as(const FixedVector<T, N> &v)
+    {
+        return static_cast<std::string>(v);
+    }
+
+    /**
+     * @brief Output stream operator for FixedVector
+     *
+     * @param os Output stream
+     * @param v Vector to output
+     * @return std::ostream& Output stream
+     */
+    template <Arithmetic T, size_t N>
+    std::ostream &operator<<(std::ostream &os, const FixedVector<T, N> &v)
+    {
+        return os << static_cast<std::string>(v);
+    }
+
+}
+
+#endif
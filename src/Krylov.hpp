@@ -0,0 +1,798 @@
+#ifndef M42_KRYLOV_HPP
+#define M42_KRYLOV_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+#include "Matrix.hpp"
+#include "SparseMatrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class VectorView;
+
+    template <Arithmetic T>
+    class CsrMatrix;
+
+    namespace krylov
+    {
+
+        /**
+         * @brief Anything that computes y = A * x into caller-supplied storage
+         *
+         * Satisfied by MatrixView, CsrMatrix and CscMatrix through their
+         * multiply() member, and by any callable taking (x, y).
+         */
+        template <typename A, typename T>
+        concept LinearOperator =
+            requires(const A &a, const VectorView<T> &x, VectorView<T> &y) { a.multiply(x, y); } ||
+            std::invocable<const A &, const VectorView<T> &, VectorView<T> &>;
+
+        /**
+         * @brief Anything that computes z = M^-1 * r into caller-supplied storage
+         */
+        template <typename P, typename T>
+        concept Preconditioner = requires(const P &p, const VectorView<T> &r, VectorView<T> &z) { p.apply(r, z); };
+
+        /**
+         * @brief Compute y = A * x with whichever interface the operator has
+         *
+         * @param a Operator
+         * @param x Operand
+         * @param y Result, overwritten
+         */
+        template <typename T, LinearOperator<T> A>
+        void apply(const A &a, const VectorView<T> &x, VectorView<T> &y)
+        {
+            if constexpr (requires { a.multiply(x, y); })
+                a.multiply(x, y);
+            else
+                a(x, y);
+        }
+
+        /**
+         * @brief Give a workspace vector n elements, allocating only on size change
+         *
+         * @param v Workspace vector
+         * @param n Required size
+         */
+        template <Arithmetic T>
+        void reserve(Vector<T> &v, size_t n)
+        {
+            if (v.size() != n)
+                v = Vector<T>(n);
+        }
+
+        /**
+         * @brief Euclidean norm of contiguous data
+         */
+        template <std::floating_point T>
+        T norm(const T *x, size_t n)
+        {
+            return std::sqrt(simd::sumSquares(x, n));
+        }
+
+        /**
+         * @brief r = b - A * x
+         */
+        template <typename T, LinearOperator<T> A>
+        void residual(const A &a, const VectorView<T> &b, const VectorView<T> &x, VectorView<T> &r)
+        {
+            apply(a, x, r);
+            simd::subtract(b.data(), r.data(), r.data(), b.size());
+        }
+
+    }
+
+    /**
+     * @brief Stopping criteria shared by the iterative solvers
+     *
+     * A solve stops once ||b - A * x|| <= tolerance * ||b||, or after
+     * maxIterations iterations. restart is the Krylov subspace dimension of
+     * GMRES and is ignored by the other solvers.
+     */
+    struct SolverOptions
+    {
+        double tolerance = 1e-10;
+        size_t maxIterations = 1000;
+        size_t restart = 30;
+    };
+
+    /**
+     * @brief Outcome of an iterative solve
+     *
+     * residual is the relative residual ||b - A * x|| / ||b|| as tracked by
+     * the iteration, it can drift from the true residual by rounding.
+     */
+    struct SolverStatistics
+    {
+        size_t iterations = 0;
+        double residual = 0;
+        bool converged = false;
+    };
+
+    /**
+     * @brief Preconditioner that does nothing, z = r
+     *
+     * @tparam T Type of vector elements
+     */
+    template <std::floating_point T>
+    class IdentityPreconditioner
+    {
+    public:
+        void apply(const VectorView<T> &r, VectorView<T> &z) const;
+    };
+
+    /**
+     * @brief Diagonal preconditioner, z = D^-1 * r
+     *
+     * Cheap and effective on diagonally dominant systems.
+     *
+     * @tparam T Type of vector elements
+     */
+    template <std::floating_point T>
+    class JacobiPreconditioner
+    {
+    private:
+        Vector<T> _inverse;
+
+        void invert();
+
+    public:
+        explicit JacobiPreconditioner(const MatrixView<T> &matrix);
+        explicit JacobiPreconditioner(const CsrMatrix<T> &matrix);
+
+        void apply(const VectorView<T> &r, VectorView<T> &z) const;
+    };
+
+    /**
+     * @brief Incomplete LU factorization with zero fill-in
+     *
+     * Gaussian elimination restricted to the sparsity pattern of the matrix:
+     * L (unit diagonal) and U share the pattern of A, so the factors cost no
+     * more memory than the matrix itself.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <std::floating_point T>
+    class ILU0
+    {
+    private:
+        size_t _size;
+        std::vector<size_t> _offsets;
+        std::vector<size_t> _columns;
+        std::vector<T> _values;
+        std::vector<size_t> _diagonal;
+
+    public:
+        explicit ILU0(const CsrMatrix<T> &matrix);
+
+        size_t size() const;
+        void apply(const VectorView<T> &r, VectorView<T> &z) const;
+    };
+
+    /**
+     * @brief Preconditioned conjugate gradient
+     *
+     * For symmetric positive definite operators and preconditioners. The
+     * four workspace vectors are kept between solves of the same size.
+     *
+     * @tparam T Type of vector elements
+     */
+    template <std::floating_point T>
+    class ConjugateGradient
+    {
+    private:
+        SolverOptions _options;
+        Vector<T> _r;
+        Vector<T> _z;
+        Vector<T> _p;
+        Vector<T> _q;
+
+    public:
+        explicit ConjugateGradient(const SolverOptions &options = {});
+
+        const SolverOptions &options() const;
+        template <krylov::LinearOperator<T> A, krylov::Preconditioner<T> M = IdentityPreconditioner<T>>
+        SolverStatistics solve(const A &a, const VectorView<T> &b, VectorView<T> &x, const M &m = M());
+    };
+
+    /**
+     * @brief Right-preconditioned stabilized biconjugate gradient
+     *
+     * For general nonsymmetric operators, with two operator applications per
+     * iteration and a fixed amount of memory.
+     *
+     * @tparam T Type of vector elements
+     */
+    template <std::floating_point T>
+    class BiCGSTAB
+    {
+    private:
+        SolverOptions _options;
+        Vector<T> _r;
+        Vector<T> _rHat;
+        Vector<T> _p;
+        Vector<T> _v;
+        Vector<T> _pHat;
+        Vector<T> _sHat;
+        Vector<T> _t;
+
+    public:
+        explicit BiCGSTAB(const SolverOptions &options = {});
+
+        const SolverOptions &options() const;
+        template <krylov::LinearOperator<T> A, krylov::Preconditioner<T> M = IdentityPreconditioner<T>>
+        SolverStatistics solve(const A &a, const VectorView<T> &b, VectorView<T> &x, const M &m = M());
+    };
+
+    /**
+     * @brief Right-preconditioned restarted GMRES(m)
+     *
+     * Builds an orthonormal Krylov basis of options().restart vectors with
+     * modified Gram-Schmidt, and reduces the Hessenberg matrix with Givens
+     * rotations so the residual is known at every iteration without forming
+     * x. The basis is the dominant cost: n * (restart + 1) elements.
+     *
+     * @tparam T Type of vector elements
+     */
+    template <std::floating_point T>
+    class GMRES
+    {
+    private:
+        SolverOptions _options;
+        Matrix<T> _basis;
+        Matrix<T> _hessenberg;
+        std::vector<T> _cosines;
+        std::vector<T> _sines;
+        std::vector<T> _g;
+        Vector<T> _w;
+        Vector<T> _z;
+
+    public:
+        explicit GMRES(const SolverOptions &options = {});
+
+        const SolverOptions &options() const;
+        template <krylov::LinearOperator<T> A, krylov::Preconditioner<T> M = IdentityPreconditioner<T>>
+        SolverStatistics solve(const A &a, const VectorView<T> &b, VectorView<T> &x, const M &m = M());
+    };
+
+    /**
+     * @brief Copy r into z
+     *
+     * @param r Residual
+     * @param z Result, overwritten
+     */
+    template <std::floating_point T>
+    void IdentityPreconditioner<T>::apply(const VectorView<T> &r, VectorView<T> &z) const
+    {
+        z = r;
+    }
+
+    /**
+     * @brief Build the preconditioner from the diagonal of a dense matrix
+     *
+     * @param matrix Square matrix with a nonzero diagonal
+     */
+    template <std::floating_point T>
+    JacobiPreconditioner<T>::JacobiPreconditioner(const MatrixView<T> &matrix)
+    {
+        if (!matrix.isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        _inverse = Vector<T>(matrix.diagonal());
+        invert();
+    }
+
+    /**
+     * @brief Build the preconditioner from the diagonal of a sparse matrix
+     *
+     * @param matrix Square matrix with a nonzero diagonal
+     */
+    template <std::floating_point T>
+    JacobiPreconditioner<T>::JacobiPreconditioner(const CsrMatrix<T> &matrix)
+    {
+        if (matrix.width() != matrix.height())
+            throw std::invalid_argument("Matrix must be square");
+        const std::vector<size_t> &offsets = matrix.rowOffsets();
+        const std::vector<size_t> &columns = matrix.columnIndices();
+        _inverse = Vector<T>(matrix.height());
+        for (size_t i = 0; i < matrix.height(); i++)
+        {
+            auto begin = columns.begin() + offsets[i];
+            auto end = columns.begin() + offsets[i + 1];
+            auto it = std::lower_bound(begin, end, i);
+            _inverse[i] = it != end && *it == i ? matrix.values()[it - columns.begin()] : T(0);
+        }
+        invert();
+    }
+
+    /**
+     * @brief Replace the stored diagonal by its reciprocal
+     */
+    template <std::floating_point T>
+    void JacobiPreconditioner<T>::invert()
+    {
+        for (size_t i = 0; i < _inverse.size(); i++)
+        {
+            if (_inverse[i] == T(0))
+                throw std::invalid_argument("Diagonal must not contain zeros");
+            _inverse[i] = T(1) / _inverse[i];
+        }
+    }
+
+    /**
+     * @brief Compute z = D^-1 * r
+     *
+     * @param r Residual
+     * @param z Result, overwritten
+     */
+    template <std::floating_point T>
+    void JacobiPreconditioner<T>::apply(const VectorView<T> &r, VectorView<T> &z) const
+    {
+        if (r.size() != _inverse.size() || z.size() != _inverse.size())
+            throw std::invalid_argument("Vector size must match the preconditioner size");
+        for (size_t i = 0; i < _inverse.size(); i++)
+            z[i] = _inverse[i] * r[i];
+    }
+
+    /**
+     * @brief Factor a square sparse matrix on its own sparsity pattern
+     *
+     * Row i is eliminated with the already factored rows above it, updates
+     * that would fall outside the pattern are dropped.
+     *
+     * @param matrix Square matrix whose diagonal is stored
+     */
+    template <std::floating_point T>
+    ILU0<T>::ILU0(const CsrMatrix<T> &matrix)
+        : _size(matrix.height()), _offsets(matrix.rowOffsets()), _columns(matrix.columnIndices()),
+          _values(matrix.values()), _diagonal(matrix.height())
+    {
+        if (matrix.width() != matrix.height())
+            throw std::invalid_argument("Matrix must be square");
+        for (size_t i = 0; i < _size; i++)
+        {
+            auto begin = _columns.begin() + _offsets[i];
+            auto end = _columns.begin() + _offsets[i + 1];
+            auto it = std::lower_bound(begin, end, i);
+            if (it == end || *it != i)
+                throw std::invalid_argument("Diagonal must be stored");
+            _diagonal[i] = it - _columns.begin();
+        }
+
+        // position of every column of the current row, npos outside the pattern
+        const size_t npos = std::numeric_limits<size_t>::max();
+        std::vector<size_t> position(_size, npos);
+        for (size_t i = 0; i < _size; i++)
+        {
+            for (size_t k = _offsets[i]; k < _offsets[i + 1]; k++)
+                position[_columns[k]] = k;
+            for (size_t k = _offsets[i]; k < _diagonal[i]; k++)
+            {
+                size_t c = _columns[k];
+                T l = _values[k] / _values[_diagonal[c]];
+                _values[k] = l;
+                for (size_t kk = _diagonal[c] + 1; kk < _offsets[c + 1]; kk++)
+                    if (position[_columns[kk]] != npos)
+                        _values[position[_columns[kk]]] -= l * _values[kk];
+            }
+            if (_values[_diagonal[i]] == T(0))
+                throw std::invalid_argument("Zero pivot in incomplete factorization");
+            for (size_t k = _offsets[i]; k < _offsets[i + 1]; k++)
+                position[_columns[k]] = npos;
+        }
+    }
+
+    /**
+     * @brief Get the size of the factored matrix
+     *
+     * @return size_t Number of rows and columns
+     */
+    template <std::floating_point T>
+    size_t ILU0<T>::size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief Compute z = (L * U)^-1 * r by forward and backward substitution
+     *
+     * @param r Residual
+     * @param z Result, overwritten
+     */
+    template <std::floating_point T>
+    void ILU0<T>::apply(const VectorView<T> &r, VectorView<T> &z) const
+    {
+        if (r.size() != _size || z.size() != _size)
+            throw std::invalid_argument("Vector size must match the preconditioner size");
+        for (size_t i = 0; i < _size; i++)
+        {
+            T sum = r[i];
+            for (size_t k = _offsets[i]; k < _diagonal[i]; k++)
+                sum -= _values[k] * z[_columns[k]];
+            z[i] = sum;
+        }
+        for (size_t i = _size; i-- > 0;)
+        {
+            T sum = z[i];
+            for (size_t k = _diagonal[i] + 1; k < _offsets[i + 1]; k++)
+                sum -= _values[k] * z[_columns[k]];
+            z[i] = sum / _values[_diagonal[i]];
+        }
+    }
+
+    /**
+     * @brief Construct a conjugate gradient solver
+     *
+     * @param options Stopping criteria
+     */
+    template <std::floating_point T>
+    ConjugateGradient<T>::ConjugateGradient(const SolverOptions &options) : _options(options) {}
+
+    /**
+     * @brief Get the stopping criteria
+     *
+     * @return const SolverOptions& Stopping criteria
+     */
+    template <std::floating_point T>
+    const SolverOptions &ConjugateGradient<T>::options() const
+    {
+        return _options;
+    }
+
+    /**
+     * @brief Solve A * x = b starting from the current content of x
+     *
+     * @param a Symmetric positive definite operator
+     * @param b Right-hand side
+     * @param x Initial guess, overwritten by the solution
+     * @param m Symmetric positive definite preconditioner
+     * @return SolverStatistics Iterations, relative residual and convergence
+     */
+    template <std::floating_point T>
+    template <krylov::LinearOperator<T> A, krylov::Preconditioner<T> M>
+    SolverStatistics ConjugateGradient<T>::solve(const A &a, const VectorView<T> &b, VectorView<T> &x, const M &m)
+    {
+        if (b.size() != x.size())
+            throw std::invalid_argument("Vector sizes must be equal");
+        // the iteration works on contiguous storage
+        if (!b.isContiguous() || !x.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<T> xc(x);
+            SolverStatistics statistics = solve(a, ScratchVector<T>(b), xc, m);
+            x = xc;
+            return statistics;
+        }
+        size_t n = b.size();
+        krylov::reserve(_r, n);
+        krylov::reserve(_z, n);
+        krylov::reserve(_p, n);
+        krylov::reserve(_q, n);
+
+        SolverStatistics statistics;
+        T normB = krylov::norm(b.data(), n);
+        if (normB == T(0))
+        {
+            std::fill(x.data(), x.data() + n, T(0));
+            statistics.converged = true;
+            return statistics;
+        }
+        T target = static_cast<T>(_options.tolerance) * normB;
+
+        krylov::residual(a, b, x, _r);
+        T normR = krylov::norm(_r.data(), n);
+        m.apply(_r, _z);
+        simd::multiply(_z.data(), T(1), _p.data(), n);
+        T rz = simd::dot(_r.data(), _z.data(), n);
+        while (normR > target && statistics.iterations < _options.maxIterations)
+        {
+            krylov::apply(a, _p, _q);
+            T pq = simd::dot(_p.data(), _q.data(), n);
+            if (pq == T(0))
+                break;
+            T alpha = rz / pq;
+            simd::axpy(alpha, _p.data(), x.data(), n);
+            simd::axpy(-alpha, _q.data(), _r.data(), n);
+            normR = krylov::norm(_r.data(), n);
+            statistics.iterations++;
+            if (normR <= target)
+                break;
+            m.apply(_r, _z);
+            T rzNext = simd::dot(_r.data(), _z.data(), n);
+            // p = z + beta * p
+            simd::multiply(_p.data(), rzNext / rz, _p.data(), n);
+            simd::add(_z.data(), _p.data(), _p.data(), n);
+            rz = rzNext;
+        }
+        statistics.residual = static_cast<double>(normR / normB);
+        statistics.converged = normR <= target;
+        return statistics;
+    }
+
+    /**
+     * @brief Construct a BiCGSTAB solver
+     *
+     * @param options Stopping criteria
+     */
+    template <std::floating_point T>
+    BiCGSTAB<T>::BiCGSTAB(const SolverOptions &options) : _options(options) {}
+
+    /**
+     * @brief Get the stopping criteria
+     *
+     * @return const SolverOptions& Stopping criteria
+     */
+    template <std::floating_point T>
+    const SolverOptions &BiCGSTAB<T>::options() const
+    {
+        return _options;
+    }
+
+    /**
+     * @brief Solve A * x = b starting from the current content of x
+     *
+     * Stops early, unconverged, on a breakdown of the recurrence.
+     *
+     * @param a Square operator
+     * @param b Right-hand side
+     * @param x Initial guess, overwritten by the solution
+     * @param m Preconditioner, applied on the right
+     * @return SolverStatistics Iterations, relative residual and convergence
+     */
+    template <std::floating_point T>
+    template <krylov::LinearOperator<T> A, krylov::Preconditioner<T> M>
+    SolverStatistics BiCGSTAB<T>::solve(const A &a, const VectorView<T> &b, VectorView<T> &x, const M &m)
+    {
+        if (b.size() != x.size())
+            throw std::invalid_argument("Vector sizes must be equal");
+        if (!b.isContiguous() || !x.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<T> xc(x);
+            SolverStatistics statistics = solve(a, ScratchVector<T>(b), xc, m);
+            x = xc;
+            return statistics;
+        }
+        size_t n = b.size();
+        krylov::reserve(_r, n);
+        krylov::reserve(_rHat, n);
+        krylov::reserve(_p, n);
+        krylov::reserve(_v, n);
+        krylov::reserve(_pHat, n);
+        krylov::reserve(_sHat, n);
+        krylov::reserve(_t, n);
+
+        SolverStatistics statistics;
+        T normB = krylov::norm(b.data(), n);
+        if (normB == T(0))
+        {
+            std::fill(x.data(), x.data() + n, T(0));
+            statistics.converged = true;
+            return statistics;
+        }
+        T target = static_cast<T>(_options.tolerance) * normB;
+
+        krylov::residual(a, b, x, _r);
+        T normR = krylov::norm(_r.data(), n);
+        simd::multiply(_r.data(), T(1), _rHat.data(), n);
+        std::fill(_p.data(), _p.data() + n, T(0));
+        std::fill(_v.data(), _v.data() + n, T(0));
+        T rho = 1;
+        T alpha = 1;
+        T omega = 1;
+        while (normR > target && statistics.iterations < _options.maxIterations)
+        {
+            T rhoNext = simd::dot(_rHat.data(), _r.data(), n);
+            if (rhoNext == T(0))
+                break;
+            T beta = (rhoNext / rho) * (alpha / omega);
+            rho = rhoNext;
+            // p = r + beta * (p - omega * v)
+            simd::axpy(-omega, _v.data(), _p.data(), n);
+            simd::multiply(_p.data(), beta, _p.data(), n);
+            simd::add(_r.data(), _p.data(), _p.data(), n);
+
+            m.apply(_p, _pHat);
+            krylov::apply(a, _pHat, _v);
+            T rv = simd::dot(_rHat.data(), _v.data(), n);
+            if (rv == T(0))
+                break;
+            alpha = rho / rv;
+            // s = r - alpha * v, kept in r
+            simd::axpy(-alpha, _v.data(), _r.data(), n);
+            simd::axpy(alpha, _pHat.data(), x.data(), n);
+            statistics.iterations++;
+            normR = krylov::norm(_r.data(), n);
+            if (normR <= target)
+                break;
+
+            m.apply(_r, _sHat);
+            krylov::apply(a, _sHat, _t);
+            T tt = simd::dot(_t.data(), _t.data(), n);
+            if (tt == T(0))
+                break;
+            omega = simd::dot(_t.data(), _r.data(), n) / tt;
+            simd::axpy(omega, _sHat.data(), x.data(), n);
+            simd::axpy(-omega, _t.data(), _r.data(), n);
+            normR = krylov::norm(_r.data(), n);
+            if (omega == T(0))
+                break;
+        }
+        statistics.residual = static_cast<double>(normR / normB);
+        statistics.converged = normR <= target;
+        return statistics;
+    }
+
+    /**
+     * @brief Construct a GMRES solver
+     *
+     * @param options Stopping criteria and restart length
+     */
+    template <std::floating_point T>
+    GMRES<T>::GMRES(const SolverOptions &options) : _options(options)
+    {
+        if (options.restart == 0)
+            throw std::invalid_argument("Restart length must be positive");
+    }
+
+    /**
+     * @brief Get the stopping criteria
+     *
+     * @return const SolverOptions& Stopping criteria
+     */
+    template <std::floating_point T>
+    const SolverOptions &GMRES<T>::options() const
+    {
+        return _options;
+    }
+
+    /**
+     * @brief Solve A * x = b starting from the current content of x
+     *
+     * @param a Square operator
+     * @param b Right-hand side
+     * @param x Initial guess, overwritten by the solution
+     * @param m Preconditioner, applied on the right
+     * @return SolverStatistics Iterations, relative residual and convergence
+     */
+    template <std::floating_point T>
+    template <krylov::LinearOperator<T> A, krylov::Preconditioner<T> M>
+    SolverStatistics GMRES<T>::solve(const A &a, const VectorView<T> &b, VectorView<T> &x, const M &m)
+    {
+        if (b.size() != x.size())
+            throw std::invalid_argument("Vector sizes must be equal");
+        if (!b.isContiguous() || !x.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<T> xc(x);
+            SolverStatistics statistics = solve(a, ScratchVector<T>(b), xc, m);
+            x = xc;
+            return statistics;
+        }
+        size_t n = b.size();
+        size_t restart = std::min(_options.restart, std::max<size_t>(n, 1));
+        if (_basis.width() != restart + 1 || _basis.height() != n)
+            _basis = Matrix<T>(restart + 1, n);
+        if (_hessenberg.width() != restart)
+            _hessenberg = Matrix<T>(restart, restart + 1);
+        _cosines.resize(restart);
+        _sines.resize(restart);
+        _g.resize(restart + 1);
+        krylov::reserve(_w, n);
+        krylov::reserve(_z, n);
+
+        SolverStatistics statistics;
+        T normB = krylov::norm(b.data(), n);
+        if (normB == T(0))
+        {
+            std::fill(x.data(), x.data() + n, T(0));
+            statistics.converged = true;
+            return statistics;
+        }
+        T target = static_cast<T>(_options.tolerance) * normB;
+        T *h = _hessenberg.data();
+        const size_t ldh = restart + 1;
+
+        krylov::residual(a, b, x, _w);
+        T normR = krylov::norm(_w.data(), n);
+        while (normR > target && statistics.iterations < _options.maxIterations)
+        {
+            simd::multiply(_w.data(), T(1) / normR, _basis.data(), n);
+            std::fill(_g.begin(), _g.end(), T(0));
+            _g[0] = normR;
+
+            size_t j = 0;
+            bool breakdown = false;
+            while (j < restart && statistics.iterations < _options.maxIterations)
+            {
+                VectorView<T> vj(_basis.data() + j * n, n);
+                m.apply(vj, _z);
+                krylov::apply(a, _z, _w);
+                for (size_t i = 0; i <= j; i++)
+                {
+                    const T *vi = _basis.data() + i * n;
+                    T hij = simd::dot(_w.data(), vi, n);
+                    h[j * ldh + i] = hij;
+                    simd::axpy(-hij, vi, _w.data(), n);
+                }
+                T next = krylov::norm(_w.data(), n);
+                h[j * ldh + j + 1] = next;
+                // exact invariant subspace: the current iterate is the solution
+                breakdown = next == T(0);
+                if (!breakdown)
+                    simd::multiply(_w.data(), T(1) / next, _basis.data() + (j + 1) * n, n);
+
+                for (size_t i = 0; i < j; i++)
+                {
+                    T hi = h[j * ldh + i];
+                    T hi1 = h[j * ldh + i + 1];
+                    h[j * ldh + i] = _cosines[i] * hi + _sines[i] * hi1;
+                    h[j * ldh + i + 1] = -_sines[i] * hi + _cosines[i] * hi1;
+                }
+                T hjj = h[j * ldh + j];
+                T r = std::hypot(hjj, next);
+                // singular operator: column j vanishes and cannot reduce the residual
+                if (r == T(0))
+                {
+                    statistics.iterations++;
+                    breakdown = true;
+                    break;
+                }
+                _cosines[j] = hjj / r;
+                _sines[j] = next / r;
+                h[j * ldh + j] = r;
+                h[j * ldh + j + 1] = 0;
+                _g[j + 1] = -_sines[j] * _g[j];
+                _g[j] = _cosines[j] * _g[j];
+
+                j++;
+                statistics.iterations++;
+                normR = std::abs(_g[j]);
+                if (normR <= target || breakdown)
+                    break;
+            }
+
+            // y = H^-1 * g in place, then x += M^-1 * V * y
+            for (size_t i = j; i-- > 0;)
+            {
+                T sum = _g[i];
+                for (size_t k = i + 1; k < j; k++)
+                    sum -= h[k * ldh + i] * _g[k];
+                _g[i] = sum / h[i * ldh + i];
+            }
+            // a tiny pivot can still overflow, x is never moved along a non-finite direction
+            bool finite = std::all_of(_g.begin(), _g.begin() + j, [](T v) { return std::isfinite(v); });
+            if (finite)
+            {
+                std::fill(_w.data(), _w.data() + n, T(0));
+                for (size_t i = 0; i < j; i++)
+                    simd::axpy(_g[i], _basis.data() + i * n, _w.data(), n);
+                m.apply(_w, _z);
+                simd::add(x.data(), _z.data(), x.data(), n);
+            }
+
+            // the rotated residual drifts from the true one, recompute at restart
+            krylov::residual(a, b, x, _w);
+            normR = krylov::norm(_w.data(), n);
+            if (breakdown || !finite)
+                break;
+        }
+        statistics.residual = static_cast<double>(normR / normB);
+        statistics.converged = normR <= target;
+        return statistics;
+    }
+
+}
+
+#endif
@@ -0,0 +1,434 @@
+#ifndef M42_LU_HPP
+#define M42_LU_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "blas.hpp"
+#include "simd.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    template <Arithmetic T>
+    class VectorView;
+
+    /**
+     * @brief LU factorization with partial pivoting, P * A = L * U
+     *
+     * L (unit diagonal, strictly below the diagonal) and U (on and above the
+     * diagonal) are packed into a single column-major buffer, the row
+     * permutation is kept as a list of row interchanges. Integer matrices are
+     * factored in double precision.
+     *
+     * @tparam T Type of components of the factored matrix
+     */
+    template <Arithmetic T>
+    class LU
+    {
+    public:
+        using value_type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+        /**
+         * @brief Number of columns factored by the unblocked panel kernel
+         */
+        static constexpr size_t blockSize = 64;
+
+    private:
+        Matrix<value_type> _lu;
+        std::vector<size_t> _pivots;
+        int _permutationSign;
+        bool _singular;
+
+        static void factor(value_type *a, size_t n, size_t *pivots, int &permutationSign, bool &singular, Execution policy);
+        static void factorPanel(value_type *a, size_t n, size_t *pivots, size_t k0, size_t kb, int &permutationSign, bool &singular);
+        void substitute(value_type *b, size_t ldb, size_t nrhs) const;
+
+    public:
+        explicit LU(const MatrixView<T> &matrix, Execution policy = Execution::Parallel);
+        static value_type determinantOf(const MatrixView<T> &matrix, Execution policy = Execution::Parallel);
+
+        size_t size() const;
+        const Matrix<value_type> &packed() const;
+        const std::vector<size_t> &pivots() const;
+        bool isSingular() const;
+        value_type determinant() const;
+        value_type logAbsDeterminant() const;
+        int sign() const;
+        Matrix<value_type> inverse() const;
+        void inverse(Matrix<value_type> &result) const;
+        Vector<value_type> solve(const VectorView<value_type> &b) const;
+        Matrix<value_type> solve(const MatrixView<value_type> &b) const;
+        void solveInPlace(VectorView<value_type> b) const;
+        void solveInPlace(MatrixView<value_type> b) const;
+    };
+
+    /**
+     * @brief Factor a square matrix
+     *
+     * @param matrix Square matrix to factor
+     * @param policy Execution policy of the block updates
+     */
+    template <Arithmetic T>
+    LU<T>::LU(const MatrixView<T> &matrix, Execution policy)
+        : _lu(matrix.width(), matrix.height()), _pivots(matrix.height()), _permutationSign(1), _singular(false)
+    {
+        if (!matrix.isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        size_t n = matrix.height();
+        for (size_t j = 0; j < n; j++)
+            std::copy(matrix.data() + j * matrix.stride(), matrix.data() + j * matrix.stride() + n, _lu.data() + j * n);
+        factor(_lu.data(), n, _pivots.data(), _permutationSign, _singular, policy);
+    }
+
+    /**
+     * @brief Return the determinant of a square matrix without keeping its factors
+     *
+     * The matrix is factored in a copy drawn from the scratch arena, so
+     * repeated calls do not allocate once the arena has grown.
+     *
+     * @param matrix Square matrix
+     * @param policy Execution policy of the block updates
+     * @return value_type Determinant
+     */
+    template <Arithmetic T>
+    typename LU<T>::value_type LU<T>::determinantOf(const MatrixView<T> &matrix, Execution policy)
+    {
+        if (!matrix.isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        ScratchScope scope;
+        size_t n = matrix.height();
+        value_type *a = ScratchAllocator<value_type>().allocate(n * n);
+        size_t *pivots = ScratchAllocator<size_t>().allocate(n);
+        for (size_t j = 0; j < n; j++)
+            std::copy(matrix.data() + j * matrix.stride(), matrix.data() + j * matrix.stride() + n, a + j * n);
+        int permutationSign = 1;
+        bool singular = false;
+        factor(a, n, pivots, permutationSign, singular, policy);
+        value_type result = permutationSign;
+        for (size_t i = 0; i < n; i++)
+            result *= a[i * n + i];
+        return result;
+    }
+
+    /**
+     * @brief Factor the n x n column-major matrix a in place
+     *
+     * The factorization is right-looking and blocked: each panel of
+     * blockSize columns is factored with vectorized column operations, then
+     * the block row of U is solved and the trailing matrix is updated with
+     * a single GEMM.
+     *
+     * @param a Matrix with leading dimension n, replaced by L and U
+     * @param n Order of the matrix
+     * @param pivots Receives the n row interchanges
+     * @param permutationSign Flipped on every row interchange
+     * @param singular Set when a pivot is exactly zero
+     * @param policy Execution policy of the block updates
+     */
+    template <Arithmetic T>
+    void LU<T>::factor(value_type *a, size_t n, size_t *pivots, int &permutationSign, bool &singular, Execution policy)
+    {
+        for (size_t k0 = 0; k0 < n; k0 += blockSize)
+        {
+            size_t kb = std::min(blockSize, n - k0);
+            factorPanel(a, n, pivots, k0, kb, permutationSign, singular);
+            size_t rest = n - k0 - kb;
+            if (rest == 0)
+                continue;
+            // U12 = L11^-1 * A12
+            blas::trsmLowerUnit(kb, rest, a + k0 * n + k0, n, a + (k0 + kb) * n + k0, n, policy);
+            // A22 -= L21 * U12
+            blas::gemm(rest, rest, kb,
+                       value_type(-1), a + k0 * n + k0 + kb, n,
+                       a + (k0 + kb) * n + k0, n,
+                       value_type(1), a + (k0 + kb) * n + k0 + kb, n, policy);
+        }
+    }
+
+    /**
+     * @brief Factor columns [k0, k0 + kb) below the diagonal
+     *
+     * Row interchanges are applied to whole rows, so the columns left of the
+     * panel (L) and right of it (not yet factored) stay consistent.
+     *
+     * @param a Matrix being factored, leading dimension n
+     * @param n Order of the matrix
+     * @param pivots Receives the row interchanges of the panel
+     * @param k0 First column of the panel
+     * @param kb Number of columns in the panel
+     * @param permutationSign Flipped on every row interchange
+     * @param singular Set when a pivot is exactly zero
+     */
+    template <Arithmetic T>
+    void LU<T>::factorPanel(value_type *a, size_t n, size_t *pivots, size_t k0, size_t kb, int &permutationSign, bool &singular)
+    {
+        for (size_t j = k0; j < k0 + kb; j++)
+        {
+            value_type *column = a + j * n;
+            // find pivot
+            size_t pivot = j;
+            for (size_t i = j + 1; i < n; i++)
+                if (std::abs(column[i]) > std::abs(column[pivot]))
+                    pivot = i;
+            pivots[j] = pivot;
+            if (pivot != j)
+            {
+                for (size_t c = 0; c < n; c++)
+                    std::swap(a[c * n + j], a[c * n + pivot]);
+                permutationSign = -permutationSign;
+            }
+            if (column[j] == value_type(0))
+            {
+                singular = true;
+                continue;
+            }
+            // multipliers of L
+            simd::multiply(column + j + 1, value_type(1) / column[j], column + j + 1, n - j - 1);
+            // eliminate inside the panel
+            for (size_t c = j + 1; c < k0 + kb; c++)
+            {
+                value_type *target = a + c * n;
+                simd::axpy(-target[j], column + j + 1, target + j + 1, n - j - 1);
+            }
+        }
+    }
+
+    /**
+     * @brief Overwrite B with A^-1 * B using the factors
+     *
+     * @param b Pointer to the n x nrhs column-major right-hand sides
+     * @param ldb Leading dimension of B
+     * @param nrhs Number of right-hand sides
+     */
+    template <Arithmetic T>
+    void LU<T>::substitute(value_type *b, size_t ldb, size_t nrhs) const
+    {
+        size_t n = size();
+        for (size_t i = 0; i < n; i++)
+            if (_pivots[i] != i)
+                for (size_t c = 0; c < nrhs; c++)
+                    std::swap(b[c * ldb + i], b[c * ldb + _pivots[i]]);
+        blas::trsmLowerUnit(n, nrhs, _lu.data(), n, b, ldb);
+        blas::trsmUpper(n, nrhs, _lu.data(), n, b, ldb);
+    }
+
+    /**
+     * @brief Return the order of the factored matrix
+     *
+     * @return size_t Order of the matrix
+     */
+    template <Arithmetic T>
+    size_t LU<T>::size() const
+    {
+        return _lu.height();
+    }
+
+    /**
+     * @brief Return L and U packed into one matrix
+     *
+     * @return const Matrix<value_type>& Packed factors
+     */
+    template <Arithmetic T>
+    const Matrix<typename LU<T>::value_type> &LU<T>::packed() const
+    {
+        return _lu;
+    }
+
+    /**
+     * @brief Return the row interchanges, row i was swapped with row pivots()[i]
+     *
+     * @return const std::vector<size_t>& Row interchanges
+     */
+    template <Arithmetic T>
+    const std::vector<size_t> &LU<T>::pivots() const
+    {
+        return _pivots;
+    }
+
+    /**
+     * @brief Return whether U has an exactly zero pivot
+     *
+     * @return bool Whether the factored matrix is singular
+     */
+    template <Arithmetic T>
+    bool LU<T>::isSingular() const
+    {
+        return _singular;
+    }
+
+    /**
+     * @brief Return the determinant of the factored matrix
+     *
+     * @return value_type Determinant
+     */
+    template <Arithmetic T>
+    typename LU<T>::value_type LU<T>::determinant() const
+    {
+        size_t n = size();
+        value_type result = _permutationSign;
+        for (size_t i = 0; i < n; i++)
+            result *= _lu.data()[i * n + i];
+        return result;
+    }
+
+    /**
+     * @brief Return the natural logarithm of the absolute value of the determinant
+     *
+     * Unlike determinant() it does not overflow for large matrices.
+     *
+     * @return value_type log|det|, negative infinity for a singular matrix
+     */
+    template <Arithmetic T>
+    typename LU<T>::value_type LU<T>::logAbsDeterminant() const
+    {
+        if (_singular)
+            return -std::numeric_limits<value_type>::infinity();
+        size_t n = size();
+        value_type result = 0;
+        for (size_t i = 0; i < n; i++)
+            result += std::log(std::abs(_lu.data()[i * n + i]));
+        return result;
+    }
+
+    /**
+     * @brief Return the sign of the determinant
+     *
+     * @return int -1, 0 or 1
+     */
+    template <Arithmetic T>
+    int LU<T>::sign() const
+    {
+        if (_singular)
+            return 0;
+        size_t n = size();
+        int result = _permutationSign;
+        for (size_t i = 0; i < n; i++)
+            if (_lu.data()[i * n + i] < 0)
+                result = -result;
+        return result;
+    }
+
+    /**
+     * @brief Return the inverse of the factored matrix
+     *
+     * @return Matrix<value_type> Inverse matrix
+     */
+    template <Arithmetic T>
+    Matrix<typename LU<T>::value_type> LU<T>::inverse() const
+    {
+        Matrix<value_type> result;
+        inverse(result);
+        return result;
+    }
+
+    /**
+     * @brief Write the inverse of the factored matrix into a caller-supplied matrix
+     *
+     * The storage of result is reused when it already has the right size.
+     *
+     * @param result Matrix to write the inverse to
+     */
+    template <Arithmetic T>
+    void LU<T>::inverse(Matrix<value_type> &result) const
+    {
+        if (_singular)
+            throw std::invalid_argument("Matrix must be invertible");
+        size_t n = size();
+        if (result.width() != n || result.height() != n)
+            result = Matrix<value_type>(n, n);
+        size_t ld = result.stride();
+        value_type *x = result.data();
+        std::fill(x, x + n * ld, value_type(0));
+        for (size_t i = 0; i < n; i++)
+            x[i * ld + i] = 1;
+        // A^-1 = U^-1 * L^-1 * P, solve A * X = I
+        substitute(x, ld, n);
+    }
+
+    /**
+     * @brief Solve A * x = b with the stored factors
+     *
+     * @param b Right-hand side
+     * @return Vector<value_type> Solution
+     */
+    template <Arithmetic T>
+    Vector<typename LU<T>::value_type> LU<T>::solve(const VectorView<value_type> &b) const
+    {
+        Vector<value_type> x(b);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief Solve A * X = B for every column of B with the stored factors
+     *
+     * @param b Right-hand sides, one per column
+     * @return Matrix<value_type> Solutions, one per column
+     */
+    template <Arithmetic T>
+    Matrix<typename LU<T>::value_type> LU<T>::solve(const MatrixView<value_type> &b) const
+    {
+        Matrix<value_type> x(b);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief Overwrite b with the solution of A * x = b
+     *
+     * Does not allocate for unit-stride b, so one factorization can serve
+     * any number of right-hand sides at the cost of two triangular solves
+     * each.
+     *
+     * @param b Right-hand side, a vector or a view into a larger matrix, replaced by the solution
+     */
+    template <Arithmetic T>
+    void LU<T>::solveInPlace(VectorView<value_type> b) const
+    {
+        if (b.size() != size())
+            throw std::invalid_argument("Vector size must match matrix height");
+        if (_singular)
+            throw std::invalid_argument("Matrix must be invertible");
+        // the triangular solves need unit stride, rows and diagonals go through a copy
+        if (!b.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<value_type> x(b);
+            substitute(x.data(), size(), 1);
+            b = x;
+            return;
+        }
+        substitute(b.data(), size(), 1);
+    }
+
+    /**
+     * @brief Overwrite every column of B with the solution of A * X = B
+     *
+     * @param b Right-hand sides, a matrix or a block of one, replaced by the solutions
+     */
+    template <Arithmetic T>
+    void LU<T>::solveInPlace(MatrixView<value_type> b) const
+    {
+        if (b.height() != size())
+            throw std::invalid_argument("Matrix heights must match");
+        if (_singular)
+            throw std::invalid_argument("Matrix must be invertible");
+        substitute(b.data(), b.stride(), b.width());
+    }
+
+}
+
+#endif
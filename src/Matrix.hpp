@@ -1,13 +1,25 @@
 #ifndef M42_MATRIX_HPP
 #define M42_MATRIX_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <limits>
 #include <string>
 #include <ostream>
+#include <stdexcept>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "common.hpp"
+#include "memory.hpp"
+#include "blas.hpp"
 #include "Vector.hpp"
+#include "MatrixView.hpp"
+#include "LU.hpp"
+#include "Cholesky.hpp"
+#include "QR.hpp"
 
 namespace m42
 {
@@ -16,80 +28,138 @@ namespace m42
     class VectorView;
 
     template <Arithmetic T>
-    class Vector;
+    class MatrixView;
+
+    template <Arithmetic T>
+    class LU;
+
+    template <Arithmetic T>
+    class Cholesky;
+
+    template <Arithmetic T>
+    class QR;
 
     /**
      * @brief Matrix class
      *
+     * Owns column-major storage from Allocator, 64-byte aligned by default.
+     * Columns are contiguous unless the matrix is built with
+     * Padding::Aligned, everything that also works on blocks of a larger
+     * matrix is inherited from MatrixView.
+     *
      * @tparam T Type of matrix components
+     * @tparam Allocator Allocator of the components
      */
-    template <Arithmetic T>
-    class Matrix
+    template <Arithmetic T, typename Allocator>
+    class Matrix : public MatrixView<T>
     {
     private:
-        T *_data;
-        size_t _width;
-        size_t _height;
+        using MatrixView<T>::_data;
+        using MatrixView<T>::_width;
+        using MatrixView<T>::_height;
+        using MatrixView<T>::_stride;
+        using Traits = std::allocator_traits<Allocator>;
+
+        [[no_unique_address]] Allocator _allocator;
+
+        void allocate();
+        void release();
+        void copySubmatrix(size_t i, size_t j, MatrixView<T> &result) const;
+        T exactDeterminant() const;
+        template <typename Real>
+        static T fromReal(Real value);
 
     public:
         using value_type = T;
+        using allocator_type = Allocator;
 
         Matrix();
-        Matrix(size_t width, size_t height);
+        Matrix(size_t width, size_t height, Padding padding = Padding::None, const Allocator &allocator = Allocator());
         Matrix(std::initializer_list<T> list, size_t width, size_t height);
         Matrix(std::initializer_list<std::initializer_list<T>> list);
         Matrix(const T *data, size_t width, size_t height);
         Matrix(const Matrix &other);
+        Matrix(const MatrixView<T> &view, Padding padding = Padding::None);
         Matrix(Matrix &&other) noexcept;
         Matrix &operator=(Matrix other);
+        template <typename E>
+        Matrix &operator=(const MatrixExpression<E> &expression);
         ~Matrix();
 
-        size_t width() const;
-        size_t height() const;
-        bool isSquare() const;
-        T *data();
-        const T *data() const;
+        Allocator allocator() const;
+        bool isPadded() const;
         Vector<T> reshape() const;
-        Vector<T> row(size_t i) const;
-        void setRow(size_t i, const Vector<T> &vector);
-        T trace() const;
-        Matrix transpose() const;
-        bool isAprrox(const Matrix &other, double epsilon = 1e-8) const;
+        void transposeInPlace();
         Matrix rowEchelon() const;
+        size_t rowEchelonInPlace(double tolerance = 0);
+        LU<T> lu() const;
+        Cholesky<T> cholesky() const;
+        QR<T> qr() const;
         T determinant() const;
         Matrix inverse() const;
+        void inverse(Matrix &result) const;
+        Vector<T> solve(const VectorView<T> &b) const;
+        Matrix solve(const MatrixView<T> &b) const;
+        Vector<T> lstsq(const VectorView<T> &b) const;
         T cofactor(size_t i, size_t j) const;
         Matrix getSubmatrix(size_t i, size_t j) const;
         size_t rank() const;
-
-        VectorView<T> operator[](size_t i);
-        const VectorView<T> operator[](size_t i) const;
-        bool operator==(const Matrix &other) const;
-        Matrix operator+(const Matrix &other) const;
-        Matrix operator-(const Matrix &other) const;
-        Matrix &operator+=(const Matrix &other);
-        Matrix &operator-=(const Matrix &other);
-        Matrix operator*(T scalar) const;
+        size_t rank(double tolerance, bool columnPivoting = false) const;
+
+        Matrix &operator+=(const MatrixView<T> &other);
+        Matrix &operator-=(const MatrixView<T> &other);
+        template <typename E>
+        Matrix &operator+=(const MatrixExpression<E> &expression);
+        template <typename E>
+        Matrix &operator-=(const MatrixExpression<E> &expression);
         Matrix &operator*=(T scalar);
-        Vector<T> operator*(const Vector<T> &vector) const;
-        Matrix operator*(const Matrix &other) const;
-        operator std::string() const;
     };
 
+    /**
+     * @brief Allocate width() * stride() elements, the padding rows are zeroed
+     */
+    template <Arithmetic T, typename Allocator>
+    void Matrix<T, Allocator>::allocate()
+    {
+        size_t size = _width * _stride;
+        _data = size == 0 ? nullptr : Traits::allocate(_allocator, size);
+        if (_stride != _height)
+            for (size_t j = 0; j < _width; j++)
+                std::fill(_data + j * _stride + _height, _data + (j + 1) * _stride, T(0));
+    }
+
+    /**
+     * @brief Return the storage to the allocator
+     */
+    template <Arithmetic T, typename Allocator>
+    void Matrix<T, Allocator>::release()
+    {
+        if (_data)
+            Traits::deallocate(_allocator, _data, _width * _stride);
+        _data = nullptr;
+    }
+
     /**
      * @brief Construct an empty Matrix object
      */
-    template <Arithmetic T>
-    Matrix<T>::Matrix() : _data(nullptr), _width(0), _height(0) {}
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix() : MatrixView<T>(nullptr, 0, 0) {}
 
     /**
      * @brief Construct a new Matrix object with the given width and height
      *
      * @param width Width of the matrix
      * @param height Height of the matrix
+     * @param padding Whether every column starts on an aligned boundary
+     * @param allocator Allocator of the components
      */
-    template <Arithmetic T>
-    Matrix<T>::Matrix(size_t width, size_t height) : _data(new T[width * height]), _width(width), _height(height) {}
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix(size_t width, size_t height, Padding padding, const Allocator &allocator)
+        : MatrixView<T>(nullptr, width, height, padding == Padding::Aligned ? alignedStride<T>(height) : height),
+          _allocator(allocator)
+    {
+        allocate();
+    }
 
     /**
      * @brief Construct a new Matrix object from an initializer list
@@ -98,8 +168,8 @@ namespace m42
      * @param width Width of the matrix
      * @param height Height of the matrix
      */
-    template <Arithmetic T>
-    Matrix<T>::Matrix(std::initializer_list<T> list, size_t width, size_t height) : Matrix(width, height)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix(std::initializer_list<T> list, size_t width, size_t height) : Matrix(width, height)
     {
         if (list.size() != width * height)
             throw std::invalid_argument("Invalid initializer list size");
@@ -114,8 +184,8 @@ namespace m42
      *
      * @param list Initializer list of initializer lists
      */
-    template <Arithmetic T>
-    Matrix<T>::Matrix(std::initializer_list<std::initializer_list<T>> list) : Matrix(list.begin()->size(), list.size())
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix(std::initializer_list<std::initializer_list<T>> list) : Matrix(list.begin()->size(), list.size())
     {
         for (size_t i = 0; i < _height; i++)
             if ((list.begin() + i)->size() != _width)
@@ -131,8 +201,8 @@ namespace m42
      *
      * @param data Pointer to the matrix data
      */
-    template <Arithmetic T>
-    Matrix<T>::Matrix(const T *data, size_t width, size_t height) : Matrix(width, height)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix(const T *data, size_t width, size_t height) : Matrix(width, height)
     {
         for (size_t i = 0; i < width * height; i++)
             _data[i] = data[i];
@@ -141,13 +211,30 @@ namespace m42
     /**
      * @brief Copy constructor
      *
+     * The copy keeps the padding of other.
+     *
      * @param other Matrix to copy
      */
-    template <Arithmetic T>
-    Matrix<T>::Matrix(const Matrix &other) : Matrix(other._width, other._height)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix(const Matrix &other)
+        : MatrixView<T>(nullptr, other._width, other._height, other._stride),
+          _allocator(Traits::select_on_container_copy_construction(other._allocator))
+    {
+        allocate();
+        std::copy(other._data, other._data + _width * _stride, _data);
+    }
+
+    /**
+     * @brief Construct a new Matrix object from the elements of a view
+     *
+     * @param view View to copy, its columns may be strided
+     * @param padding Whether every column of the copy starts on an aligned boundary
+     */
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix(const MatrixView<T> &view, Padding padding) : Matrix(view.width(), view.height(), padding)
     {
-        for (size_t i = 0; i < _width * _height; i++)
-            _data[i] = other._data[i];
+        for (size_t j = 0; j < _width; j++)
+            std::copy(view.data() + j * view.stride(), view.data() + j * view.stride() + _height, _data + j * _stride);
     }
 
     /**
@@ -155,12 +242,15 @@ namespace m42
      *
      * @param other Matrix to move
      */
-    template <Arithmetic T>
-    Matrix<T>::Matrix(Matrix &&other) noexcept : _data(std::move(other._data)), _width(other._width), _height(other._height)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::Matrix(Matrix &&other) noexcept
+        : MatrixView<T>(other._data, other._width, other._height, other._stride),
+          _allocator(std::move(other._allocator))
     {
         other._data = nullptr;
         other._width = 0;
         other._height = 0;
+        other._stride = 0;
     }
 
     /**
@@ -169,232 +259,386 @@ namespace m42
      * @param other Right-hand side of the assignment
      * @return Matrix<T, W, H>& Left-hand side after assignment
      */
-    template <Arithmetic T>
-    Matrix<T> &Matrix<T>::operator=(Matrix<T> other)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> &Matrix<T, Allocator>::operator=(Matrix other)
     {
         // copy and swap idiom
         std::swap(_data, other._data);
         std::swap(_width, other._width);
         std::swap(_height, other._height);
+        std::swap(_stride, other._stride);
+        std::swap(_allocator, other._allocator);
+        return *this;
+    }
+
+    /**
+     * @brief Evaluate an element-wise expression into the matrix
+     *
+     * The existing storage and padding are reused when the dimensions match.
+     *
+     * @param expression Expression to evaluate
+     * @return Matrix<T>& Left-hand side after assignment
+     */
+    template <Arithmetic T, typename Allocator>
+    template <typename E>
+    Matrix<T, Allocator> &Matrix<T, Allocator>::operator=(const MatrixExpression<E> &expression)
+    {
+        if (_width != expression.width() || _height != expression.height())
+            return *this = Matrix(expression);
+        expression.evaluateTo(_data, _stride);
         return *this;
     }
 
     /**
      * @brief Destroy the Matrix object
      */
-    template <Arithmetic T>
-    Matrix<T>::~Matrix()
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator>::~Matrix()
     {
-        delete[] _data;
+        release();
     }
 
     /**
-     * @brief Return the width of the matrix
+     * @brief Get a copy of the allocator of the components
      *
-     * @return size_t Width of the matrix
+     * @return Allocator Allocator of the components
      */
-    template <Arithmetic T>
-    size_t Matrix<T>::width() const
+    template <Arithmetic T, typename Allocator>
+    Allocator Matrix<T, Allocator>::allocator() const
     {
-        return _width;
+        return _allocator;
     }
 
     /**
-     * @brief Return the height of the matrix
+     * @brief Return whether the columns are padded, stride() is then larger than height()
      *
-     * @return size_t Height of the matrix
+     * @return bool Whether the columns are padded
      */
-    template <Arithmetic T>
-    size_t Matrix<T>::height() const
+    template <Arithmetic T, typename Allocator>
+    bool Matrix<T, Allocator>::isPadded() const
     {
-        return _height;
+        return _stride != _height;
     }
 
     /**
-     * @brief Return whether the matrix is square
+     * @brief Reshape the matrix with height 1 into a vector
      *
-     * @tparam T Type of matrix components
-     * @return bool Whether the matrix is square
+     * @return Vector<T> Reshaped matrix
      */
-    template <Arithmetic T>
-    bool Matrix<T>::isSquare() const
+    template <Arithmetic T, typename Allocator>
+    Vector<T> Matrix<T, Allocator>::reshape() const
     {
-        return _width == _height;
+        if (_height > 1)
+            throw std::invalid_argument("Matrix must be a row vector");
+        if (_height == 1 && _stride != 1)
+            return Vector<T>(MatrixView<T>::row(0));
+        return Vector<T>(_data, _width * _height);
     }
 
     /**
-     * @brief Return a pointer to the matrix data
+     * @brief Transpose the matrix in place
      *
-     * @return const T* Pointer to the matrix data
+     * Square matrices are transposed by recursive block swaps, rectangular
+     * ones by following the cycles of the permutation, which needs one bit
+     * per element instead of a second buffer. Padded matrices go through a
+     * padded buffer of the transposed shape.
      */
-    template <Arithmetic T>
-    T *Matrix<T>::data()
+    template <Arithmetic T, typename Allocator>
+    void Matrix<T, Allocator>::transposeInPlace()
     {
-        return _data;
+        if (isPadded())
+        {
+            Matrix result(_height, _width, Padding::Aligned, _allocator);
+            blas::transpose(_height, _width, _data, _stride, result._data, result._stride);
+            *this = std::move(result);
+            return;
+        }
+        if (MatrixView<T>::isSquare())
+            blas::transposeSquare(_width, _data, _height);
+        else
+            blas::transposeCycles(_height, _width, _data);
+        std::swap(_width, _height);
+        _stride = _height;
     }
 
     /**
-     * @brief Return a const pointer to the matrix data
+     * @brief Return the reduced row echelon form of the matrix
      *
-     * @return const T* Const pointer to the matrix data
+     * @return Matrix<T> Row echelon form of the matrix
      */
-    template <Arithmetic T>
-    const T *Matrix<T>::data() const
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> Matrix<T, Allocator>::rowEchelon() const
     {
-        return _data;
+        Matrix result(*this);
+        result.rowEchelonInPlace();
+        return result;
     }
 
     /**
-     * @brief Reshape the matrix with height 1 into a vector
+     * @brief Reduce the matrix to its reduced row echelon form in place
      *
-     * @return Vector<T> Reshaped matrix
+     * Works directly on the column-major buffer without allocating: row
+     * interchanges and the scaling of the pivot row touch one element per
+     * column, the elimination is one axpy per column with the pivot column
+     * as multipliers.
+     *
+     * @param tolerance Pivots not larger than tolerance times the largest
+     * absolute entry are treated as zero
+     * @return size_t Number of pivots found
      */
-    template <Arithmetic T>
-    Vector<T> Matrix<T>::reshape() const
+    template <Arithmetic T, typename Allocator>
+    size_t Matrix<T, Allocator>::rowEchelonInPlace(double tolerance)
     {
-        if (_height > 1)
-            throw std::invalid_argument("Matrix must be a row vector");
-        return Vector<T>(_data, _width * _height);
+        T largest = 0;
+        for (size_t c = 0; c < _width; c++)
+            largest = std::max(largest, simd::maxAbs(_data + c * _stride, _height));
+        double threshold = tolerance * static_cast<double>(largest);
+        size_t row = 0;
+        for (size_t col = 0; col < _width && row < _height; col++)
+        {
+            T *pivotColumn = _data + col * _stride;
+            // find pivot
+            size_t pivot = row;
+            for (size_t i = row + 1; i < _height; i++)
+                if (simd::scalarAbs(pivotColumn[i]) > simd::scalarAbs(pivotColumn[pivot]))
+                    pivot = i;
+            if (static_cast<double>(simd::scalarAbs(pivotColumn[pivot])) <= threshold)
+                continue;
+            T value = pivotColumn[pivot];
+            // swap rows and scale the pivot row, columns left of col are zero in both rows
+            for (size_t c = col; c < _width; c++)
+            {
+                T *column = _data + c * _stride;
+                std::swap(column[row], column[pivot]);
+                column[row] /= value;
+            }
+            // subtract the pivot row from every other row
+            pivotColumn[row] = 0;
+            for (size_t c = col + 1; c < _width; c++)
+            {
+                T *column = _data + c * _stride;
+                simd::axpy(static_cast<T>(-column[row]), pivotColumn, column, _height);
+            }
+            std::fill(pivotColumn, pivotColumn + _height, T(0));
+            pivotColumn[row] = 1;
+            row++;
+        }
+        return row;
     }
 
     /**
-     * @brief Return an i-th row of the matrix
+     * @brief Return the LU factorization of the matrix with partial pivoting
      *
-     * @param i Index of the row
-     * @return Vector<T> i-th row of the matrix
+     * @return LU<T> Factorization, reusable for determinants and solves
      */
-    template <Arithmetic T>
-    Vector<T> Matrix<T>::row(size_t i) const
+    template <Arithmetic T, typename Allocator>
+    LU<T> Matrix<T, Allocator>::lu() const
     {
-        // data is stored in column-major order
-        Vector<T> result(_width);
-        for (size_t j = 0; j < _width; j++)
-            result[j] = (*this)[j][i];
-        return result;
+        return LU<T>(*this);
     }
 
     /**
-     * @brief Set an i-th row of the matrix
+     * @brief Return the Cholesky factorization of a symmetric positive definite matrix
+     *
+     * Only the lower triangle is read.
      *
-     * @param i Index of the row
-     * @param vector Vector to set the row to
+     * @return Cholesky<T> Factorization, reusable for determinants and solves
      */
-    template <Arithmetic T>
-    void Matrix<T>::setRow(size_t i, const Vector<T> &vector)
+    template <Arithmetic T, typename Allocator>
+    Cholesky<T> Matrix<T, Allocator>::cholesky() const
     {
-        if (_width != vector.size())
-            throw std::invalid_argument("Matrix width must be equal to vector size");
-        // data is stored in column-major order
-        for (size_t j = 0; j < _width; j++)
-            (*this)[j][i] = vector[j];
+        return Cholesky<T>(*this);
     }
 
     /**
-     * @brief Return the trace of the matrix
+     * @brief Return the Householder QR factorization of the matrix
      *
-     * @return T Trace of the matrix
+     * @return QR<T> Factorization, reusable for least-squares solves
      */
-    template <Arithmetic T>
-    T Matrix<T>::trace() const
+    template <Arithmetic T, typename Allocator>
+    QR<T> Matrix<T, Allocator>::qr() const
     {
-        if (!isSquare())
+        return QR<T>(*this);
+    }
+
+    /**
+     * @brief Return the determinant of the matrix
+     *
+     * Floating-point matrices use the LU factorization. Integer matrices use
+     * fraction-free Bareiss elimination in 128-bit integers, which is exact
+     * and throws std::overflow_error when a product of two minors does not
+     * fit. A signed result must fit in T, an unsigned one is reduced modulo
+     * 2^N like any other unsigned arithmetic.
+     *
+     * @return T Determinant of the matrix
+     */
+    template <Arithmetic T, typename Allocator>
+    T Matrix<T, Allocator>::determinant() const
+    {
+        if (!MatrixView<T>::isSquare())
             throw std::invalid_argument("Matrix must be square");
-        T result = 0;
-        for (size_t i = 0; i < _width; i++)
-            result += (*this)[i][i];
-        return result;
+        if constexpr (std::is_integral_v<T>)
+            return exactDeterminant();
+        else
+            return LU<T>::determinantOf(*this);
     }
 
     /**
-     * @brief Return the transpose of the matrix
+     * @brief Determinant of an integer matrix by Bareiss elimination
      *
-     * @return Matrix<T> Transpose of the matrix
+     * After step k every remaining element is a (k + 1) x (k + 1) minor of
+     * the matrix, so each division by the previous pivot is exact.
+     *
+     * @return T Determinant of the matrix
      */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::transpose() const
+    template <Arithmetic T, typename Allocator>
+    T Matrix<T, Allocator>::exactDeterminant() const
+    {
+        using Wide = __int128;
+        size_t n = _height;
+        ScratchScope scope;
+        Wide *a = ScratchAllocator<Wide>().allocate(n * n);
+        for (size_t j = 0; j < n; j++)
+            std::copy(_data + j * _stride, _data + j * _stride + n, a + j * n);
+        Wide previous = 1;
+        Wide sign = 1;
+        for (size_t k = 0; k < n; k++)
+        {
+            size_t p = k;
+            while (p < n && a[k * n + p] == 0)
+                p++;
+            if (p == n)
+                return 0;
+            if (p != k)
+            {
+                for (size_t j = k; j < n; j++)
+                    std::swap(a[j * n + k], a[j * n + p]);
+                sign = -sign;
+            }
+            Wide pivot = a[k * n + k];
+            for (size_t j = k + 1; j < n; j++)
+                for (size_t i = k + 1; i < n; i++)
+                {
+                    Wide kept;
+                    Wide eliminated;
+                    Wide difference;
+                    if (__builtin_mul_overflow(a[j * n + i], pivot, &kept) ||
+                        __builtin_mul_overflow(a[k * n + i], a[j * n + k], &eliminated) ||
+                        __builtin_sub_overflow(kept, eliminated, &difference))
+                        throw std::overflow_error("Determinant does not fit in 128 bits");
+                    a[j * n + i] = difference / previous;
+                }
+            previous = pivot;
+        }
+        Wide result = sign * previous;
+        if constexpr (std::is_signed_v<T>)
+            if (result < std::numeric_limits<T>::min() || result > std::numeric_limits<T>::max())
+                throw std::overflow_error("Determinant does not fit in the element type");
+        return static_cast<T>(result);
+    }
+
+    /**
+     * @brief Convert an element computed in floating point to the element type
+     *
+     * Integer results are rounded to the nearest integer, truncation would
+     * turn 0.9999999 into 0.
+     *
+     * @param value Element computed in floating point
+     * @return T Element of the matrix type
+     */
+    template <Arithmetic T, typename Allocator>
+    template <typename Real>
+    T Matrix<T, Allocator>::fromReal(Real value)
     {
-        Matrix<T> result(_height, _width);
-        for (size_t i = 0; i < _height; i++)
-            result[i] = row(i);
-        return result;
+        if constexpr (std::is_integral_v<T>)
+            return static_cast<T>(std::round(value));
+        else
+            return static_cast<T>(value);
     }
 
     /**
-     * @brief Return whether the matrix is approximately equal to another matrix
+     * @brief Solve the linear system A * x = b
      *
-     * @param other Matrix to compare to
-     * @param epsilon Epsilon
-     * @return bool Whether the matrix is approximately equal to the other matrix
+     * The matrix is factored on every call, keep the result of lu() to solve
+     * several systems with the same matrix. For integral T the solution is
+     * rounded to the nearest integer.
+     *
+     * @param b Right-hand side
+     * @return Vector<T> Solution
      */
-    template <Arithmetic T>
-    bool Matrix<T>::isAprrox(const Matrix<T> &other, double epsilon) const
+    template <Arithmetic T, typename Allocator>
+    Vector<T> Matrix<T, Allocator>::solve(const VectorView<T> &b) const
     {
-        if (_width != other._width || _height != other._height)
-            return false;
-        for (size_t i = 0; i < _width; i++)
-            if (!(*this)[i].isApprox(other[i], epsilon))
-                return false;
-        return true;
+        LU<T> factorization(*this);
+        if constexpr (std::is_same_v<T, typename LU<T>::value_type>)
+            return factorization.solve(b);
+        else
+        {
+            Vector<typename LU<T>::value_type> x(b.size());
+            for (size_t i = 0; i < b.size(); i++)
+                x[i] = b[i];
+            factorization.solveInPlace(x);
+            Vector<T> result(b.size());
+            for (size_t i = 0; i < b.size(); i++)
+                result[i] = fromReal(x[i]);
+            return result;
+        }
     }
 
     /**
-     * @brief Return the row echelon form of the matrix
+     * @brief Solve the linear systems A * X = B, one per column of B
      *
-     * @return Matrix<T> Row echelon form of the matrix
+     * @param b Right-hand sides, one per column, a matrix or a block of one
+     * @return Matrix<T> Solutions, one per column
      */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::rowEchelon() const
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> Matrix<T, Allocator>::solve(const MatrixView<T> &b) const
     {
-        Matrix<T> result(*this);
-        size_t row = 0;
-        size_t col = 0;
-        while (row < _height && col < _width)
+        LU<T> factorization(*this);
+        if constexpr (std::is_same_v<Matrix, Matrix<typename LU<T>::value_type>>)
+            return factorization.solve(b);
+        else
         {
-            // find pivot
-            size_t pivot = row;
-            for (size_t i = row + 1; i < _height; i++)
-                if (std::abs(result[col][i]) > std::abs(result[col][pivot]))
-                    pivot = i;
-            if (result[col][pivot] == 0)
-            {
-                col++;
-                continue;
-            }
-            // swap rows
-            if (pivot != row)
-            {
-                Vector tmp = result.row(pivot);
-                result.setRow(pivot, result.row(row));
-                result.setRow(row, tmp);
-            }
-            result.setRow(row, result.row(row) / result[col][row]);
-            // subtract row from other rows
-            for (size_t i = 0; i < _height; i++)
-                if (i != row)
-                    result.setRow(i, result.row(i) - result.row(row) * result[col][i]);
-            row++;
-            col++;
+            Matrix<typename LU<T>::value_type> x(b.width(), b.height());
+            for (size_t j = 0; j < b.width(); j++)
+                for (size_t i = 0; i < b.height(); i++)
+                    x[j][i] = b[j][i];
+            factorization.solveInPlace(x);
+            Matrix result(b.width(), b.height());
+            for (size_t j = 0; j < b.width(); j++)
+                for (size_t i = 0; i < b.height(); i++)
+                    result[j][i] = fromReal(x[j][i]);
+            return result;
         }
-        return result;
     }
 
     /**
-     * @brief Return the determinant of the matrix
+     * @brief Return the least-squares solution of an overdetermined system
      *
-     * @return T Determinant of the matrix
+     * Minimizes ||A * x - b|| through the QR factorization, the matrix must
+     * have at least as many rows as columns and full column rank.
+     * For integral T the solution is rounded to the nearest integer.
+     *
+     * @param b Right-hand side of height() values
+     * @return Vector<T> Solution of width() values
      */
-    template <Arithmetic T>
-    T Matrix<T>::determinant() const
+    template <Arithmetic T, typename Allocator>
+    Vector<T> Matrix<T, Allocator>::lstsq(const VectorView<T> &b) const
     {
-        if (!isSquare())
-            throw std::invalid_argument("Matrix must be square");
-        // Laplace expansion
-        if (_width == 1)
-            return (*this)[0][0];
-        T result = 0;
-        for (size_t i = 0; i < _width; i++)
-            result += (*this)[i][0] * cofactor(i, 0);
-        return result;
+        QR<T> factorization(*this);
+        if constexpr (std::is_same_v<T, typename QR<T>::value_type>)
+            return factorization.lstsq(b);
+        else
+        {
+            Vector<typename QR<T>::value_type> converted(b.size());
+            for (size_t i = 0; i < b.size(); i++)
+                converted[i] = b[i];
+            Vector<typename QR<T>::value_type> x = factorization.lstsq(converted);
+            Vector<T> result(x.size());
+            for (size_t i = 0; i < x.size(); i++)
+                result[i] = fromReal(x[i]);
+            return result;
+        }
     }
 
     /**
@@ -402,18 +646,38 @@ namespace m42
      *
      * @return Matrix<T> Inverse of the matrix
      */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::inverse() const
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> Matrix<T, Allocator>::inverse() const
     {
-        if (!isSquare())
-            throw std::invalid_argument("Matrix must be square");
-        if (determinant() == 0)
-            throw std::invalid_argument("Matrix must be invertible");
-        Matrix<T> result(_width, _height);
-        for (size_t i = 0; i < _width; i++)
-            for (size_t j = 0; j < _height; j++)
-                result[i][j] = cofactor(j, i);
-        return result * (1 / determinant());
+        Matrix result;
+        inverse(result);
+        return result;
+    }
+
+    /**
+     * @brief Write the inverse of the matrix into a caller-supplied matrix
+     *
+     * The inverse is computed from the pivoted LU factorization, rounded to
+     * the nearest integer for integral T. The storage of result is reused
+     * when it already has the right size.
+     *
+     * @param result Matrix to write the inverse to
+     */
+    template <Arithmetic T, typename Allocator>
+    void Matrix<T, Allocator>::inverse(Matrix &result) const
+    {
+        LU<T> factorization(*this);
+        if constexpr (std::is_same_v<Matrix, Matrix<typename LU<T>::value_type>>)
+            factorization.inverse(result);
+        else
+        {
+            Matrix<typename LU<T>::value_type> inverse = factorization.inverse();
+            if (result._width != _width || result._height != _height)
+                result = Matrix(_width, _height);
+            for (size_t j = 0; j < _width; j++)
+                for (size_t i = 0; i < _height; i++)
+                    result[j][i] = fromReal(inverse[j][i]);
+        }
     }
 
     /**
@@ -423,15 +687,17 @@ namespace m42
      * @param j Column index
      * @return T Cofactor of the matrix
      */
-    template <Arithmetic T>
-    T Matrix<T>::cofactor(size_t i, size_t j) const
+    template <Arithmetic T, typename Allocator>
+    T Matrix<T, Allocator>::cofactor(size_t i, size_t j) const
     {
-        if (!isSquare())
+        if (!MatrixView<T>::isSquare())
             throw std::invalid_argument("Matrix must be square");
         if (_width == 1)
             return 1;
-        // Laplace expansion
-        Matrix<T> submatrix = getSubmatrix(i, j);
+        // Laplace expansion, the minor only lives until the determinant is known
+        ScratchScope scope;
+        ScratchMatrix<T> submatrix(_width - 1, _height - 1);
+        copySubmatrix(i, j, submatrix);
         return std::pow(-1, i + j) * submatrix.determinant();
     }
 
@@ -442,12 +708,26 @@ namespace m42
      * @param j Column index
      * @return Matrix<T> Submatrix of the matrix
      */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::getSubmatrix(size_t i, size_t j) const
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> Matrix<T, Allocator>::getSubmatrix(size_t i, size_t j) const
     {
-        if (!isSquare())
+        if (!MatrixView<T>::isSquare())
             throw std::invalid_argument("Matrix must be square");
-        Matrix<T> result(_width - 1, _height - 1);
+        Matrix result(_width - 1, _height - 1);
+        copySubmatrix(i, j, result);
+        return result;
+    }
+
+    /**
+     * @brief Copy the matrix without column i and row j into result
+     *
+     * @param i Column index
+     * @param j Row index
+     * @param result Destination of size (width() - 1) x (height() - 1)
+     */
+    template <Arithmetic T, typename Allocator>
+    void Matrix<T, Allocator>::copySubmatrix(size_t i, size_t j, MatrixView<T> &result) const
+    {
         size_t row = 0;
         size_t col = 0;
         for (size_t k = 0; k < _width; k++)
@@ -464,106 +744,82 @@ namespace m42
             row = 0;
             col++;
         }
-        return result;
-    }
-
-    /**
-     * @brief Return the rank of the matrix
-     *
-     * @return size_t Rank of the matrix
-     */
-    template <Arithmetic T>
-    size_t Matrix<T>::rank() const
-    {
-        Matrix echelon = rowEchelon();
-        size_t rank = 0;
-        for (size_t i = 0; i < _height; i++)
-        {
-            bool isZero = true;
-            for (size_t j = 0; j < _width; j++)
-                if (echelon[j][i] != 0)
-                    isZero = false;
-            if (!isZero)
-                rank++;
-        }
-        return rank;
     }
 
     /**
-     * @brief Return an i-th vector of the matrix
+     * @brief Return the numerical rank of the matrix
      *
-     * @param i Index of the vector
-     * @return VectorView<T> i-th vector of the matrix
-     */
-    template <Arithmetic T>
-    VectorView<T> Matrix<T>::operator[](size_t i)
-    {
-        return VectorView(_data + i * _height, _height);
-    }
-
-    /**
-     * @brief Return an i-th vector of the matrix
+     * Uses a relative tolerance of max(width, height) times the machine
+     * epsilon of the working precision.
      *
-     * @param i Index of the vector
-     * @return Vector<const T> i-th vector of the matrix
+     * @return size_t Rank of the matrix
      */
-    template <Arithmetic T>
-    const VectorView<T> Matrix<T>::operator[](size_t i) const
+    template <Arithmetic T, typename Allocator>
+    size_t Matrix<T, Allocator>::rank() const
     {
-        return VectorView(_data + i * _height, _height);
+        using Real = typename LU<T>::value_type;
+        return rank(static_cast<double>(std::max(_width, _height)) * std::numeric_limits<Real>::epsilon());
     }
 
     /**
-     * @brief Return whether the matrix is equal to another matrix
+     * @brief Return the numerical rank of the matrix
      *
-     * @param other Matrix to compare to
-     * @return bool Whether the matrix is equal to the other matrix
-     */
-    template <Arithmetic T>
-    bool Matrix<T>::operator==(const Matrix<T> &other) const
-    {
-        if (_width != other._width || _height != other._height)
-            return false;
-        if (_data == other._data)
-            return true;
-        for (size_t i = 0; i < _width; i++)
-            if ((*this)[i] != other[i])
-                return false;
-        return true;
-    }
-
-    /**
-     * @brief Return the sum of the matrix and another matrix
+     * Gaussian elimination in floating point on a single working copy. With
+     * column pivoting the largest remaining entry is chosen as pivot, which
+     * is slower but reliable when the rank is decided by the tolerance.
      *
-     * @param other Matrix to add
-     * @return Matrix<T> Sum of the matrix and the other matrix
+     * @param tolerance Pivots not larger than tolerance times the largest
+     * absolute entry are treated as zero
+     * @param columnPivoting Whether to search the whole trailing submatrix for pivots
+     * @return size_t Rank of the matrix
      */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::operator+(const Matrix<T> &other) const
+    template <Arithmetic T, typename Allocator>
+    size_t Matrix<T, Allocator>::rank(double tolerance, bool columnPivoting) const
     {
-        if (_width != other._width || _height != other._height)
-            throw std::invalid_argument("Matrices must have the same size");
-        Matrix<T> result(_width, _height);
-        for (size_t i = 0; i < _width; i++)
-            result[i] = (*this)[i] + other[i];
-        return result;
-    }
+        using Real = typename LU<T>::value_type;
+        size_t m = _height;
+        size_t n = _width;
+        ScratchScope scope;
+        Real *a = ScratchAllocator<Real>().allocate(m * n);
+        for (size_t c = 0; c < n; c++)
+            std::copy(_data + c * _stride, _data + c * _stride + m, a + c * m);
+        Real threshold = static_cast<Real>(tolerance) * simd::maxAbs(a, m * n);
 
-    /**
-     * @brief Return the difference of the matrix and another matrix
-     *
-     * @param other Matrix to subtract
-     * @return Matrix<T> Difference of the matrix and the other matrix
-     */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::operator-(const Matrix<T> &other) const
-    {
-        if (_width != other._width || _height != other._height)
-            throw std::invalid_argument("Matrices must have the same size");
-        Matrix<T> result(_width, _height);
-        for (size_t i = 0; i < _width; i++)
-            result[i] = (*this)[i] - other[i];
-        return result;
+        size_t rank = 0;
+        for (size_t col = 0; col < n && rank < m; col++)
+        {
+            size_t pivotRow = rank;
+            size_t pivotCol = col;
+            for (size_t c = col; c < (columnPivoting ? n : col + 1); c++)
+                for (size_t i = rank; i < m; i++)
+                    if (std::abs(a[c * m + i]) > std::abs(a[pivotCol * m + pivotRow]))
+                    {
+                        pivotRow = i;
+                        pivotCol = c;
+                    }
+            Real value = a[pivotCol * m + pivotRow];
+            if (std::abs(value) <= threshold)
+            {
+                // with column pivoting every remaining entry is negligible
+                if (columnPivoting)
+                    break;
+                continue;
+            }
+            // columns are contiguous, swapping them is cheap
+            if (pivotCol != col)
+                std::swap_ranges(a + pivotCol * m, a + (pivotCol + 1) * m, a + col * m);
+            for (size_t c = col; c < n; c++)
+                std::swap(a[c * m + rank], a[c * m + pivotRow]);
+            Real *multipliers = a + col * m + rank + 1;
+            simd::multiply(multipliers, Real(1) / value, multipliers, m - rank - 1);
+            for (size_t c = col + 1; c < n; c++)
+            {
+                Real *column = a + c * m;
+                simd::axpy(-column[rank], multipliers, column + rank + 1, m - rank - 1);
+            }
+            rank++;
+        }
+        return rank;
     }
 
     /**
@@ -572,10 +828,10 @@ namespace m42
      * @param other Matrix to add
      * @return Matrix<T>& Result of addition
      */
-    template <Arithmetic T>
-    Matrix<T> &Matrix<T>::operator+=(const Matrix<T> &other)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> &Matrix<T, Allocator>::operator+=(const MatrixView<T> &other)
     {
-        (*this) = (*this) + other;
+        MatrixView<T>::operator+=(other);
         return *this;
     }
 
@@ -585,123 +841,50 @@ namespace m42
      * @param other Matrix to subtract
      * @return Matrix<T>& Result of subtraction
      */
-    template <Arithmetic T>
-    Matrix<T> &Matrix<T>::operator-=(const Matrix<T> &other)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> &Matrix<T, Allocator>::operator-=(const MatrixView<T> &other)
     {
-        (*this) = (*this) - other;
+        MatrixView<T>::operator-=(other);
         return *this;
     }
 
-    /**
-     * @brief Multiply the matrix by a scalar
-     *
-     * @param scalar Scalar to multiply by
-     * @return Matrix<T> Result of multiplication
-     */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::operator*(T scalar) const
-    {
-        Matrix<T> result(_width, _height);
-        for (size_t i = 0; i < _width; i++)
-            result[i] = (*this)[i] * scalar;
-        return result;
-    }
-
     /**
      * @brief Multiply the matrix by a scalar and assign the result to the matrix
      *
      * @param scalar Scalar to multiply by
      * @return Matrix<T>& Result of multiplication
      */
-    template <Arithmetic T>
-    Matrix<T> &Matrix<T>::operator*=(T scalar)
+    template <Arithmetic T, typename Allocator>
+    Matrix<T, Allocator> &Matrix<T, Allocator>::operator*=(T scalar)
     {
-        (*this) = (*this) * scalar;
+        MatrixView<T>::operator*=(scalar);
         return *this;
     }
 
     /**
-     * @brief Multiply the matrix by a vector
+     * @brief Add an element-wise expression to the matrix in a single pass
      *
-     * @param vector Vector to multiply by
-     * @return Matrix<T> Result of multiplication
-     */
-    template <Arithmetic T>
-    Vector<T> Matrix<T>::operator*(const Vector<T> &vector) const
-    {
-        if (_width != vector.size())
-            throw std::invalid_argument("Matrix width must be equal to vector size");
-        Vector<T> result(_height);
-        for (size_t i = 0; i < _height; i++)
-            result[i] = (*this).row(i) * vector;
-        return result;
-    }
-
-    /**
-     * @brief Multiply the matrix by another matrix
-     *
-     * @param other Matrix to multiply by
-     * @return Matrix<T> Result of multiplication
-     */
-    template <Arithmetic T>
-    Matrix<T> Matrix<T>::operator*(const Matrix<T> &other) const
-    {
-        if (_width != other._height)
-            throw std::invalid_argument("Matrix width must be equal to other matrix height");
-        Matrix<T> result(other._width, _height);
-        for (size_t i = 0; i < other._width; i++)
-            result[i] = (*this) * other[i];
-        return result;
-    }
-
-    /**
-     * @brief Return a string representation of the matrix
-     *
-     * @return std::string String representation of the matrix
-     */
-    template <Arithmetic T>
-    Matrix<T>::operator std::string() const
-    {
-        // column-major order
-        std::string str = "[";
-        for (size_t i = 0; i < _height; i++)
-        {
-            for (size_t j = 0; j < _width; j++)
-            {
-                str += std::to_string((*this)[j][i]);
-                if (j != _width - 1)
-                    str += " ";
-                else if (i != _height - 1)
-                    str += "\n ";
-            }
-        }
-        str += "]";
-        return str;
-    }
-
-    /**
-     * @brief fmt::formatter specialization for Matrix
-     *
-     * @param v Matrix to format
-     * @return auto Matrix formatted as a string
+     * @param expression Expression to add
+     * @return Matrix<T>& Result of addition
      */
-    template <Arithmetic T>
-    auto format_as(const Matrix<T> &v)
+    template <Arithmetic T, typename Allocator>
+    template <typename E>
+    Matrix<T, Allocator> &Matrix<T, Allocator>::operator+=(const MatrixExpression<E> &expression)
     {
-        return static_cast<std::string>(v);
+        return (*this) = (*this) + expression;
     }
 
     /**
-     * @brief Output stream operator for Matrix
+     * @brief Subtract an element-wise expression from the matrix in a single pass
      *
-     * @param os Output stream
-     * @param m Matrix to output
-     * @return std::ostream& Output stream
+     * @param expression Expression to subtract
+     * @return Matrix<T>& Result of subtraction
      */
-    template <Arithmetic T>
-    std::ostream &operator<<(std::ostream &os, const Matrix<T> &m)
+    template <Arithmetic T, typename Allocator>
+    template <typename E>
+    Matrix<T, Allocator> &Matrix<T, Allocator>::operator-=(const MatrixExpression<E> &expression)
     {
-        return os << static_cast<std::string>(m);
+        return (*this) = (*this) - expression;
     }
 
 }
@@ -0,0 +1,582 @@
+#ifndef M42_MATRIX_VIEW_HPP
+#define M42_MATRIX_VIEW_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+#include "ThreadPool.hpp"
+#include "blas.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class VectorView;
+
+    /**
+     * @brief Represents column-major data in memory as a matrix
+     *
+     * Columns are height() elements long and start stride() elements apart,
+     * so a view can refer to a rectangular block of a larger matrix without
+     * copying it.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class MatrixView
+    {
+    protected:
+        T *_data;
+        size_t _width;
+        size_t _height;
+        size_t _stride;
+
+    public:
+        using value_type = T;
+
+        MatrixView() = delete;
+        MatrixView(T *data, size_t width, size_t height);
+        MatrixView(T *data, size_t width, size_t height, size_t stride);
+        MatrixView(const MatrixView &other) = default;
+        MatrixView &operator=(const MatrixView &other);
+        ~MatrixView() = default;
+
+        size_t width() const;
+        size_t height() const;
+        size_t stride() const;
+        bool isSquare() const;
+        bool isContiguous() const;
+        T *data();
+        const T *data() const;
+        MatrixView block(size_t column, size_t row, size_t width, size_t height);
+        const MatrixView block(size_t column, size_t row, size_t width, size_t height) const;
+        VectorView<T> row(size_t i);
+        const VectorView<T> row(size_t i) const;
+        VectorView<T> diagonal();
+        const VectorView<T> diagonal() const;
+        void setRow(size_t i, const VectorView<T> &vector);
+        T trace() const;
+        Matrix<T> transpose(Execution policy = Execution::Parallel) const;
+        bool isAprrox(const MatrixView &other, double epsilon = 1e-8) const;
+        void multiply(const VectorView<T> &x, VectorView<T> &y) const;
+
+        VectorView<T> operator[](size_t i);
+        const VectorView<T> operator[](size_t i) const;
+        bool operator==(const MatrixView &other) const;
+        MatrixView &operator+=(const MatrixView &other);
+        MatrixView &operator-=(const MatrixView &other);
+        MatrixView &operator*=(T scalar);
+        Vector<T> operator*(const VectorView<T> &vector) const;
+        Matrix<T> operator*(const MatrixView &other) const;
+        operator std::string() const;
+    };
+
+    /**
+     * @brief Construct a view of contiguous column-major data
+     *
+     * @param data Pointer to the first element
+     * @param width Number of columns
+     * @param height Number of rows
+     */
+    template <Arithmetic T>
+    MatrixView<T>::MatrixView(T *data, size_t width, size_t height)
+        : _data(data), _width(width), _height(height), _stride(height) {}
+
+    /**
+     * @brief Construct a view of column-major data with a leading dimension
+     *
+     * @param data Pointer to the first element
+     * @param width Number of columns
+     * @param height Number of rows
+     * @param stride Distance between the starts of two columns, at least height
+     */
+    template <Arithmetic T>
+    MatrixView<T>::MatrixView(T *data, size_t width, size_t height, size_t stride)
+        : _data(data), _width(width), _height(height), _stride(stride)
+    {
+        if (stride < height)
+            throw std::invalid_argument("Stride must not be smaller than height");
+    }
+
+    /**
+     * @brief Copy the elements of another view into the viewed memory
+     *
+     * @param other View to copy
+     * @return MatrixView& Reference to self
+     */
+    template <Arithmetic T>
+    MatrixView<T> &MatrixView<T>::operator=(const MatrixView &other)
+    {
+        if (_width != other._width || _height != other._height)
+            throw std::invalid_argument("Matrices must have the same size");
+        if (_data == other._data && _stride == other._stride)
+            return *this;
+        for (size_t j = 0; j < _width; j++)
+            std::copy(other._data + j * other._stride, other._data + j * other._stride + _height, _data + j * _stride);
+        return *this;
+    }
+
+    /**
+     * @brief Return the width of the matrix
+     *
+     * @return size_t Width of the matrix
+     */
+    template <Arithmetic T>
+    size_t MatrixView<T>::width() const
+    {
+        return _width;
+    }
+
+    /**
+     * @brief Return the height of the matrix
+     *
+     * @return size_t Height of the matrix
+     */
+    template <Arithmetic T>
+    size_t MatrixView<T>::height() const
+    {
+        return _height;
+    }
+
+    /**
+     * @brief Return the distance between the starts of two columns
+     *
+     * @return size_t Leading dimension of the viewed memory
+     */
+    template <Arithmetic T>
+    size_t MatrixView<T>::stride() const
+    {
+        return _stride;
+    }
+
+    /**
+     * @brief Return whether the matrix is square
+     *
+     * @return bool Whether the matrix is square
+     */
+    template <Arithmetic T>
+    bool MatrixView<T>::isSquare() const
+    {
+        return _width == _height;
+    }
+
+    /**
+     * @brief Return whether the columns follow each other without gaps
+     *
+     * @return bool Whether the elements form one contiguous range
+     */
+    template <Arithmetic T>
+    bool MatrixView<T>::isContiguous() const
+    {
+        return _stride == _height || _width <= 1;
+    }
+
+    /**
+     * @brief Return a pointer to the first element
+     *
+     * @return T* Pointer to the matrix data
+     */
+    template <Arithmetic T>
+    T *MatrixView<T>::data()
+    {
+        return _data;
+    }
+
+    /**
+     * @brief Return a const pointer to the first element
+     *
+     * @return const T* Const pointer to the matrix data
+     */
+    template <Arithmetic T>
+    const T *MatrixView<T>::data() const
+    {
+        return _data;
+    }
+
+    /**
+     * @brief Return a view of a rectangular block of the matrix
+     *
+     * @param column Index of the first column of the block
+     * @param row Index of the first row of the block
+     * @param width Number of columns of the block
+     * @param height Number of rows of the block
+     * @return MatrixView<T> View sharing the memory of the matrix
+     */
+    template <Arithmetic T>
+    MatrixView<T> MatrixView<T>::block(size_t column, size_t row, size_t width, size_t height)
+    {
+        if (column + width > _width || row + height > _height)
+            throw std::out_of_range("Block out of range");
+        return MatrixView<T>(_data + column * _stride + row, width, height, _stride);
+    }
+
+    /**
+     * @brief Return a view of a rectangular block of the matrix
+     *
+     * @param column Index of the first column of the block
+     * @param row Index of the first row of the block
+     * @param width Number of columns of the block
+     * @param height Number of rows of the block
+     * @return const MatrixView<T> View sharing the memory of the matrix
+     */
+    template <Arithmetic T>
+    const MatrixView<T> MatrixView<T>::block(size_t column, size_t row, size_t width, size_t height) const
+    {
+        return const_cast<MatrixView<T> *>(this)->block(column, row, width, height);
+    }
+
+    /**
+     * @brief Return an i-th row of the matrix
+     *
+     * @param i Index of the row
+     * @return VectorView<T> View of the i-th row, strided in column-major storage
+     */
+    template <Arithmetic T>
+    VectorView<T> MatrixView<T>::row(size_t i)
+    {
+        if (i >= _height)
+            throw std::out_of_range("Index out of range");
+        // data is stored in column-major order
+        return VectorView<T>(_data + i, _width, _stride);
+    }
+
+    /**
+     * @brief Return an i-th row of the matrix
+     *
+     * @param i Index of the row
+     * @return const VectorView<T> View of the i-th row, strided in column-major storage
+     */
+    template <Arithmetic T>
+    const VectorView<T> MatrixView<T>::row(size_t i) const
+    {
+        return const_cast<MatrixView<T> *>(this)->row(i);
+    }
+
+    /**
+     * @brief Return the main diagonal of the matrix
+     *
+     * @return VectorView<T> View of the min(width, height) diagonal elements
+     */
+    template <Arithmetic T>
+    VectorView<T> MatrixView<T>::diagonal()
+    {
+        return VectorView<T>(_data, std::min(_width, _height), _stride + 1);
+    }
+
+    /**
+     * @brief Return the main diagonal of the matrix
+     *
+     * @return const VectorView<T> View of the min(width, height) diagonal elements
+     */
+    template <Arithmetic T>
+    const VectorView<T> MatrixView<T>::diagonal() const
+    {
+        return const_cast<MatrixView<T> *>(this)->diagonal();
+    }
+
+    /**
+     * @brief Set an i-th row of the matrix
+     *
+     * @param i Index of the row
+     * @param vector Vector to set the row to
+     */
+    template <Arithmetic T>
+    void MatrixView<T>::setRow(size_t i, const VectorView<T> &vector)
+    {
+        if (_width != vector.size())
+            throw std::invalid_argument("Matrix width must be equal to vector size");
+        if (i >= _height)
+            throw std::out_of_range("Index out of range");
+        // data is stored in column-major order
+        for (size_t j = 0; j < _width; j++)
+            _data[j * _stride + i] = vector[j];
+    }
+
+    /**
+     * @brief Return the trace of the matrix
+     *
+     * @return T Trace of the matrix
+     */
+    template <Arithmetic T>
+    T MatrixView<T>::trace() const
+    {
+        if (!isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        T result = 0;
+        for (size_t i = 0; i < _width; i++)
+            result += _data[i * _stride + i];
+        return result;
+    }
+
+    /**
+     * @brief Return the transpose of the matrix
+     *
+     * @param policy Execution policy
+     * @return Matrix<T> Transpose of the matrix
+     */
+    template <Arithmetic T>
+    Matrix<T> MatrixView<T>::transpose(Execution policy) const
+    {
+        Matrix<T> result(_height, _width);
+        blas::transpose(_height, _width, _data, _stride, result.data(), _width, policy);
+        return result;
+    }
+
+    /**
+     * @brief Return whether the matrix is approximately equal to another matrix
+     *
+     * @param other Matrix to compare to
+     * @param epsilon Epsilon
+     * @return bool Whether the matrix is approximately equal to the other matrix
+     */
+    template <Arithmetic T>
+    bool MatrixView<T>::isAprrox(const MatrixView<T> &other, double epsilon) const
+    {
+        if (_width != other._width || _height != other._height)
+            return false;
+        for (size_t i = 0; i < _width; i++)
+            if (!(*this)[i].isApprox(other[i], epsilon))
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Return an i-th vector of the matrix
+     *
+     * @param i Index of the vector
+     * @return VectorView<T> i-th vector of the matrix
+     */
+    template <Arithmetic T>
+    VectorView<T> MatrixView<T>::operator[](size_t i)
+    {
+        return VectorView(_data + i * _stride, _height);
+    }
+
+    /**
+     * @brief Return an i-th vector of the matrix
+     *
+     * @param i Index of the vector
+     * @return const VectorView<T> i-th vector of the matrix
+     */
+    template <Arithmetic T>
+    const VectorView<T> MatrixView<T>::operator[](size_t i) const
+    {
+        return VectorView(_data + i * _stride, _height);
+    }
+
+    /**
+     * @brief Return whether the matrix is equal to another matrix
+     *
+     * @param other Matrix to compare to
+     * @return bool Whether the matrix is equal to the other matrix
+     */
+    template <Arithmetic T>
+    bool MatrixView<T>::operator==(const MatrixView<T> &other) const
+    {
+        if (_width != other._width || _height != other._height)
+            return false;
+        if (_data == other._data && _stride == other._stride)
+            return true;
+        for (size_t i = 0; i < _width; i++)
+            if ((*this)[i] != other[i])
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Add another matrix to the matrix
+     *
+     * @param other Matrix to add
+     * @return MatrixView<T>& Result of addition
+     */
+    template <Arithmetic T>
+    MatrixView<T> &MatrixView<T>::operator+=(const MatrixView<T> &other)
+    {
+        if (_width != other._width || _height != other._height)
+            throw std::invalid_argument("Matrices must have the same size");
+        // contiguous storage is split into flat chunks, blocks into groups of columns
+        if (isContiguous() && other.isContiguous())
+            parallel::forRange(Execution::Parallel, _width * _height, parallel::grainSize, [&](size_t begin, size_t end)
+                               { simd::add(_data + begin, other._data + begin, _data + begin, end - begin); });
+        else
+            parallel::forRange(Execution::Parallel, _width, parallel::grainSize / std::max<size_t>(_height, 1), [&](size_t begin, size_t end)
+                               {
+                                   for (size_t j = begin; j < end; j++)
+                                       simd::add(_data + j * _stride, other._data + j * other._stride, _data + j * _stride, _height); });
+        return *this;
+    }
+
+    /**
+     * @brief Subtract another matrix from the matrix
+     *
+     * @param other Matrix to subtract
+     * @return MatrixView<T>& Result of subtraction
+     */
+    template <Arithmetic T>
+    MatrixView<T> &MatrixView<T>::operator-=(const MatrixView<T> &other)
+    {
+        if (_width != other._width || _height != other._height)
+            throw std::invalid_argument("Matrices must have the same size");
+        if (isContiguous() && other.isContiguous())
+            parallel::forRange(Execution::Parallel, _width * _height, parallel::grainSize, [&](size_t begin, size_t end)
+                               { simd::subtract(_data + begin, other._data + begin, _data + begin, end - begin); });
+        else
+            parallel::forRange(Execution::Parallel, _width, parallel::grainSize / std::max<size_t>(_height, 1), [&](size_t begin, size_t end)
+                               {
+                                   for (size_t j = begin; j < end; j++)
+                                       simd::subtract(_data + j * _stride, other._data + j * other._stride, _data + j * _stride, _height); });
+        return *this;
+    }
+
+    /**
+     * @brief Multiply the matrix by a scalar and assign the result to the matrix
+     *
+     * @param scalar Scalar to multiply by
+     * @return MatrixView<T>& Result of multiplication
+     */
+    template <Arithmetic T>
+    MatrixView<T> &MatrixView<T>::operator*=(T scalar)
+    {
+        if (isContiguous())
+            parallel::forRange(Execution::Parallel, _width * _height, parallel::grainSize, [&](size_t begin, size_t end)
+                               { simd::multiply(_data + begin, scalar, _data + begin, end - begin); });
+        else
+            parallel::forRange(Execution::Parallel, _width, parallel::grainSize / std::max<size_t>(_height, 1), [&](size_t begin, size_t end)
+                               {
+                                   for (size_t j = begin; j < end; j++)
+                                       simd::multiply(_data + j * _stride, scalar, _data + j * _stride, _height); });
+        return *this;
+    }
+
+    /**
+     * @brief Compute y = A * x into caller-supplied storage
+     *
+     * @param x Vector of width() elements
+     * @param y Vector of height() elements, overwritten
+     */
+    template <Arithmetic T>
+    void MatrixView<T>::multiply(const VectorView<T> &x, VectorView<T> &y) const
+    {
+        if (_width != x.size())
+            throw std::invalid_argument("Matrix width must be equal to vector size");
+        if (_height != y.size())
+            throw std::invalid_argument("Matrix height must be equal to result size");
+        scratch::contiguousProduct(x, y, [&](const T *in, T *out)
+                                   { blas::gemv(_height, _width, T(1), _data, _stride, in, T(0), out); });
+    }
+
+    /**
+     * @brief Multiply the matrix by a vector
+     *
+     * @param vector Vector to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> MatrixView<T>::operator*(const VectorView<T> &vector) const
+    {
+        Vector<T> result(_height);
+        multiply(vector, result);
+        return result;
+    }
+
+    /**
+     * @brief Multiply the matrix by another matrix
+     *
+     * @param other Matrix to multiply by
+     * @return Matrix<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Matrix<T> MatrixView<T>::operator*(const MatrixView<T> &other) const
+    {
+        if (_width != other._height)
+            throw std::invalid_argument("Matrix width must be equal to other matrix height");
+        Matrix<T> result(other._width, _height);
+        blas::gemm(_height, other._width, _width,
+                   T(1), _data, _stride,
+                   other._data, other._stride,
+                   T(0), result.data(), _height);
+        return result;
+    }
+
+    /**
+     * @brief Return a string representation of the matrix
+     *
+     * @return std::string String representation of the matrix
+     */
+    template <Arithmetic T>
+    MatrixView<T>::operator std::string() const
+    {
+        // column-major order
+        std::string str = "[";
+        for (size_t i = 0; i < _height; i++)
+        {
+            for (size_t j = 0; j < _width; j++)
+            {
+                str += std::to_string((*this)[j][i]);
+                if (j != _width - 1)
+                    str += " ";
+                else if (i != _height - 1)
+                    str += "\n ";
+            }
+        }
+        str += "]";
+        return str;
+    }
+
+    /**
+     * @brief Multiply a row vector by the matrix, x^T * A, without forming the transpose
+     *
+     * @param vector Row vector to multiply
+     * @param matrix Matrix to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> operator*(const VectorView<T> &vector, const MatrixView<T> &matrix)
+    {
+        if (matrix.height() != vector.size())
+            throw std::invalid_argument("Matrix height must be equal to vector size");
+        if (!vector.isContiguous())
+        {
+            ScratchScope scope;
+            return ScratchVector<T>(vector) * matrix;
+        }
+        Vector<T> result(matrix.width());
+        blas::gemvTransposed(matrix.height(), matrix.width(), T(1), matrix.data(), matrix.stride(), vector.data(), T(0), result.data());
+        return result;
+    }
+
+    /**
+     * @brief fmt::formatter specialization for MatrixView
+     *
+     * @param v Matrix to format
+     * @return auto Matrix formatted as a string
+     */
+    template <Arithmetic T>
+    auto format_as(const MatrixView<T> &v)
+    {
+        return static_cast<std::string>(v);
+    }
+
+    /**
+     * @brief Output stream operator for MatrixView
+     *
+     * @param os Output stream
+     * @param m Matrix to output
+     * @return std::ostream& Output stream
+     */
+    template <Arithmetic T>
+    std::ostream &operator<<(std::ostream &os, const MatrixView<T> &m)
+    {
+        return os << static_cast<std::string>(m);
+    }
+
+}
+
+#endif
@@ -0,0 +1,507 @@
+#ifndef M42_PACKED_MATRIX_HPP
+#define M42_PACKED_MATRIX_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "packed.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class VectorView;
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    /**
+     * @brief Which half of a square matrix is stored
+     */
+    enum class Triangle
+    {
+        Lower,
+        Upper
+    };
+
+    /**
+     * @brief Symmetric matrix storing only its lower triangle
+     *
+     * Takes n * (n + 1) / 2 elements instead of n * n, and its product with
+     * a vector reads every stored element once, so large covariance
+     * matrices cost half the memory and half the bandwidth.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class SymmetricMatrix
+    {
+    private:
+        size_t _size;
+        std::vector<T> _data;
+
+    public:
+        using value_type = T;
+
+        explicit SymmetricMatrix(size_t size);
+        explicit SymmetricMatrix(const MatrixView<T> &dense);
+
+        size_t size() const;
+        T *data();
+        const T *data() const;
+        Matrix<T> toDense() const;
+        void multiply(const VectorView<T> &x, VectorView<T> &y) const;
+        void rankUpdate(T alpha, const VectorView<T> &x);
+
+        T &operator()(size_t column, size_t row);
+        const T &operator()(size_t column, size_t row) const;
+        Vector<T> operator*(const VectorView<T> &vector) const;
+    };
+
+    /**
+     * @brief Lower or upper triangular matrix storing only its triangle
+     *
+     * Products and solves are column-oriented substitutions over the packed
+     * columns and never touch the zero half. Solves need floating-point
+     * elements.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class TriangularMatrix
+    {
+    private:
+        size_t _size;
+        Triangle _triangle;
+        std::vector<T> _data;
+
+        size_t index(size_t column, size_t row) const;
+        bool isStored(size_t column, size_t row) const;
+        void checkInvertible() const;
+
+    public:
+        using value_type = T;
+
+        TriangularMatrix(size_t size, Triangle triangle);
+        TriangularMatrix(const MatrixView<T> &dense, Triangle triangle);
+
+        size_t size() const;
+        Triangle triangle() const;
+        T *data();
+        const T *data() const;
+        Matrix<T> toDense() const;
+        void multiply(const VectorView<T> &x, VectorView<T> &y) const;
+        Vector<T> solve(const VectorView<T> &b) const
+            requires std::floating_point<T>;
+        void solveInPlace(VectorView<T> b) const
+            requires std::floating_point<T>;
+        void solveInPlace(MatrixView<T> b) const
+            requires std::floating_point<T>;
+
+        T &operator()(size_t column, size_t row);
+        T operator()(size_t column, size_t row) const;
+        Vector<T> operator*(const VectorView<T> &vector) const;
+    };
+
+    /**
+     * @brief Construct a zero symmetric matrix
+     *
+     * @param size Number of rows and columns
+     */
+    template <Arithmetic T>
+    SymmetricMatrix<T>::SymmetricMatrix(size_t size) : _size(size), _data(size * (size + 1) / 2, T(0)) {}
+
+    /**
+     * @brief Pack a dense symmetric matrix, only its lower triangle is read
+     *
+     * @param dense Square matrix or block
+     */
+    template <Arithmetic T>
+    SymmetricMatrix<T>::SymmetricMatrix(const MatrixView<T> &dense) : SymmetricMatrix(dense.width())
+    {
+        if (!dense.isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        for (size_t j = 0; j < _size; j++)
+        {
+            const T *column = dense.data() + j * dense.stride();
+            std::copy(column + j, column + _size, _data.data() + packed::lowerOffset(_size, j));
+        }
+    }
+
+    /**
+     * @brief Get the number of rows and columns
+     *
+     * @return size_t Size of the matrix
+     */
+    template <Arithmetic T>
+    size_t SymmetricMatrix<T>::size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief Get the packed lower triangle
+     *
+     * @return T* Column j starts at packed::lowerOffset(size(), j)
+     */
+    template <Arithmetic T>
+    T *SymmetricMatrix<T>::data()
+    {
+        return _data.data();
+    }
+
+    /**
+     * @brief Get the packed lower triangle
+     *
+     * @return const T* Column j starts at packed::lowerOffset(size(), j)
+     */
+    template <Arithmetic T>
+    const T *SymmetricMatrix<T>::data() const
+    {
+        return _data.data();
+    }
+
+    /**
+     * @brief Return the dense matrix with the same elements
+     *
+     * @return Matrix<T> Dense matrix, both halves filled
+     */
+    template <Arithmetic T>
+    Matrix<T> SymmetricMatrix<T>::toDense() const
+    {
+        Matrix<T> result(_size, _size);
+        for (size_t j = 0; j < _size; j++)
+            for (size_t i = j; i < _size; i++)
+            {
+                T value = _data[packed::lowerOffset(_size, j) + i - j];
+                result.data()[j * _size + i] = value;
+                result.data()[i * _size + j] = value;
+            }
+        return result;
+    }
+
+    /**
+     * @brief Compute y = A * x into caller-supplied storage
+     *
+     * @param x Vector of size() elements
+     * @param y Vector of size() elements, overwritten
+     */
+    template <Arithmetic T>
+    void SymmetricMatrix<T>::multiply(const VectorView<T> &x, VectorView<T> &y) const
+    {
+        if (x.size() != _size || y.size() != _size)
+            throw std::invalid_argument("Vector size must match matrix size");
+        scratch::contiguousProduct(x, y, [&](const T *in, T *out)
+                                   { packed::spmv(_size, _data.data(), in, out); });
+    }
+
+    /**
+     * @brief Add alpha * x * x^T, the update of a covariance estimate by one sample
+     *
+     * @param alpha Scale of the update
+     * @param x Vector of size() elements
+     */
+    template <Arithmetic T>
+    void SymmetricMatrix<T>::rankUpdate(T alpha, const VectorView<T> &x)
+    {
+        if (x.size() != _size)
+            throw std::invalid_argument("Vector size must match matrix size");
+        if (!x.isContiguous())
+        {
+            ScratchScope scope;
+            rankUpdate(alpha, ScratchVector<T>(x));
+            return;
+        }
+        packed::spr(_size, alpha, x.data(), _data.data());
+    }
+
+    /**
+     * @brief Get an element, (i, j) and (j, i) are the same stored element
+     *
+     * @param column Column index
+     * @param row Row index
+     * @return T& Element
+     */
+    template <Arithmetic T>
+    T &SymmetricMatrix<T>::operator()(size_t column, size_t row)
+    {
+        if (column >= _size || row >= _size)
+            throw std::out_of_range("Index out of range");
+        if (row < column)
+            std::swap(row, column);
+        return _data[packed::lowerOffset(_size, column) + row - column];
+    }
+
+    /**
+     * @brief Get an element, (i, j) and (j, i) are the same stored element
+     *
+     * @param column Column index
+     * @param row Row index
+     * @return const T& Element
+     */
+    template <Arithmetic T>
+    const T &SymmetricMatrix<T>::operator()(size_t column, size_t row) const
+    {
+        return const_cast<SymmetricMatrix *>(this)->operator()(column, row);
+    }
+
+    /**
+     * @brief Multiply the matrix by a vector
+     *
+     * @param vector Vector to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> SymmetricMatrix<T>::operator*(const VectorView<T> &vector) const
+    {
+        Vector<T> result(_size);
+        multiply(vector, result);
+        return result;
+    }
+
+    /**
+     * @brief Construct a zero triangular matrix
+     *
+     * @param size Number of rows and columns
+     * @param triangle Which triangle is stored
+     */
+    template <Arithmetic T>
+    TriangularMatrix<T>::TriangularMatrix(size_t size, Triangle triangle)
+        : _size(size), _triangle(triangle), _data(size * (size + 1) / 2, T(0)) {}
+
+    /**
+     * @brief Pack one triangle of a dense matrix, the other one is ignored
+     *
+     * @param dense Square matrix or block
+     * @param triangle Which triangle to keep
+     */
+    template <Arithmetic T>
+    TriangularMatrix<T>::TriangularMatrix(const MatrixView<T> &dense, Triangle triangle)
+        : TriangularMatrix(dense.width(), triangle)
+    {
+        if (!dense.isSquare())
+            throw std::invalid_argument("Matrix must be square");
+        for (size_t j = 0; j < _size; j++)
+        {
+            const T *column = dense.data() + j * dense.stride();
+            if (_triangle == Triangle::Lower)
+                std::copy(column + j, column + _size, _data.data() + packed::lowerOffset(_size, j));
+            else
+                std::copy(column, column + j + 1, _data.data() + packed::upperOffset(j));
+        }
+    }
+
+    /**
+     * @brief Position of a stored element in the packed array
+     */
+    template <Arithmetic T>
+    size_t TriangularMatrix<T>::index(size_t column, size_t row) const
+    {
+        if (_triangle == Triangle::Lower)
+            return packed::lowerOffset(_size, column) + row - column;
+        return packed::upperOffset(column) + row;
+    }
+
+    /**
+     * @brief Check whether an element lies in the stored triangle
+     */
+    template <Arithmetic T>
+    bool TriangularMatrix<T>::isStored(size_t column, size_t row) const
+    {
+        return _triangle == Triangle::Lower ? row >= column : row <= column;
+    }
+
+    /**
+     * @brief Throw unless every diagonal element is nonzero
+     */
+    template <Arithmetic T>
+    void TriangularMatrix<T>::checkInvertible() const
+    {
+        for (size_t j = 0; j < _size; j++)
+            if (_data[index(j, j)] == T(0))
+                throw std::invalid_argument("Matrix must be invertible");
+    }
+
+    /**
+     * @brief Get the number of rows and columns
+     *
+     * @return size_t Size of the matrix
+     */
+    template <Arithmetic T>
+    size_t TriangularMatrix<T>::size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief Get which triangle is stored
+     *
+     * @return Triangle Lower or upper
+     */
+    template <Arithmetic T>
+    Triangle TriangularMatrix<T>::triangle() const
+    {
+        return _triangle;
+    }
+
+    /**
+     * @brief Get the packed triangle
+     *
+     * @return T* Packed columns, see packed::lowerOffset and packed::upperOffset
+     */
+    template <Arithmetic T>
+    T *TriangularMatrix<T>::data()
+    {
+        return _data.data();
+    }
+
+    /**
+     * @brief Get the packed triangle
+     *
+     * @return const T* Packed columns, see packed::lowerOffset and packed::upperOffset
+     */
+    template <Arithmetic T>
+    const T *TriangularMatrix<T>::data() const
+    {
+        return _data.data();
+    }
+
+    /**
+     * @brief Return the dense matrix with the same elements
+     *
+     * @return Matrix<T> Dense matrix, zero outside the triangle
+     */
+    template <Arithmetic T>
+    Matrix<T> TriangularMatrix<T>::toDense() const
+    {
+        Matrix<T> result(_size, _size);
+        for (size_t j = 0; j < _size; j++)
+            for (size_t i = 0; i < _size; i++)
+                result.data()[j * _size + i] = isStored(j, i) ? _data[index(j, i)] : T(0);
+        return result;
+    }
+
+    /**
+     * @brief Compute y = A * x into caller-supplied storage
+     *
+     * @param x Vector of size() elements
+     * @param y Vector of size() elements, overwritten
+     */
+    template <Arithmetic T>
+    void TriangularMatrix<T>::multiply(const VectorView<T> &x, VectorView<T> &y) const
+    {
+        if (x.size() != _size || y.size() != _size)
+            throw std::invalid_argument("Vector size must match matrix size");
+        scratch::contiguousProduct(x, y, [&](const T *in, T *out)
+                                   { packed::tpmv(_size, _triangle == Triangle::Lower, _data.data(), in, out); });
+    }
+
+    /**
+     * @brief Solve A * x = b by substitution
+     *
+     * @param b Right-hand side
+     * @return Vector<T> Solution
+     */
+    template <Arithmetic T>
+    Vector<T> TriangularMatrix<T>::solve(const VectorView<T> &b) const
+        requires std::floating_point<T>
+    {
+        Vector<T> x(b);
+        solveInPlace(x);
+        return x;
+    }
+
+    /**
+     * @brief Overwrite b with the solution of A * x = b
+     *
+     * @param b Right-hand side, replaced by the solution
+     */
+    template <Arithmetic T>
+    void TriangularMatrix<T>::solveInPlace(VectorView<T> b) const
+        requires std::floating_point<T>
+    {
+        if (b.size() != _size)
+            throw std::invalid_argument("Vector size must match matrix height");
+        checkInvertible();
+        if (!b.isContiguous())
+        {
+            ScratchScope scope;
+            ScratchVector<T> x(b);
+            packed::tpsv(_size, _triangle == Triangle::Lower, _data.data(), 1, x.data(), _size);
+            b = x;
+            return;
+        }
+        packed::tpsv(_size, _triangle == Triangle::Lower, _data.data(), 1, b.data(), _size);
+    }
+
+    /**
+     * @brief Overwrite every column of B with the solution of A * X = B
+     *
+     * @param b Right-hand sides, replaced by the solutions
+     */
+    template <Arithmetic T>
+    void TriangularMatrix<T>::solveInPlace(MatrixView<T> b) const
+        requires std::floating_point<T>
+    {
+        if (b.height() != _size)
+            throw std::invalid_argument("Matrix heights must match");
+        checkInvertible();
+        packed::tpsv(_size, _triangle == Triangle::Lower, _data.data(), b.width(), b.data(), b.stride());
+    }
+
+    /**
+     * @brief Get an element inside the stored triangle
+     *
+     * @param column Column index
+     * @param row Row index
+     * @return T& Element, throws std::out_of_range outside the triangle
+     */
+    template <Arithmetic T>
+    T &TriangularMatrix<T>::operator()(size_t column, size_t row)
+    {
+        if (column >= _size || row >= _size)
+            throw std::out_of_range("Index out of range");
+        if (!isStored(column, row))
+            throw std::out_of_range("Element outside the stored triangle");
+        return _data[index(column, row)];
+    }
+
+    /**
+     * @brief Get an element, zero outside the stored triangle
+     *
+     * @param column Column index
+     * @param row Row index
+     * @return T Element
+     */
+    template <Arithmetic T>
+    T TriangularMatrix<T>::operator()(size_t column, size_t row) const
+    {
+        if (column >= _size || row >= _size)
+            throw std::out_of_range("Index out of range");
+        return isStored(column, row) ? _data[index(column, row)] : T(0);
+    }
+
+    /**
+     * @brief Multiply the matrix by a vector
+     *
+     * @param vector Vector to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> TriangularMatrix<T>::operator*(const VectorView<T> &vector) const
+    {
+        Vector<T> result(_size);
+        multiply(vector, result);
+        return result;
+    }
+
+}
+
+#endif
@@ -0,0 +1,439 @@
+#ifndef M42_QR_HPP
+#define M42_QR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "blas.hpp"
+#include "simd.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    template <Arithmetic T>
+    class VectorView;
+
+    /**
+     * @brief Householder QR factorization of a tall matrix, A = Q * R
+     *
+     * R is stored on and above the diagonal, the Householder vectors
+     * v_j = (1, v_j+1, ..., v_m-1) below it with their implicit unit head,
+     * and Q = H_0 * H_1 * ... * H_n-1 with H_j = I - tau_j * v_j * v_j^T.
+     * Integer matrices are factored in double precision.
+     *
+     * @tparam T Type of components of the factored matrix
+     */
+    template <Arithmetic T>
+    class QR
+    {
+    public:
+        using value_type = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+        /**
+         * @brief Number of reflectors aggregated into one WY block
+         */
+        static constexpr size_t blockSize = 32;
+
+        /**
+         * @brief Panel width below which reflectors are applied one at a time
+         */
+        static constexpr size_t panelLeafSize = 8;
+
+    private:
+        /**
+         * @brief Scratch buffers of the block reflector updates, reused across blocks
+         */
+        struct Workspace
+        {
+            std::vector<value_type> r;
+            std::vector<value_type> t;
+            std::vector<value_type> w;
+        };
+
+        Matrix<value_type> _qr;
+        std::vector<value_type> _tau;
+
+        void factorPanel(size_t k0, size_t kb, Workspace &workspace, Execution policy);
+        void factorLeaf(size_t k0, size_t kb);
+        void updateTrailing(size_t k0, size_t kb, size_t end, Workspace &workspace, Execution policy);
+        void applyQTranspose(value_type *b) const;
+        void applyQ(value_type *b) const;
+
+    public:
+        explicit QR(const MatrixView<T> &matrix, Execution policy = Execution::Parallel);
+
+        size_t width() const;
+        size_t height() const;
+        const Matrix<value_type> &packed() const;
+        const std::vector<value_type> &tau() const;
+        Matrix<value_type> q() const;
+        Matrix<value_type> r() const;
+        bool isFullRank() const;
+        Vector<value_type> lstsq(const VectorView<value_type> &b) const;
+        Matrix<value_type> lstsq(const MatrixView<value_type> &b) const;
+    };
+
+    /**
+     * @brief Factor a matrix with at least as many rows as columns
+     *
+     * Blocks of blockSize columns are factored with vectorized Householder
+     * reflections, then aggregated into the compact WY form
+     * I - V * T * V^T and applied to the trailing columns with two GEMMs.
+     *
+     * @param matrix Matrix to factor, height() >= width()
+     * @param policy Execution policy of the block reflector updates
+     */
+    template <Arithmetic T>
+    QR<T>::QR(const MatrixView<T> &matrix, Execution policy) : _qr(matrix.width(), matrix.height()), _tau(matrix.width())
+    {
+        size_t m = matrix.height();
+        size_t n = matrix.width();
+        if (m < n)
+            throw std::invalid_argument("Matrix must have at least as many rows as columns");
+        for (size_t j = 0; j < n; j++)
+            std::copy(matrix.data() + j * matrix.stride(), matrix.data() + j * matrix.stride() + m, _qr.data() + j * m);
+
+        Workspace workspace;
+        for (size_t k0 = 0; k0 < n; k0 += blockSize)
+        {
+            size_t kb = std::min(blockSize, n - k0);
+            factorPanel(k0, kb, workspace, policy);
+            if (k0 + kb < n)
+                updateTrailing(k0, kb, n, workspace, policy);
+        }
+    }
+
+    /**
+     * @brief Factor columns [k0, k0 + kb) recursively
+     *
+     * A tall panel does not fit in cache, so it is split in halves: the left
+     * half is factored, its block reflector is applied to the right half with
+     * GEMM, then the right half is factored. Only narrow leaves stream the
+     * panel once per reflector.
+     *
+     * @param k0 First column of the panel
+     * @param kb Number of columns in the panel
+     * @param workspace Scratch buffers for the block reflector updates
+     * @param policy Execution policy of the block reflector updates
+     */
+    template <Arithmetic T>
+    void QR<T>::factorPanel(size_t k0, size_t kb, Workspace &workspace, Execution policy)
+    {
+        if (kb <= panelLeafSize)
+        {
+            factorLeaf(k0, kb);
+            return;
+        }
+        size_t left = kb / 2;
+        factorPanel(k0, left, workspace, policy);
+        updateTrailing(k0, left, k0 + kb, workspace, policy);
+        factorPanel(k0 + left, kb - left, workspace, policy);
+    }
+
+    /**
+     * @brief Factor columns [k0, k0 + kb) one reflector at a time
+     *
+     * @param k0 First column of the panel
+     * @param kb Number of columns in the panel
+     */
+    template <Arithmetic T>
+    void QR<T>::factorLeaf(size_t k0, size_t kb)
+    {
+        size_t m = _qr.height();
+        value_type *a = _qr.data();
+        for (size_t j = k0; j < k0 + kb; j++)
+        {
+            value_type *column = a + j * m;
+            size_t below = m - j - 1;
+            value_type alpha = column[j];
+            value_type xnorm = std::sqrt(simd::sumSquares(column + j + 1, below));
+            if (xnorm == value_type(0))
+            {
+                _tau[j] = 0;
+                continue;
+            }
+            value_type beta = -std::copysign(std::hypot(alpha, xnorm), alpha);
+            _tau[j] = (beta - alpha) / beta;
+            simd::multiply(column + j + 1, value_type(1) / (alpha - beta), column + j + 1, below);
+            column[j] = beta;
+
+            // apply H_j to the rest of the panel
+            for (size_t c = j + 1; c < k0 + kb; c++)
+            {
+                value_type *target = a + c * m;
+                value_type dot = target[j] + simd::dot(column + j + 1, target + j + 1, below);
+                value_type scale = -_tau[j] * dot;
+                target[j] += scale;
+                simd::axpy(scale, column + j + 1, target + j + 1, below);
+            }
+        }
+    }
+
+    /**
+     * @brief Apply the block reflector of columns [k0, k0 + kb) to columns [k0 + kb, end)
+     *
+     * Computes C = (I - V * T^T * V^T) * C as W = V^T * C, W = T^T * W,
+     * C -= V * W, where T is the kb x kb upper triangular WY factor. V is
+     * read in place: the top triangle of the panel is temporarily replaced
+     * by the unit diagonal and zeros of the reflectors.
+     *
+     * @param k0 First column of the panel
+     * @param kb Number of columns in the panel
+     * @param end One past the last column to update
+     * @param workspace Scratch buffers
+     * @param policy Execution policy of the GEMMs
+     */
+    template <Arithmetic T>
+    void QR<T>::updateTrailing(size_t k0, size_t kb, size_t end, Workspace &workspace, Execution policy)
+    {
+        size_t m = _qr.height();
+        size_t rows = m - k0;
+        size_t rest = end - k0 - kb;
+        value_type *v = _qr.data() + k0 * m + k0;
+        value_type *c = v + kb * m;
+
+        std::vector<value_type> &r = workspace.r;
+        std::vector<value_type> &t = workspace.t;
+        std::vector<value_type> &w = workspace.w;
+        r.resize(kb * kb);
+        t.resize(kb * kb);
+        w.resize(kb * rest);
+
+        for (size_t p = 0; p < kb; p++)
+        {
+            std::copy(v + p * m, v + p * m + p + 1, r.data() + p * kb);
+            std::fill(v + p * m, v + p * m + p, value_type(0));
+            v[p * m + p] = 1;
+        }
+
+        // T[0:i, i] = -tau_i * T[0:i, 0:i] * V[:, 0:i]^T * v_i, with V^T * V from one GEMM
+        blas::gemmTransposed(kb, kb, rows, value_type(1), v, m, v, m, value_type(0), t.data(), kb, policy);
+        for (size_t i = 0; i < kb; i++)
+        {
+            value_type *column = t.data() + i * kb;
+            for (size_t p = 0; p < i; p++)
+            {
+                value_type sum = 0;
+                for (size_t q = p; q < i; q++)
+                    sum += t[q * kb + p] * column[q];
+                column[p] = -_tau[k0 + i] * sum;
+            }
+            column[i] = _tau[k0 + i];
+        }
+
+        blas::gemmTransposed(kb, rest, rows, value_type(1), v, m, c, m, value_type(0), w.data(), kb, policy);
+        // W = T^T * W, bottom up so every row reads unmodified rows above it
+        for (size_t col = 0; col < rest; col++)
+        {
+            value_type *wc = w.data() + col * kb;
+            for (size_t i = kb; i-- > 0;)
+                wc[i] = simd::dot(t.data() + i * kb, wc, i + 1);
+        }
+        blas::gemm(rows, rest, kb, value_type(-1), v, m, w.data(), kb, value_type(1), c, m, policy);
+
+        for (size_t p = 0; p < kb; p++)
+            std::copy(r.data() + p * kb, r.data() + p * kb + p + 1, v + p * m);
+    }
+
+    /**
+     * @brief Overwrite a column of height() values with Q^T times it
+     *
+     * @param b Pointer to the column
+     */
+    template <Arithmetic T>
+    void QR<T>::applyQTranspose(value_type *b) const
+    {
+        size_t m = height();
+        const value_type *a = _qr.data();
+        for (size_t j = 0; j < width(); j++)
+        {
+            const value_type *v = a + j * m + j + 1;
+            value_type scale = -_tau[j] * (b[j] + simd::dot(v, b + j + 1, m - j - 1));
+            b[j] += scale;
+            simd::axpy(scale, v, b + j + 1, m - j - 1);
+        }
+    }
+
+    /**
+     * @brief Overwrite a column of height() values with Q times it
+     *
+     * @param b Pointer to the column
+     */
+    template <Arithmetic T>
+    void QR<T>::applyQ(value_type *b) const
+    {
+        size_t m = height();
+        const value_type *a = _qr.data();
+        for (size_t j = width(); j-- > 0;)
+        {
+            const value_type *v = a + j * m + j + 1;
+            value_type scale = -_tau[j] * (b[j] + simd::dot(v, b + j + 1, m - j - 1));
+            b[j] += scale;
+            simd::axpy(scale, v, b + j + 1, m - j - 1);
+        }
+    }
+
+    /**
+     * @brief Return the number of columns of the factored matrix
+     *
+     * @return size_t Width of the matrix
+     */
+    template <Arithmetic T>
+    size_t QR<T>::width() const
+    {
+        return _qr.width();
+    }
+
+    /**
+     * @brief Return the number of rows of the factored matrix
+     *
+     * @return size_t Height of the matrix
+     */
+    template <Arithmetic T>
+    size_t QR<T>::height() const
+    {
+        return _qr.height();
+    }
+
+    /**
+     * @brief Return R and the Householder vectors packed into one matrix
+     *
+     * @return const Matrix<value_type>& Packed factorization
+     */
+    template <Arithmetic T>
+    const Matrix<typename QR<T>::value_type> &QR<T>::packed() const
+    {
+        return _qr;
+    }
+
+    /**
+     * @brief Return the scalar factors of the Householder reflections
+     *
+     * @return const std::vector<value_type>& One factor per column
+     */
+    template <Arithmetic T>
+    const std::vector<typename QR<T>::value_type> &QR<T>::tau() const
+    {
+        return _tau;
+    }
+
+    /**
+     * @brief Return the thin orthogonal factor
+     *
+     * @return Matrix<value_type> Q with orthonormal columns, same size as A
+     */
+    template <Arithmetic T>
+    Matrix<typename QR<T>::value_type> QR<T>::q() const
+    {
+        size_t m = height();
+        size_t n = width();
+        Matrix<value_type> result(n, m);
+        std::fill(result.data(), result.data() + m * n, value_type(0));
+        for (size_t j = 0; j < n; j++)
+        {
+            result.data()[j * m + j] = 1;
+            applyQ(result.data() + j * m);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Return the upper triangular factor
+     *
+     * @return Matrix<value_type> Square R of order width()
+     */
+    template <Arithmetic T>
+    Matrix<typename QR<T>::value_type> QR<T>::r() const
+    {
+        size_t m = height();
+        size_t n = width();
+        Matrix<value_type> result(n, n);
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < n; i++)
+                result.data()[j * n + i] = i <= j ? _qr.data()[j * m + i] : value_type(0);
+        return result;
+    }
+
+    /**
+     * @brief Return whether the diagonal of R is numerically nonzero
+     *
+     * A diagonal entry counts as zero when it is below the largest one
+     * times height() times the machine epsilon.
+     *
+     * @return bool Whether the columns of the factored matrix are independent
+     */
+    template <Arithmetic T>
+    bool QR<T>::isFullRank() const
+    {
+        size_t m = height();
+        value_type largest = 0;
+        for (size_t j = 0; j < width(); j++)
+            largest = std::max(largest, std::abs(_qr.data()[j * m + j]));
+        value_type tolerance = largest * static_cast<value_type>(m) * std::numeric_limits<value_type>::epsilon();
+        for (size_t j = 0; j < width(); j++)
+            if (!(std::abs(_qr.data()[j * m + j]) > tolerance))
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Return the x minimizing ||A * x - b||
+     *
+     * @param b Right-hand side of height() values
+     * @return Vector<value_type> Least-squares solution of width() values
+     */
+    template <Arithmetic T>
+    Vector<typename QR<T>::value_type> QR<T>::lstsq(const VectorView<value_type> &b) const
+    {
+        if (b.size() != height())
+            throw std::invalid_argument("Vector size must match matrix height");
+        if (!isFullRank())
+            throw std::invalid_argument("Matrix must have full column rank");
+        Vector<value_type> y(b);
+        applyQTranspose(y.data());
+        Vector<value_type> x(width());
+        std::copy(y.data(), y.data() + width(), x.data());
+        blas::trsmUpper(width(), size_t(1), _qr.data(), height(), x.data(), width());
+        return x;
+    }
+
+    /**
+     * @brief Return the X minimizing ||A * X - B|| column by column
+     *
+     * @param b Right-hand sides, one per column, a matrix or a block of one
+     * @return Matrix<value_type> Least-squares solutions, one per column
+     */
+    template <Arithmetic T>
+    Matrix<typename QR<T>::value_type> QR<T>::lstsq(const MatrixView<value_type> &b) const
+    {
+        size_t m = height();
+        size_t n = width();
+        if (b.height() != m)
+            throw std::invalid_argument("Matrix heights must match");
+        if (!isFullRank())
+            throw std::invalid_argument("Matrix must have full column rank");
+        Matrix<value_type> y(b);
+        Matrix<value_type> x(b.width(), n);
+        for (size_t c = 0; c < b.width(); c++)
+        {
+            applyQTranspose(y.data() + c * y.stride());
+            std::copy(y.data() + c * y.stride(), y.data() + c * y.stride() + n, x.data() + c * n);
+        }
+        blas::trsmUpper(n, b.width(), _qr.data(), m, x.data(), n);
+        return x;
+    }
+
+}
+
+#endif
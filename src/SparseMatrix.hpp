@@ -0,0 +1,662 @@
+#ifndef M42_SPARSE_MATRIX_HPP
+#define M42_SPARSE_MATRIX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "sparse.hpp"
+#include "Matrix.hpp"
+
+namespace m42
+{
+
+    template <Arithmetic T>
+    class VectorView;
+
+    template <Arithmetic T>
+    class MatrixView;
+
+    template <Arithmetic T>
+    class CsrMatrix;
+
+    template <Arithmetic T>
+    class CscMatrix;
+
+    /**
+     * @brief Sparse matrix as a list of (row, column, value) triplets
+     *
+     * Meant for assembly: entries can be added in any order and duplicates
+     * are summed when the matrix is compressed into CSR or CSC.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class CooMatrix
+    {
+    private:
+        size_t _width;
+        size_t _height;
+        std::vector<size_t> _rows;
+        std::vector<size_t> _columns;
+        std::vector<T> _values;
+
+    public:
+        using value_type = T;
+
+        CooMatrix(size_t width, size_t height);
+
+        size_t width() const;
+        size_t height() const;
+        size_t nonZeros() const;
+        const std::vector<size_t> &rows() const;
+        const std::vector<size_t> &columns() const;
+        const std::vector<T> &values() const;
+        void reserve(size_t nonZeros);
+        void add(size_t row, size_t column, T value);
+        Matrix<T> toDense() const;
+    };
+
+    /**
+     * @brief Compressed sparse row matrix
+     *
+     * Row i owns the entries rowOffsets()[i] to rowOffsets()[i + 1], sorted
+     * by column. Products read the matrix row by row, which makes CSR the
+     * format of choice for A * x.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class CsrMatrix
+    {
+    private:
+        size_t _width;
+        size_t _height;
+        std::vector<size_t> _offsets;
+        std::vector<size_t> _columns;
+        std::vector<T> _values;
+
+    public:
+        using value_type = T;
+
+        CsrMatrix();
+        explicit CsrMatrix(const CooMatrix<T> &coo);
+        explicit CsrMatrix(const CscMatrix<T> &csc);
+        explicit CsrMatrix(const MatrixView<T> &dense);
+
+        size_t width() const;
+        size_t height() const;
+        size_t nonZeros() const;
+        const std::vector<size_t> &rowOffsets() const;
+        const std::vector<size_t> &columnIndices() const;
+        const std::vector<T> &values() const;
+        Matrix<T> toDense() const;
+        CsrMatrix transpose() const;
+        void multiply(const VectorView<T> &x, VectorView<T> &y) const;
+        void multiply(const MatrixView<T> &b, MatrixView<T> &c) const;
+
+        Vector<T> operator*(const VectorView<T> &vector) const;
+        Matrix<T> operator*(const MatrixView<T> &other) const;
+    };
+
+    /**
+     * @brief Compressed sparse column matrix
+     *
+     * Column j owns the entries columnOffsets()[j] to columnOffsets()[j + 1],
+     * sorted by row, matching the column-major layout of Matrix.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    class CscMatrix
+    {
+    private:
+        size_t _width;
+        size_t _height;
+        std::vector<size_t> _offsets;
+        std::vector<size_t> _rows;
+        std::vector<T> _values;
+
+    public:
+        using value_type = T;
+
+        CscMatrix();
+        explicit CscMatrix(const CooMatrix<T> &coo);
+        explicit CscMatrix(const CsrMatrix<T> &csr);
+        explicit CscMatrix(const MatrixView<T> &dense);
+
+        size_t width() const;
+        size_t height() const;
+        size_t nonZeros() const;
+        const std::vector<size_t> &columnOffsets() const;
+        const std::vector<size_t> &rowIndices() const;
+        const std::vector<T> &values() const;
+        Matrix<T> toDense() const;
+        void multiply(const VectorView<T> &x, VectorView<T> &y) const;
+        void multiply(const MatrixView<T> &b, MatrixView<T> &c) const;
+
+        Vector<T> operator*(const VectorView<T> &vector) const;
+        Matrix<T> operator*(const MatrixView<T> &other) const;
+    };
+
+    /**
+     * @brief Construct an empty triplet matrix
+     *
+     * @param width Width of the matrix
+     * @param height Height of the matrix
+     */
+    template <Arithmetic T>
+    CooMatrix<T>::CooMatrix(size_t width, size_t height) : _width(width), _height(height) {}
+
+    /**
+     * @brief Return the width of the matrix
+     *
+     * @return size_t Width of the matrix
+     */
+    template <Arithmetic T>
+    size_t CooMatrix<T>::width() const
+    {
+        return _width;
+    }
+
+    /**
+     * @brief Return the height of the matrix
+     *
+     * @return size_t Height of the matrix
+     */
+    template <Arithmetic T>
+    size_t CooMatrix<T>::height() const
+    {
+        return _height;
+    }
+
+    /**
+     * @brief Return the number of stored triplets, duplicates included
+     *
+     * @return size_t Number of triplets
+     */
+    template <Arithmetic T>
+    size_t CooMatrix<T>::nonZeros() const
+    {
+        return _values.size();
+    }
+
+    /**
+     * @brief Return the row index of every triplet
+     *
+     * @return const std::vector<size_t>& Row indices
+     */
+    template <Arithmetic T>
+    const std::vector<size_t> &CooMatrix<T>::rows() const
+    {
+        return _rows;
+    }
+
+    /**
+     * @brief Return the column index of every triplet
+     *
+     * @return const std::vector<size_t>& Column indices
+     */
+    template <Arithmetic T>
+    const std::vector<size_t> &CooMatrix<T>::columns() const
+    {
+        return _columns;
+    }
+
+    /**
+     * @brief Return the value of every triplet
+     *
+     * @return const std::vector<T>& Values
+     */
+    template <Arithmetic T>
+    const std::vector<T> &CooMatrix<T>::values() const
+    {
+        return _values;
+    }
+
+    /**
+     * @brief Reserve storage for a number of triplets
+     *
+     * @param nonZeros Expected number of triplets
+     */
+    template <Arithmetic T>
+    void CooMatrix<T>::reserve(size_t nonZeros)
+    {
+        _rows.reserve(nonZeros);
+        _columns.reserve(nonZeros);
+        _values.reserve(nonZeros);
+    }
+
+    /**
+     * @brief Add a value to an element, repeated positions are summed
+     *
+     * @param row Row index
+     * @param column Column index
+     * @param value Value to add
+     */
+    template <Arithmetic T>
+    void CooMatrix<T>::add(size_t row, size_t column, T value)
+    {
+        if (row >= _height || column >= _width)
+            throw std::out_of_range("Index out of range");
+        _rows.push_back(row);
+        _columns.push_back(column);
+        _values.push_back(value);
+    }
+
+    /**
+     * @brief Return the dense matrix with the same elements
+     *
+     * @return Matrix<T> Dense matrix
+     */
+    template <Arithmetic T>
+    Matrix<T> CooMatrix<T>::toDense() const
+    {
+        Matrix<T> result(_width, _height);
+        std::fill(result.data(), result.data() + _width * _height, T(0));
+        for (size_t k = 0; k < _values.size(); k++)
+            result.data()[_columns[k] * _height + _rows[k]] += _values[k];
+        return result;
+    }
+
+    /**
+     * @brief Construct an empty 0 x 0 CSR matrix
+     */
+    template <Arithmetic T>
+    CsrMatrix<T>::CsrMatrix() : _width(0), _height(0), _offsets(1, 0) {}
+
+    /**
+     * @brief Compress triplets into CSR, summing duplicates
+     *
+     * @param coo Triplets to compress
+     */
+    template <Arithmetic T>
+    CsrMatrix<T>::CsrMatrix(const CooMatrix<T> &coo) : _width(coo.width()), _height(coo.height())
+    {
+        sparse::compress(_height, coo.nonZeros(), coo.rows().data(), coo.columns().data(), coo.values().data(),
+                         _offsets, _columns, _values);
+    }
+
+    /**
+     * @brief Convert a CSC matrix to CSR
+     *
+     * @param csc Matrix to convert
+     */
+    template <Arithmetic T>
+    CsrMatrix<T>::CsrMatrix(const CscMatrix<T> &csc) : _width(csc.width()), _height(csc.height())
+    {
+        sparse::transpose(_width, _height, csc.columnOffsets().data(), csc.rowIndices().data(), csc.values().data(),
+                          _offsets, _columns, _values);
+    }
+
+    /**
+     * @brief Store the nonzero elements of a dense matrix
+     *
+     * @param dense Matrix or block to convert
+     */
+    template <Arithmetic T>
+    CsrMatrix<T>::CsrMatrix(const MatrixView<T> &dense) : CsrMatrix(CscMatrix<T>(dense)) {}
+
+    /**
+     * @brief Return the width of the matrix
+     *
+     * @return size_t Width of the matrix
+     */
+    template <Arithmetic T>
+    size_t CsrMatrix<T>::width() const
+    {
+        return _width;
+    }
+
+    /**
+     * @brief Return the height of the matrix
+     *
+     * @return size_t Height of the matrix
+     */
+    template <Arithmetic T>
+    size_t CsrMatrix<T>::height() const
+    {
+        return _height;
+    }
+
+    /**
+     * @brief Return the number of stored entries
+     *
+     * @return size_t Number of stored entries
+     */
+    template <Arithmetic T>
+    size_t CsrMatrix<T>::nonZeros() const
+    {
+        return _values.size();
+    }
+
+    /**
+     * @brief Return the offsets of the rows, height() + 1 of them
+     *
+     * @return const std::vector<size_t>& Row offsets
+     */
+    template <Arithmetic T>
+    const std::vector<size_t> &CsrMatrix<T>::rowOffsets() const
+    {
+        return _offsets;
+    }
+
+    /**
+     * @brief Return the column index of every stored entry
+     *
+     * @return const std::vector<size_t>& Column indices
+     */
+    template <Arithmetic T>
+    const std::vector<size_t> &CsrMatrix<T>::columnIndices() const
+    {
+        return _columns;
+    }
+
+    /**
+     * @brief Return the value of every stored entry
+     *
+     * @return const std::vector<T>& Values
+     */
+    template <Arithmetic T>
+    const std::vector<T> &CsrMatrix<T>::values() const
+    {
+        return _values;
+    }
+
+    /**
+     * @brief Return the dense matrix with the same elements
+     *
+     * @return Matrix<T> Dense matrix
+     */
+    template <Arithmetic T>
+    Matrix<T> CsrMatrix<T>::toDense() const
+    {
+        Matrix<T> result(_width, _height);
+        std::fill(result.data(), result.data() + _width * _height, T(0));
+        for (size_t i = 0; i < _height; i++)
+            for (size_t k = _offsets[i]; k < _offsets[i + 1]; k++)
+                result.data()[_columns[k] * _height + i] = _values[k];
+        return result;
+    }
+
+    /**
+     * @brief Return the transpose of the matrix, also in CSR
+     *
+     * @return CsrMatrix Transpose of the matrix
+     */
+    template <Arithmetic T>
+    CsrMatrix<T> CsrMatrix<T>::transpose() const
+    {
+        CsrMatrix<T> result;
+        result._width = _height;
+        result._height = _width;
+        sparse::transpose(_height, _width, _offsets.data(), _columns.data(), _values.data(),
+                          result._offsets, result._columns, result._values);
+        return result;
+    }
+
+    /**
+     * @brief Compute y = A * x into caller-supplied storage
+     *
+     * @param x Vector of width() elements
+     * @param y Vector of height() elements, overwritten
+     */
+    template <Arithmetic T>
+    void CsrMatrix<T>::multiply(const VectorView<T> &x, VectorView<T> &y) const
+    {
+        if (x.size() != _width)
+            throw std::invalid_argument("Matrix width must be equal to vector size");
+        if (y.size() != _height)
+            throw std::invalid_argument("Matrix height must be equal to result size");
+        scratch::contiguousProduct(x, y, [&](const T *in, T *out)
+                                   { sparse::csrmv(_height, _offsets.data(), _columns.data(), _values.data(), in, out); });
+    }
+
+    /**
+     * @brief Compute C = A * B into caller-supplied storage
+     *
+     * @param b Dense matrix of width() rows
+     * @param c Dense matrix of height() rows and b.width() columns, overwritten
+     */
+    template <Arithmetic T>
+    void CsrMatrix<T>::multiply(const MatrixView<T> &b, MatrixView<T> &c) const
+    {
+        if (b.height() != _width)
+            throw std::invalid_argument("Matrix width must be equal to other matrix height");
+        if (c.height() != _height || c.width() != b.width())
+            throw std::invalid_argument("Result must be height() x other.width()");
+        sparse::csrmm(_height, b.width(), _offsets.data(), _columns.data(), _values.data(),
+                      b.data(), b.stride(), c.data(), c.stride());
+    }
+
+    /**
+     * @brief Multiply the matrix by a dense vector
+     *
+     * @param vector Vector to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> CsrMatrix<T>::operator*(const VectorView<T> &vector) const
+    {
+        Vector<T> result(_height);
+        multiply(vector, result);
+        return result;
+    }
+
+    /**
+     * @brief Multiply the matrix by a dense matrix
+     *
+     * @param other Matrix to multiply by
+     * @return Matrix<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Matrix<T> CsrMatrix<T>::operator*(const MatrixView<T> &other) const
+    {
+        Matrix<T> result(other.width(), _height);
+        multiply(other, result);
+        return result;
+    }
+
+    /**
+     * @brief Construct an empty 0 x 0 CSC matrix
+     */
+    template <Arithmetic T>
+    CscMatrix<T>::CscMatrix() : _width(0), _height(0), _offsets(1, 0) {}
+
+    /**
+     * @brief Compress triplets into CSC, summing duplicates
+     *
+     * @param coo Triplets to compress
+     */
+    template <Arithmetic T>
+    CscMatrix<T>::CscMatrix(const CooMatrix<T> &coo) : _width(coo.width()), _height(coo.height())
+    {
+        sparse::compress(_width, coo.nonZeros(), coo.columns().data(), coo.rows().data(), coo.values().data(),
+                         _offsets, _rows, _values);
+    }
+
+    /**
+     * @brief Convert a CSR matrix to CSC
+     *
+     * @param csr Matrix to convert
+     */
+    template <Arithmetic T>
+    CscMatrix<T>::CscMatrix(const CsrMatrix<T> &csr) : _width(csr.width()), _height(csr.height())
+    {
+        sparse::transpose(_height, _width, csr.rowOffsets().data(), csr.columnIndices().data(), csr.values().data(),
+                          _offsets, _rows, _values);
+    }
+
+    /**
+     * @brief Store the nonzero elements of a dense matrix
+     *
+     * Columns are scanned in storage order, so the result needs no sorting.
+     *
+     * @param dense Matrix or block to convert
+     */
+    template <Arithmetic T>
+    CscMatrix<T>::CscMatrix(const MatrixView<T> &dense) : _width(dense.width()), _height(dense.height()), _offsets(dense.width() + 1, 0)
+    {
+        for (size_t j = 0; j < _width; j++)
+        {
+            const T *column = dense.data() + j * dense.stride();
+            for (size_t i = 0; i < _height; i++)
+                if (column[i] != T(0))
+                {
+                    _rows.push_back(i);
+                    _values.push_back(column[i]);
+                }
+            _offsets[j + 1] = _values.size();
+        }
+    }
+
+    /**
+     * @brief Return the width of the matrix
+     *
+     * @return size_t Width of the matrix
+     */
+    template <Arithmetic T>
+    size_t CscMatrix<T>::width() const
+    {
+        return _width;
+    }
+
+    /**
+     * @brief Return the height of the matrix
+     *
+     * @return size_t Height of the matrix
+     */
+    template <Arithmetic T>
+    size_t CscMatrix<T>::height() const
+    {
+        return _height;
+    }
+
+    /**
+     * @brief Return the number of stored entries
+     *
+     * @return size_t Number of stored entries
+     */
+    template <Arithmetic T>
+    size_t CscMatrix<T>::nonZeros() const
+    {
+        return _values.size();
+    }
+
+    /**
+     * @brief Return the offsets of the columns, width() + 1 of them
+     *
+     * @return const std::vector<size_t>& Column offsets
+     */
+    template <Arithmetic T>
+    const std::vector<size_t> &CscMatrix<T>::columnOffsets() const
+    {
+        return _offsets;
+    }
+
+    /**
+     * @brief Return the row index of every stored entry
+     *
+     * @return const std::vector<size_t>& Row indices
+     */
+    template <Arithmetic T>
+    const std::vector<size_t> &CscMatrix<T>::rowIndices() const
+    {
+        return _rows;
+    }
+
+    /**
+     * @brief Return the value of every stored entry
+     *
+     * @return const std::vector<T>& Values
+     */
+    template <Arithmetic T>
+    const std::vector<T> &CscMatrix<T>::values() const
+    {
+        return _values;
+    }
+
+    /**
+     * @brief Return the dense matrix with the same elements
+     *
+     * @return Matrix<T> Dense matrix
+     */
+    template <Arithmetic T>
+    Matrix<T> CscMatrix<T>::toDense() const
+    {
+        Matrix<T> result(_width, _height);
+        std::fill(result.data(), result.data() + _width * _height, T(0));
+        for (size_t j = 0; j < _width; j++)
+            for (size_t k = _offsets[j]; k < _offsets[j + 1]; k++)
+                result.data()[j * _height + _rows[k]] = _values[k];
+        return result;
+    }
+
+    /**
+     * @brief Compute y = A * x into caller-supplied storage
+     *
+     * @param x Vector of width() elements
+     * @param y Vector of height() elements, overwritten
+     */
+    template <Arithmetic T>
+    void CscMatrix<T>::multiply(const VectorView<T> &x, VectorView<T> &y) const
+    {
+        if (x.size() != _width)
+            throw std::invalid_argument("Matrix width must be equal to vector size");
+        if (y.size() != _height)
+            throw std::invalid_argument("Matrix height must be equal to result size");
+        scratch::contiguousProduct(x, y, [&](const T *in, T *out)
+                                   { sparse::cscmv(_height, _width, _offsets.data(), _rows.data(), _values.data(), in, out); });
+    }
+
+    /**
+     * @brief Compute C = A * B into caller-supplied storage
+     *
+     * @param b Dense matrix of width() rows
+     * @param c Dense matrix of height() rows and b.width() columns, overwritten
+     */
+    template <Arithmetic T>
+    void CscMatrix<T>::multiply(const MatrixView<T> &b, MatrixView<T> &c) const
+    {
+        if (b.height() != _width)
+            throw std::invalid_argument("Matrix width must be equal to other matrix height");
+        if (c.height() != _height || c.width() != b.width())
+            throw std::invalid_argument("Result must be height() x other.width()");
+        sparse::cscmm(_height, _width, b.width(), _offsets.data(), _rows.data(), _values.data(),
+                      b.data(), b.stride(), c.data(), c.stride());
+    }
+
+    /**
+     * @brief Multiply the matrix by a dense vector
+     *
+     * @param vector Vector to multiply by
+     * @return Vector<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Vector<T> CscMatrix<T>::operator*(const VectorView<T> &vector) const
+    {
+        Vector<T> result(_height);
+        multiply(vector, result);
+        return result;
+    }
+
+    /**
+     * @brief Multiply the matrix by a dense matrix
+     *
+     * @param other Matrix to multiply by
+     * @return Matrix<T> Result of multiplication
+     */
+    template <Arithmetic T>
+    Matrix<T> CscMatrix<T>::operator*(const MatrixView<T> &other) const
+    {
+        Matrix<T> result(other.width(), _height);
+        multiply(other, result);
+        return result;
+    }
+
+}
+
+#endif
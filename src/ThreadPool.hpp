@@ -0,0 +1,389 @@
+#ifndef M42_THREAD_POOL_HPP
+#define M42_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace m42
+{
+
+    /**
+     * @brief Execution policy of the heavy operations
+     *
+     * Parallel runs on the shared pool when the operation is large enough to
+     * amortize the scheduling, Sequential always stays on the calling thread.
+     */
+    enum class Execution
+    {
+        Sequential,
+        Parallel
+    };
+
+    /**
+     * @brief Fixed set of worker threads with work stealing
+     *
+     * Every participant owns a task deque: it takes work from the back of
+     * its own and, when that is empty, steals from the front of the others,
+     * so uneven tasks even out without a central queue. Threads waiting for
+     * a parallelFor run tasks instead of blocking, which also makes nested
+     * parallelFor calls safe.
+     */
+    class ThreadPool
+    {
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        std::vector<std::thread> _workers;
+        std::mutex _sleepMutex;
+        std::condition_variable _wake;
+        std::atomic<size_t> _queued;
+        bool _stop;
+
+        inline static thread_local const ThreadPool *_currentPool = nullptr;
+        inline static thread_local size_t _currentQueue = 0;
+
+        size_t home() const;
+        void push(size_t queue, std::function<void()> task);
+        bool runOne(size_t queue);
+        void work(size_t queue);
+
+    public:
+        explicit ThreadPool(size_t threads);
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+        ~ThreadPool();
+
+        size_t size() const;
+        template <typename F>
+        void parallelFor(size_t count, F &&f);
+    };
+
+    /**
+     * @brief Start threads - 1 workers, the thread calling parallelFor is the last participant
+     *
+     * @param threads Number of threads that run tasks, at least 1
+     */
+    inline ThreadPool::ThreadPool(size_t threads) : _queued(0), _stop(false)
+    {
+        if (threads == 0)
+            throw std::invalid_argument("Thread count must be positive");
+        for (size_t i = 0; i < threads; i++)
+            _queues.push_back(std::make_unique<Queue>());
+        // queue 0 is shared by the threads outside the pool
+        for (size_t i = 1; i < threads; i++)
+            _workers.emplace_back([this, i]
+                                  { work(i); });
+    }
+
+    /**
+     * @brief Stop and join the workers
+     */
+    inline ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (std::thread &worker : _workers)
+            worker.join();
+    }
+
+    /**
+     * @brief Get the number of threads that run tasks, the caller included
+     *
+     * @return size_t Worker count plus one
+     */
+    inline size_t ThreadPool::size() const
+    {
+        return _queues.size();
+    }
+
+    /**
+     * @brief Queue owned by the calling thread
+     */
+    inline size_t ThreadPool::home() const
+    {
+        return _currentPool == this ? _currentQueue : 0;
+    }
+
+    /**
+     * @brief Add a task to the back of a queue
+     */
+    inline void ThreadPool::push(size_t queue, std::function<void()> task)
+    {
+        std::lock_guard<std::mutex> lock(_queues[queue]->mutex);
+        _queues[queue]->tasks.push_back(std::move(task));
+        _queued.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Run one task, from the back of the own queue or stolen from the front of another
+     *
+     * @param queue Queue owned by the calling thread
+     * @return true A task was run
+     * @return false Every queue was empty
+     */
+    inline bool ThreadPool::runOne(size_t queue)
+    {
+        std::function<void()> task;
+        for (size_t i = 0; i < _queues.size() && !task; i++)
+        {
+            Queue &victim = *_queues[(queue + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tasks.empty())
+                continue;
+            if (i == 0)
+            {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task)
+            return false;
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    /**
+     * @brief Worker loop, sleeps while there is nothing to run
+     */
+    inline void ThreadPool::work(size_t queue)
+    {
+        _currentPool = this;
+        _currentQueue = queue;
+        while (true)
+        {
+            if (runOne(queue))
+                continue;
+            std::unique_lock<std::mutex> lock(_sleepMutex);
+            _wake.wait(lock, [this]
+                       { return _stop || _queued.load(std::memory_order_acquire) > 0; });
+            if (_stop)
+                return;
+        }
+    }
+
+    /**
+     * @brief Call f(i) for every i in [0, count) across the pool and wait for all of them
+     *
+     * Tasks are dealt round-robin over the queues starting with the
+     * caller's, the caller then runs tasks until all are done. The first
+     * exception thrown by a task is rethrown once every task has finished.
+     *
+     * @param count Number of tasks
+     * @param f Callable taking the task index
+     */
+    template <typename F>
+    void ThreadPool::parallelFor(size_t count, F &&f)
+    {
+        if (count == 0)
+            return;
+        if (count == 1 || size() == 1)
+        {
+            for (size_t i = 0; i < count; i++)
+                f(i);
+            return;
+        }
+
+        std::atomic<size_t> remaining(count);
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        size_t queue = home();
+        for (size_t i = 0; i < count; i++)
+            push((queue + i) % size(), [&, i]
+                 {
+                     try
+                     {
+                         f(i);
+                     }
+                     catch (...)
+                     {
+                         std::lock_guard<std::mutex> lock(errorMutex);
+                         if (!error)
+                             error = std::current_exception();
+                     }
+                     remaining.fetch_sub(1, std::memory_order_acq_rel); });
+        // a worker that checked _queued before the pushes is either awake or already waiting
+        {
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+        }
+        _wake.notify_all();
+
+        while (remaining.load(std::memory_order_acquire) > 0)
+            if (!runOne(queue))
+                std::this_thread::yield();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    namespace parallel
+    {
+
+        /**
+         * @brief Smallest number of elements given to one task by element-wise kernels and reductions
+         */
+        inline constexpr size_t grainSize = size_t(1) << 15;
+
+        /**
+         * @brief Number of threads of the shared pool when setThreads was not called
+         *
+         * @return size_t Value of the M42_NUM_THREADS environment variable when it
+         * is a positive integer, otherwise the number of hardware threads
+         */
+        inline size_t defaultThreads()
+        {
+            if (const char *variable = std::getenv("M42_NUM_THREADS"))
+            {
+                char *end = nullptr;
+                unsigned long threads = std::strtoul(variable, &end, 10);
+                if (end != variable && *end == '\0' && threads > 0)
+                    return threads;
+            }
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /**
+         * @brief Storage of the pool shared by the library kernels
+         */
+        inline std::unique_ptr<ThreadPool> &poolInstance()
+        {
+            static std::unique_ptr<ThreadPool> instance;
+            return instance;
+        }
+
+        /**
+         * @brief Mutex guarding the creation and replacement of the shared pool
+         */
+        inline std::mutex &poolMutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        /**
+         * @brief Get the pool shared by the library kernels, started on first use
+         *
+         * @return ThreadPool& Pool of defaultThreads() threads unless setThreads was called
+         */
+        inline ThreadPool &pool()
+        {
+            std::lock_guard<std::mutex> lock(poolMutex());
+            std::unique_ptr<ThreadPool> &instance = poolInstance();
+            if (!instance)
+                instance = std::make_unique<ThreadPool>(defaultThreads());
+            return *instance;
+        }
+
+        /**
+         * @brief Set the number of threads used by the library kernels
+         *
+         * Replaces the shared pool, so it must not be called while a kernel
+         * is running. 1 makes every kernel sequential.
+         *
+         * @param threads Number of threads, at least 1
+         */
+        inline void setThreads(size_t threads)
+        {
+            std::unique_ptr<ThreadPool> replacement = std::make_unique<ThreadPool>(threads);
+            std::lock_guard<std::mutex> lock(poolMutex());
+            poolInstance() = std::move(replacement);
+        }
+
+        /**
+         * @brief Get the number of threads used by the library kernels
+         *
+         * @return size_t Size of the shared pool
+         */
+        inline size_t threads()
+        {
+            return pool().size();
+        }
+
+        /**
+         * @brief Call f(begin, end) on consecutive chunks covering [0, n)
+         *
+         * The range is cut into at most four chunks per thread of at least
+         * grain indices each; a single chunk runs on the calling thread
+         * without touching the pool.
+         *
+         * @param policy Execution policy
+         * @param n Size of the range
+         * @param grain Smallest chunk worth a task
+         * @param f Callable taking the bounds of a chunk
+         */
+        template <typename F>
+        void forRange(Execution policy, size_t n, size_t grain, F &&f)
+        {
+            if (policy == Execution::Sequential || n < 2 * std::max<size_t>(grain, 1))
+            {
+                f(size_t(0), n);
+                return;
+            }
+            ThreadPool &shared = pool();
+            size_t chunks = std::min(n / std::max<size_t>(grain, 1), 4 * shared.size());
+            if (shared.size() == 1)
+                chunks = 1;
+            shared.parallelFor(chunks, [&](size_t chunk)
+                               { f(chunk * n / chunks, (chunk + 1) * n / chunks); });
+        }
+
+        /**
+         * @brief Reduce [0, n) chunk by chunk and combine the partial results in order
+         *
+         * The chunking only depends on n, grain and the pool size, so the
+         * result is reproducible for a given thread count.
+         *
+         * @param policy Execution policy
+         * @param n Size of the range
+         * @param grain Smallest chunk worth a task
+         * @param identity Neutral element of combine
+         * @param map Callable reducing the chunk [begin, end)
+         * @param combine Callable merging two partial results
+         * @return R Reduction of the whole range
+         */
+        template <typename R, typename Map, typename Combine>
+        R reduce(Execution policy, size_t n, size_t grain, R identity, Map &&map, Combine &&combine)
+        {
+            if (policy == Execution::Sequential || n < 2 * std::max<size_t>(grain, 1))
+                return map(size_t(0), n);
+            ThreadPool &shared = pool();
+            if (shared.size() == 1)
+                return map(size_t(0), n);
+            size_t chunks = std::min(n / std::max<size_t>(grain, 1), 4 * shared.size());
+            std::vector<R> partial(chunks, identity);
+            shared.parallelFor(chunks, [&](size_t chunk)
+                               { partial[chunk] = map(chunk * n / chunks, (chunk + 1) * n / chunks); });
+            R result = identity;
+            for (const R &value : partial)
+                result = combine(result, value);
+            return result;
+        }
+
+    }
+
+}
+
+#endif
@@ -2,11 +2,13 @@
 #define M42_VECTOR_HPP
 
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <ostream>
 #include <utility>
 #include <vector>
 
+#include "memory.hpp"
 #include "VectorView.hpp"
 
 namespace m42
@@ -17,45 +19,74 @@ namespace m42
     /**
      * @brief Vector class
      *
+     * Storage comes from Allocator, 64-byte aligned by default.
+     *
      * @tparam T Type of vector elements
+     * @tparam Allocator Allocator of the elements
      */
-    template <Arithmetic T>
+    template <Arithmetic T, typename Allocator>
     class Vector : public VectorView<T>
     {
+    private:
+        using Traits = std::allocator_traits<Allocator>;
+
+        [[no_unique_address]] Allocator _allocator;
+
+        T *allocate(size_t size);
+
     public:
+        using allocator_type = Allocator;
+
         Vector();
-        Vector(size_t size);
+        Vector(size_t size, const Allocator &allocator = Allocator());
         Vector(std::initializer_list<T> list);
         Vector(const T *data, size_t size);
         Vector(const Vector &other);
         Vector(const VectorView<T> &v);
         Vector(Vector &&other) noexcept;
         Vector &operator=(Vector other);
+        template <typename E>
+        Vector &operator=(const VectorExpression<E> &expression);
         ~Vector();
+
+        Allocator allocator() const;
     };
 
+    /**
+     * @brief Allocate storage for size elements, nullptr when size is zero
+     */
+    template <Arithmetic T, typename Allocator>
+    T *Vector<T, Allocator>::allocate(size_t size)
+    {
+        return size == 0 ? nullptr : Traits::allocate(_allocator, size);
+    }
+
     /**
      * @brief Default constructor
      *
      */
-    template <Arithmetic T>
-    Vector<T>::Vector() : VectorView<T>(nullptr, 0) {}
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::Vector() : VectorView<T>(nullptr, 0) {}
 
     /**
      * @brief Construct a new Vector object with a given size
      *
      * @param size Size of the vector
+     * @param allocator Allocator of the elements
      */
-    template <Arithmetic T>
-    Vector<T>::Vector(size_t size) : VectorView<T>(new T[size], size) {}
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::Vector(size_t size, const Allocator &allocator) : VectorView<T>(nullptr, size), _allocator(allocator)
+    {
+        VectorView<T>::_data = allocate(size);
+    }
 
     /**
      * @brief Construct a new Vector object from an initializer list
      *
      * @param list Initializer list
      */
-    template <Arithmetic T>
-    Vector<T>::Vector(std::initializer_list<T> list) : VectorView<T>(new T[list.size()], list.size())
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::Vector(std::initializer_list<T> list) : Vector(list.size())
     {
         size_t i = 0;
         for (auto &elem : list)
@@ -67,8 +98,8 @@ namespace m42
      *
      * @param data Pointer to the vector data
      */
-    template <Arithmetic T>
-    Vector<T>::Vector(const T *data, size_t size) : VectorView<T>(new T[size], size)
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::Vector(const T *data, size_t size) : Vector(size)
     {
         for (size_t i = 0; i < size; i++)
             VectorView<T>::_data[i] = data[i];
@@ -79,8 +110,9 @@ namespace m42
      *
      * @param other Vector to copy
      */
-    template <Arithmetic T>
-    Vector<T>::Vector(const Vector &other) : VectorView<T>(new T[other.size()], other.size())
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::Vector(const Vector &other)
+        : Vector(other.size(), Traits::select_on_container_copy_construction(other._allocator))
     {
         for (size_t i = 0; i < other.size(); i++)
             VectorView<T>::_data[i] = other[i];
@@ -91,16 +123,20 @@ namespace m42
      *
      * @param other
      */
-    template <Arithmetic T>
-    Vector<T>::Vector(const VectorView<T> &v) : Vector(v.data(), v.size()) {}
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::Vector(const VectorView<T> &v) : Vector(v.size())
+    {
+        for (size_t i = 0; i < v.size(); i++)
+            VectorView<T>::_data[i] = v.data()[i * v.stride()];
+    }
 
     /**
      * @brief Move constructor
      *
      * @param other Vector to move
      */
-    template <Arithmetic T>
-    Vector<T>::Vector(Vector &&other) noexcept : VectorView<T>(other.data(), other.size())
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::Vector(Vector &&other) noexcept : VectorView<T>(other.data(), other.size()), _allocator(std::move(other._allocator))
     {
         other._data = nullptr;
         other._size = 0;
@@ -112,22 +148,53 @@ namespace m42
      * @param other Right-hand side of the assignment
      * @return Vector<T, N>& Left-hand side after assignment
      */
-    template <Arithmetic T>
-    Vector<T> &Vector<T>::operator=(Vector<T> other)
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator> &Vector<T, Allocator>::operator=(Vector other)
     {
-        // copy and swap idiom
+        // copy and swap idiom, other releases the old storage with its size and allocator
         std::swap(VectorView<T>::_data, other._data);
-        VectorView<T>::_size = other._size;
+        std::swap(VectorView<T>::_size, other._size);
+        std::swap(_allocator, other._allocator);
+        return *this;
+    }
+
+    /**
+     * @brief Evaluate an expression into the vector
+     *
+     * The existing storage is reused when the sizes match.
+     *
+     * @param expression Expression to evaluate
+     * @return Vector& Left-hand side after assignment
+     */
+    template <Arithmetic T, typename Allocator>
+    template <typename E>
+    Vector<T, Allocator> &Vector<T, Allocator>::operator=(const VectorExpression<E> &expression)
+    {
+        if (VectorView<T>::_size != expression.size())
+            return *this = Vector(expression);
+        expression.evaluateTo(VectorView<T>::_data);
         return *this;
     }
 
     /**
      * @brief Destroy Vector object
      */
-    template <Arithmetic T>
-    Vector<T>::~Vector()
+    template <Arithmetic T, typename Allocator>
+    Vector<T, Allocator>::~Vector()
+    {
+        if (VectorView<T>::_data)
+            Traits::deallocate(_allocator, VectorView<T>::_data, VectorView<T>::_size);
+    }
+
+    /**
+     * @brief Get a copy of the allocator of the elements
+     *
+     * @return Allocator Allocator of the elements
+     */
+    template <Arithmetic T, typename Allocator>
+    Allocator Vector<T, Allocator>::allocator() const
     {
-        delete[] VectorView<T>::_data;
+        return _allocator;
     }
 
 }
@@ -1,21 +1,28 @@
 #ifndef M42_VECTOR_VIEW_HPP
 #define M42_VECTOR_VIEW_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
 #include "common.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+#include "ThreadPool.hpp"
+#include "Expression.hpp"
 #include "Matrix.hpp"
 
 namespace m42
 {
 
-    template <Arithmetic T>
-    class Vector;
-
-    template <Arithmetic T>
-    class Matrix;
-
     /**
      * @brief Represents data in memory as a vector
      *
+     * Elements are stride() apart, so a view can also refer to a row or the
+     * diagonal of a column-major matrix. Operations on unit-stride views run
+     * the vectorized kernels, strided views fall back to scalar loops.
+     *
      * @tparam T Type of vector elements
      */
     template <Arithmetic T>
@@ -24,39 +31,43 @@ namespace m42
     protected:
         T *_data;
         size_t _size;
+        size_t _stride;
 
     public:
         using value_type = T;
 
         VectorView() = delete;
         VectorView(T *data, size_t size);
+        VectorView(T *data, size_t size, size_t stride);
         VectorView(const VectorView &other) = default;
         VectorView &operator=(const VectorView &other);
         VectorView &operator=(const Vector<T> &v);
+        template <typename E>
+        VectorView &operator=(const VectorExpression<E> &expression);
         ~VectorView() = default;
 
         size_t size() const;
+        size_t stride() const;
+        bool isContiguous() const;
         T *data();
         const T *data() const;
         Matrix<T> reshape() const;
-        double norm1() const;
-        double norm() const;
-        double normInf() const;
+        double norm1(Execution policy = Execution::Parallel) const;
+        double norm(Execution policy = Execution::Parallel) const;
+        double normInf(Execution policy = Execution::Parallel) const;
         bool isApprox(const VectorView &other, double epsilon = 1e-8) const;
 
         T &operator[](size_t index);
         const T &operator[](size_t index) const;
         bool operator==(const VectorView &other) const;
-        Vector<T> operator+(const VectorView &other) const;
-        Vector<T> operator-(const VectorView &other) const;
         VectorView<T> &operator+=(const VectorView &other);
         VectorView<T> &operator-=(const VectorView &other);
-        Vector<T> operator*(T scalar) const;
-        VectorView<T> operator*=(T scalar);
-        Vector<T> operator/(T scalar);
-        VectorView<T> operator/=(T scalar);
-        T operator*(const VectorView &other) const;
-        Vector<T> operator-() const;
+        template <typename E>
+        VectorView<T> &operator+=(const VectorExpression<E> &expression);
+        template <typename E>
+        VectorView<T> &operator-=(const VectorExpression<E> &expression);
+        VectorView<T> &operator*=(T scalar);
+        VectorView<T> &operator/=(T scalar);
         operator std::string() const;
     };
 
@@ -67,7 +78,21 @@ namespace m42
      * @param size Size of vector
      */
     template <Arithmetic T>
-    VectorView<T>::VectorView(T *data, size_t size) : _data(data), _size(size) {}
+    VectorView<T>::VectorView(T *data, size_t size) : _data(data), _size(size), _stride(1) {}
+
+    /**
+     * @brief Construct a new VectorView object over strided data
+     *
+     * @param data Pointer to the first element
+     * @param size Size of vector
+     * @param stride Distance between two consecutive elements, at least 1
+     */
+    template <Arithmetic T>
+    VectorView<T>::VectorView(T *data, size_t size, size_t stride) : _data(data), _size(size), _stride(stride)
+    {
+        if (stride == 0)
+            throw std::invalid_argument("Stride must be positive");
+    }
 
     /**
      * @brief Assignment operator
@@ -80,10 +105,10 @@ namespace m42
     {
         if (size() != other.size())
             throw std::invalid_argument("VectorView must be of the same size");
-        if (data() == other.data())
+        if (data() == other.data() && _stride == other._stride)
             return *this;
         for (size_t i = 0; i < _size; i++)
-            _data[i] = other._data[i];
+            _data[i * _stride] = other._data[i * other._stride];
         return *this;
     }
 
@@ -98,7 +123,23 @@ namespace m42
         if (size() != v.size())
             throw std::invalid_argument("Vector must be of the same size");
         for (size_t i = 0; i < _size; i++)
-            _data[i] = v[i];
+            _data[i * _stride] = v.data()[i];
+        return *this;
+    }
+
+    /**
+     * @brief Evaluate an expression directly into the viewed memory
+     *
+     * @param expression Expression to evaluate
+     * @return VectorView& Reference to self
+     */
+    template <Arithmetic T>
+    template <typename E>
+    VectorView<T> &VectorView<T>::operator=(const VectorExpression<E> &expression)
+    {
+        if (size() != expression.size())
+            throw std::invalid_argument("Vector must be of the same size");
+        expression.evaluateTo(_data, _stride);
         return *this;
     }
 
@@ -113,6 +154,29 @@ namespace m42
         return _size;
     }
 
+    /**
+     * @brief Get the distance between two consecutive elements
+     *
+     * @return size_t Stride of the vector
+     */
+    template <Arithmetic T>
+    size_t VectorView<T>::stride() const
+    {
+        return _stride;
+    }
+
+    /**
+     * @brief Check if the elements follow each other without gaps
+     *
+     * @return true Elements form one contiguous range
+     * @return false Elements are strided
+     */
+    template <Arithmetic T>
+    bool VectorView<T>::isContiguous() const
+    {
+        return _stride == 1 || _size <= 1;
+    }
+
     /**
      * @brief Get data pointer
      *
@@ -151,43 +215,68 @@ namespace m42
     /**
      * @brief Calculate the manhattan norm of the vector
      *
+     * @param policy Execution policy
      * @return double manhattan norm
      */
     template <Arithmetic T>
-    double VectorView<T>::norm1() const
+    double VectorView<T>::norm1(Execution policy) const
     {
+        if (isContiguous())
+            return parallel::reduce(
+                policy, _size, parallel::grainSize, T(0),
+                [this](size_t begin, size_t end)
+                { return simd::sumAbs(_data + begin, end - begin); },
+                [](T a, T b)
+                { return a + b; });
         T result = 0;
         for (size_t i = 0; i < _size; i++)
-            result += std::abs(_data[i]);
+            result += simd::scalarAbs(_data[i * _stride]);
         return result;
     }
 
     /**
      * @brief Calculate the euclidean norm of the vector
      *
+     * @param policy Execution policy
      * @return double euclidean norm
      */
     template <Arithmetic T>
-    double VectorView<T>::norm() const
+    double VectorView<T>::norm(Execution policy) const
     {
+        T sum = 0;
+        if (isContiguous())
+            sum = parallel::reduce(
+                policy, _size, parallel::grainSize, T(0),
+                [this](size_t begin, size_t end)
+                { return simd::sumSquares(_data + begin, end - begin); },
+                [](T a, T b)
+                { return a + b; });
+        else
+            for (size_t i = 0; i < _size; i++)
+                sum += _data[i * _stride] * _data[i * _stride];
         // use std::pow instead of std::sqrt
-        T result = 0;
-        for (size_t i = 0; i < _size; i++)
-            result = std::fma(_data[i], _data[i], result);
-        return std::pow(result, 0.5);
+        return std::pow(sum, 0.5);
     }
 
     /**
      * @brief Calculate the infinity norm of the vector
      *
+     * @param policy Execution policy
      * @return double infinity norm
      */
     template <Arithmetic T>
-    double VectorView<T>::normInf() const
+    double VectorView<T>::normInf(Execution policy) const
     {
+        if (isContiguous())
+            return parallel::reduce(
+                policy, _size, parallel::grainSize, T(0),
+                [this](size_t begin, size_t end)
+                { return simd::maxAbs(_data + begin, end - begin); },
+                [](T a, T b)
+                { return std::max(a, b); });
         T result = 0;
         for (size_t i = 0; i < _size; i++)
-            result = std::max(result, std::abs(_data[i]));
+            result = std::max(result, simd::scalarAbs(_data[i * _stride]));
         return result;
     }
 
@@ -204,9 +293,15 @@ namespace m42
     {
         if (_size != other._size)
             return false;
+        if (isContiguous() && other.isContiguous())
+            return !(simd::maxAbsDiff(_data, other._data, _size) > epsilon);
         for (size_t i = 0; i < _size; i++)
-            if (std::abs(_data[i] - other._data[i]) > epsilon)
+        {
+            T a = _data[i * _stride];
+            T b = other._data[i * other._stride];
+            if (static_cast<T>(a > b ? a - b : b - a) > epsilon)
                 return false;
+        }
         return true;
     }
 
@@ -221,7 +316,7 @@ namespace m42
     {
         if (index >= _size)
             throw std::out_of_range("Index out of range");
-        return _data[index];
+        return _data[index * _stride];
     }
 
     /**
@@ -248,82 +343,78 @@ namespace m42
     {
         if (_size != other._size)
             return false;
-        if (_data == other._data)
+        if (_data == other._data && _stride == other._stride)
             return true;
         for (size_t i = 0; i < _size; i++)
-            if (_data[i] != other._data[i])
+            if (_data[i * _stride] != other._data[i * other._stride])
                 return false;
         return true;
     }
 
     /**
-     * @brief Add two vectors
+     * @brief Add two vectors and assign the result to the first vector
      *
      * @param other Vector to add
      * @return Vector& Result of addition
      */
     template <Arithmetic T>
-    Vector<T> VectorView<T>::operator+(const VectorView &other) const
+    VectorView<T> &VectorView<T>::operator+=(const VectorView &other)
     {
         if (_size != other._size)
             throw std::invalid_argument("Vectors must be of the same size");
-        Vector<T> result(_size);
-        for (size_t i = 0; i < _size; i++)
-            result[i] = _data[i] + other._data[i];
-        return result;
+        if (isContiguous() && other.isContiguous())
+            parallel::forRange(Execution::Parallel, _size, parallel::grainSize, [&](size_t begin, size_t end)
+                               { simd::add(_data + begin, other._data + begin, _data + begin, end - begin); });
+        else
+            for (size_t i = 0; i < _size; i++)
+                _data[i * _stride] += other._data[i * other._stride];
+        return *this;
     }
 
     /**
-     * @brief Subtract two vectors
+     * @brief Subtract two vectors and assign the result to the first vector
      *
      * @param other Vector to subtract
      * @return Vector& Result of subtraction
      */
     template <Arithmetic T>
-    Vector<T> VectorView<T>::operator-(const VectorView &other) const
-    {
-        return (*this) + (-other);
-    }
-
-    /**
-     * @brief Add two vectors and assign the result to the first vector
-     *
-     * @param other Vector to add
-     * @return Vector& Result of addition
-     */
-    template <Arithmetic T>
-    VectorView<T> &VectorView<T>::operator+=(const VectorView &other)
+    VectorView<T> &VectorView<T>::operator-=(const VectorView &other)
     {
-        (*this) = (*this) + other;
+        if (_size != other._size)
+            throw std::invalid_argument("Vectors must be of the same size");
+        if (isContiguous() && other.isContiguous())
+            parallel::forRange(Execution::Parallel, _size, parallel::grainSize, [&](size_t begin, size_t end)
+                               { simd::subtract(_data + begin, other._data + begin, _data + begin, end - begin); });
+        else
+            for (size_t i = 0; i < _size; i++)
+                _data[i * _stride] -= other._data[i * other._stride];
         return *this;
     }
 
     /**
-     * @brief Subtract two vectors and assign the result to the first vector
+     * @brief Add an expression to the vector in a single pass
      *
-     * @param other Vector to subtract
-     * @return Vector& Result of subtraction
+     * @param expression Expression to add
+     * @return VectorView& Result of addition
      */
     template <Arithmetic T>
-    VectorView<T> &VectorView<T>::operator-=(const VectorView &other)
+    template <typename E>
+    VectorView<T> &VectorView<T>::operator+=(const VectorExpression<E> &expression)
     {
-        (*this) = (*this) - other;
-        return *this;
+        return (*this) = (*this) + expression;
     }
 
     /**
-     * @brief Multiply a vector by a scalar
+     * @brief Subtract an expression from the vector in a single pass
      *
-     * @param scalar Scalar to multiply by
-     * @return Vector& Result of multiplication
+     * @param expression Expression to subtract
+     * @return VectorView& Result of subtraction
      */
     template <Arithmetic T>
-    Vector<T> VectorView<T>::operator*(T scalar) const
+    template <typename E>
+    VectorView<T> &VectorView<T>::operator-=(const VectorExpression<E> &expression)
     {
-        Vector<T> result(_size);
-        for (size_t i = 0; i < _size; i++)
-            result[i] = _data[i] * scalar;
-        return result;
+        return (*this) = (*this) - expression;
     }
 
     /**
@@ -333,27 +424,17 @@ namespace m42
      * @return Vector& Result of multiplication
      */
     template <Arithmetic T>
-    VectorView<T> VectorView<T>::operator*=(T scalar)
+    VectorView<T> &VectorView<T>::operator*=(T scalar)
     {
-        (*this) = (*this) * scalar;
+        if (isContiguous())
+            parallel::forRange(Execution::Parallel, _size, parallel::grainSize, [&](size_t begin, size_t end)
+                               { simd::multiply(_data + begin, scalar, _data + begin, end - begin); });
+        else
+            for (size_t i = 0; i < _size; i++)
+                _data[i * _stride] *= scalar;
         return *this;
     }
 
-    /**
-     * @brief Divide a vector by a scalar
-     *
-     * @param scalar Scalar to divide by
-     * @return Vector Result of division
-     */
-    template <Arithmetic T>
-    Vector<T> VectorView<T>::operator/(T scalar)
-    {
-        Vector<T> result(_size);
-        for (size_t i = 0; i < _size; i++)
-            result[i] = _data[i] / scalar;
-        return result;
-    }
-
     /**
      * @brief Divide a vector by a scalar and assign the result to the vector
      *
@@ -361,44 +442,17 @@ namespace m42
      * @return Vector& Result of division
      */
     template <Arithmetic T>
-    VectorView<T> VectorView<T>::operator/=(T scalar)
+    VectorView<T> &VectorView<T>::operator/=(T scalar)
     {
-        (*this) = (*this) / scalar;
+        if (isContiguous())
+            parallel::forRange(Execution::Parallel, _size, parallel::grainSize, [&](size_t begin, size_t end)
+                               { simd::divide(_data + begin, scalar, _data + begin, end - begin); });
+        else
+            for (size_t i = 0; i < _size; i++)
+                _data[i * _stride] /= scalar;
         return *this;
     }
 
-    /**
-     * @brief Dot product of two vectors
-     *
-     * @param other Vector to multiply by
-     * @return T Dot product
-     */
-    template <Arithmetic T>
-    T VectorView<T>::operator*(const VectorView &other) const
-    {
-        if (_size != other._size)
-            throw std::invalid_argument("Vectors must be of the same size");
-        T result = 0;
-        // use std::fma
-        for (size_t i = 0; i < _size; i++)
-            result = std::fma(_data[i], other._data[i], result);
-        return result;
-    }
-
-    /**
-     * @brief Negate a vector
-     *
-     * @return Vector Negated vector
-     */
-    template <Arithmetic T>
-    Vector<T> VectorView<T>::operator-() const
-    {
-        Vector<T> result(_size);
-        for (size_t i = 0; i < _size; i++)
-            result[i] = -_data[i];
-        return result;
-    }
-
     /**
      * @brief Return a string representation of the vector
      *
@@ -0,0 +1,308 @@
+#ifndef M42_BANDED_HPP
+#define M42_BANDED_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+#include "common.hpp"
+#include "simd.hpp"
+
+/**
+ * Kernels on banded storage. Two layouts are used: diagonal-wise, where
+ * every diagonal is a contiguous array and products vectorize along the
+ * diagonals, and the column-wise LAPACK layout used by the factorization,
+ * where element (i, j) of an n x n matrix with kl subdiagonals and ku
+ * superdiagonals lives at ab[j * ldab + ku + i - j].
+ */
+namespace m42::banded
+{
+
+    /**
+     * @brief y = A * x for a square matrix stored by diagonals
+     *
+     * Diagonal d, with d from ku down to -kl, starts at diagonals +
+     * (ku - d) * n and holds n - |d| elements, the first one in row
+     * max(0, -d) and column max(0, d).
+     *
+     * @param n Size of the matrix
+     * @param kl Number of subdiagonals
+     * @param ku Number of superdiagonals
+     * @param diagonals Diagonal-wise storage, (kl + ku + 1) * n elements
+     * @param x Dense vector of n elements
+     * @param y Dense vector of n elements, overwritten
+     */
+    template <Arithmetic T>
+    void dgbmv(size_t n, size_t kl, size_t ku, const T *diagonals, const T *x, T *y)
+    {
+        if (n == 0)
+            return;
+        std::fill(y, y + n, T(0));
+        for (size_t r = 0; r < kl + ku + 1; r++)
+        {
+            const T *diagonal = diagonals + r * n;
+            if (r <= ku)
+            {
+                size_t d = ku - r;
+                simd::multiplyAccumulate(diagonal, x + d, y, n - d);
+            }
+            else
+            {
+                size_t d = r - ku;
+                simd::multiplyAccumulate(diagonal, x, y + d, n - d);
+            }
+        }
+    }
+
+    /**
+     * @brief LU factorization with partial pivoting in LAPACK band layout
+     *
+     * The rows interchanged into a column create up to kl extra
+     * superdiagonals of U, so ab must have ldab >= 2 * kl + ku + 1 with the
+     * matrix in rows kl to 2 * kl + ku and the first kl rows zeroed. L is
+     * stored below the diagonal, pivots[j] is the row swapped with row j.
+     *
+     * @param n Size of the matrix
+     * @param kl Number of subdiagonals
+     * @param ku Number of superdiagonals
+     * @param ab Band storage, overwritten by the factors
+     * @param ldab Leading dimension of ab
+     * @param pivots Row interchanges, n elements
+     * @return true The matrix is nonsingular
+     * @return false A zero pivot was found, the factors cannot be used to solve
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH bool gbtrf(size_t n, size_t kl, size_t ku, T *ab, size_t ldab, size_t *pivots)
+    {
+        size_t kv = kl + ku;
+        size_t last = 0;
+        bool nonsingular = true;
+        for (size_t j = 0; j < n; j++)
+        {
+            T *column = ab + j * ldab + kv;
+            size_t km = std::min(kl, n - 1 - j);
+            size_t p = 0;
+            for (size_t i = 1; i <= km; i++)
+                if (std::abs(column[i]) > std::abs(column[p]))
+                    p = i;
+            pivots[j] = j + p;
+            if (column[p] == T(0))
+            {
+                nonsingular = false;
+                continue;
+            }
+            last = std::max(last, std::min(j + ku + p, n - 1));
+            // element (i, c) is at ab[c * ldab + kv + i - c], row j moves up one slot per column
+            if (p != 0)
+                for (size_t c = j; c <= last; c++)
+                    std::swap(ab[c * ldab + kv + j - c], ab[c * ldab + kv + j + p - c]);
+            if (km == 0)
+                continue;
+            simd::multiply(column + 1, T(1) / column[0], column + 1, km);
+            for (size_t c = j + 1; c <= last; c++)
+            {
+                T *target = ab + c * ldab + kv + j - c;
+                simd::axpy(-*target, column + 1, target + 1, km);
+            }
+        }
+        return nonsingular;
+    }
+
+    /**
+     * @brief Solve A * X = B with the factors from gbtrf
+     *
+     * @param n Size of the matrix
+     * @param kl Number of subdiagonals
+     * @param ku Number of superdiagonals
+     * @param nrhs Number of right-hand sides
+     * @param ab Factors from gbtrf
+     * @param ldab Leading dimension of ab
+     * @param pivots Row interchanges from gbtrf
+     * @param b Right-hand sides, column-major, overwritten by the solutions
+     * @param ldb Leading dimension of b
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void gbtrs(size_t n, size_t kl, size_t ku, size_t nrhs, const T *ab, size_t ldab,
+                                 const size_t *pivots, T *b, size_t ldb)
+    {
+        size_t kv = kl + ku;
+        for (size_t k = 0; k < nrhs; k++)
+        {
+            T *x = b + k * ldb;
+            for (size_t j = 0; j + 1 < n; j++)
+            {
+                if (pivots[j] != j)
+                    std::swap(x[j], x[pivots[j]]);
+                size_t lm = std::min(kl, n - 1 - j);
+                simd::axpy(-x[j], ab + j * ldab + kv + 1, x + j + 1, lm);
+            }
+            for (size_t j = n; j-- > 0;)
+            {
+                x[j] /= ab[j * ldab + kv];
+                size_t i0 = j > kv ? j - kv : 0;
+                simd::axpy(-x[j], ab + j * ldab + kv - (j - i0), x + i0, j - i0);
+            }
+        }
+    }
+
+    /**
+     * @brief Thomas algorithm, Gaussian elimination without pivoting on a tridiagonal matrix
+     *
+     * The elimination is computed once and applied to every right-hand
+     * side. Stable for diagonally dominant and symmetric positive definite
+     * matrices.
+     *
+     * @param n Size of the matrix
+     * @param nrhs Number of right-hand sides
+     * @param lower Subdiagonal, n - 1 elements
+     * @param diagonal Diagonal, n elements
+     * @param upper Superdiagonal, n - 1 elements
+     * @param b Right-hand sides, column-major, overwritten by the solutions
+     * @param ldb Leading dimension of b
+     * @param scratch 2 * n elements
+     * @return true Solved
+     * @return false A zero pivot was found, b is left untouched
+     */
+    template <std::floating_point T>
+    bool gtsv(size_t n, size_t nrhs, const T *lower, const T *diagonal, const T *upper, T *b, size_t ldb, T *scratch)
+    {
+        if (n == 0)
+            return true;
+        // modified superdiagonal and reciprocal pivots
+        T *c = scratch;
+        T *inverse = scratch + n;
+        for (size_t i = 0; i < n; i++)
+        {
+            T pivot = i == 0 ? diagonal[0] : diagonal[i] - lower[i - 1] * c[i - 1];
+            if (pivot == T(0))
+                return false;
+            inverse[i] = T(1) / pivot;
+            c[i] = i + 1 < n ? upper[i] * inverse[i] : T(0);
+        }
+        for (size_t k = 0; k < nrhs; k++)
+        {
+            T *x = b + k * ldb;
+            x[0] *= inverse[0];
+            for (size_t i = 1; i < n; i++)
+                x[i] = (x[i] - lower[i - 1] * x[i - 1]) * inverse[i];
+            for (size_t i = n - 1; i-- > 0;)
+                x[i] -= c[i] * x[i + 1];
+        }
+        return true;
+    }
+
+    /**
+     * @brief Forward sweep of gtsvBatch over equation i of every system
+     *
+     * The first equation has no subdiagonal and the last one no
+     * superdiagonal, their slots are never read. c receives the negated
+     * modified superdiagonal, so the back substitution is a
+     * multiply-accumulate.
+     *
+     * @tparam First Equation 0, l, cPrevious and xPrevious are not read
+     * @tparam Last Equation n - 1, u and c are not touched
+     * @return true Every pivot is finite and nonzero
+     * @return false Some pivot is zero or not finite
+     */
+    template <bool First, bool Last, std::floating_point T>
+    inline bool gtsvBatchStep(size_t count, const T *l, const T *d, const T *u,
+                              const T *cPrevious, const T *xPrevious, T *c, T *x)
+    {
+        using simd::packet;
+        using simd::Packet;
+        constexpr T infinity = std::numeric_limits<T>::infinity();
+        bool finite = true;
+        size_t k = 0;
+        if constexpr (simd::Vectorizable<T>)
+        {
+            Packet<T> one = Packet<T>{} + T(1);
+            Packet<T> limit = Packet<T>{} + infinity;
+            // 1 in the lanes whose reciprocal pivot is infinite or NaN
+            Packet<T> bad = {};
+            for (; k + simd::lanes<T> <= count; k += simd::lanes<T>)
+            {
+                Packet<T> pivot = packet(d + k);
+                Packet<T> xk = packet(x + k);
+                if constexpr (!First)
+                {
+                    pivot += packet(l + k) * packet(cPrevious + k);
+                    xk -= packet(l + k) * packet(xPrevious + k);
+                }
+                Packet<T> inverse = one / pivot;
+                if constexpr (!Last)
+                    packet(c + k) = -packet(u + k) * inverse;
+                packet(x + k) = xk * inverse;
+                simd::absInPlace<T>(inverse);
+                bad = inverse < limit ? bad : one;
+            }
+            finite = simd::reduceMax<T>(bad) == T(0);
+        }
+        for (; k < count; k++)
+        {
+            T pivot = d[k];
+            T xk = x[k];
+            if constexpr (!First)
+            {
+                pivot += l[k] * cPrevious[k];
+                xk -= l[k] * xPrevious[k];
+            }
+            T inverse = T(1) / pivot;
+            if constexpr (!Last)
+                c[k] = -u[k] * inverse;
+            x[k] = xk * inverse;
+            if (!(std::abs(inverse) < infinity))
+                finite = false;
+        }
+        return finite;
+    }
+
+    /**
+     * @brief Thomas algorithm on many independent tridiagonal systems at once
+     *
+     * Column i of every operand holds equation i of all systems, so the
+     * sweeps run the same recurrence across systems on contiguous data, one
+     * packet of systems at a time. Element 0 of lower and element n - 1 of
+     * upper are never read.
+     *
+     * @param n Size of every system
+     * @param count Number of systems
+     * @param lower Subdiagonals, column-major count x n
+     * @param ldl Leading dimension of lower
+     * @param diagonal Diagonals, column-major count x n
+     * @param ldd Leading dimension of diagonal
+     * @param upper Superdiagonals, column-major count x n
+     * @param ldu Leading dimension of upper
+     * @param b Right-hand sides, column-major count x n, overwritten by the solutions
+     * @param ldb Leading dimension of b
+     * @param scratch n * count elements
+     * @return true Solved
+     * @return false A zero or non-finite pivot was found in some system, b is unspecified
+     */
+    template <std::floating_point T>
+    M42_SIMD_DISPATCH bool gtsvBatch(size_t n, size_t count,
+                                     const T *lower, size_t ldl, const T *diagonal, size_t ldd,
+                                     const T *upper, size_t ldu, T *b, size_t ldb, T *scratch)
+    {
+        if (n == 0)
+            return true;
+        if (n == 1)
+            return gtsvBatchStep<true, true, T>(count, nullptr, diagonal, nullptr, nullptr, nullptr, nullptr, b);
+        T *c = scratch;
+        bool finite = gtsvBatchStep<true, false, T>(count, nullptr, diagonal, upper, nullptr, nullptr, c, b);
+        for (size_t i = 1; i + 1 < n; i++)
+            finite &= gtsvBatchStep<false, false, T>(count, lower + i * ldl, diagonal + i * ldd, upper + i * ldu,
+                                                     c + (i - 1) * count, b + (i - 1) * ldb, c + i * count,
+                                                     b + i * ldb);
+        finite &= gtsvBatchStep<false, true, T>(count, lower + (n - 1) * ldl, diagonal + (n - 1) * ldd, nullptr,
+                                                c + (n - 2) * count, b + (n - 2) * ldb, nullptr, b + (n - 1) * ldb);
+        for (size_t i = n - 1; i-- > 0;)
+            simd::multiplyAccumulate(c + i * count, b + (i + 1) * ldb, b + i * ldb, count);
+        return finite;
+    }
+
+}
+
+#endif
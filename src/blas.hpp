@@ -0,0 +1,735 @@
+#ifndef M42_BLAS_HPP
+#define M42_BLAS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "simd.hpp"
+#include "ThreadPool.hpp"
+
+namespace m42::blas
+{
+
+    /**
+     * @brief General matrix-vector product y = alpha * A * x + beta * y
+     *
+     * A is an m x n column-major matrix. The product is accumulated column by
+     * column as axpy updates, which read A contiguously in this layout.
+     *
+     * @param m Number of rows of A and size of y
+     * @param n Number of columns of A and size of x
+     * @param alpha Scale of the product
+     * @param a Pointer to A
+     * @param lda Leading dimension of A
+     * @param x Pointer to x
+     * @param beta Scale of y, y is not read when beta is zero
+     * @param y Pointer to y
+     */
+    template <Arithmetic T>
+    void gemv(size_t m, size_t n, T alpha, const T *a, size_t lda, const T *x, T beta, T *y)
+    {
+        if (beta == T(0))
+            std::fill(y, y + m, T(0));
+        else if (beta != T(1))
+            simd::multiply(y, beta, y, m);
+        if (alpha == T(0))
+            return;
+        for (size_t j = 0; j < n; j++)
+            simd::axpy(alpha * x[j], a + j * lda, y, m);
+    }
+
+    /**
+     * @brief Transposed matrix-vector product y = alpha * A^T * x + beta * y
+     *
+     * A is an m x n column-major matrix, so every element of y is a dot
+     * product of x with a contiguous column of A and A^T is never formed.
+     *
+     * @param m Number of rows of A and size of x
+     * @param n Number of columns of A and size of y
+     * @param alpha Scale of the product
+     * @param a Pointer to A
+     * @param lda Leading dimension of A
+     * @param x Pointer to x
+     * @param beta Scale of y, y is not read when beta is zero
+     * @param y Pointer to y
+     */
+    template <Arithmetic T>
+    void gemvTransposed(size_t m, size_t n, T alpha, const T *a, size_t lda, const T *x, T beta, T *y)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            T product = alpha * simd::dot(a + j * lda, x, m);
+            y[j] = beta == T(0) ? product : product + beta * y[j];
+        }
+    }
+
+    /**
+     * @brief Blocking parameters of the GEMM engine
+     *
+     * MR x NR is the register tile computed by the microkernel, KC x NR
+     * micro-panels of B are meant to stay in L1, MC x KC blocks of A in L2
+     * and KC x NC panels of B in L3. Products with fewer than PARALLEL
+     * multiply-adds stay on the calling thread.
+     *
+     * @tparam T Type of matrix components
+     */
+    template <Arithmetic T>
+    struct GemmBlocking
+    {
+        static constexpr size_t MR = std::clamp<size_t>(64 / sizeof(T), 4, 16);
+        static constexpr size_t NR = 4;
+        static constexpr size_t KC = 256;
+        static constexpr size_t MC = MR * (128 / MR);
+        static constexpr size_t NC = NR * 1024;
+        static constexpr size_t PARALLEL = 128 * 128 * 128;
+    };
+
+    /**
+     * @brief Pack an mc x kc block of A into row micro-panels of height MR
+     *
+     * Each micro-panel is stored as kc consecutive columns of MR elements,
+     * rows past mc are padded with zeros.
+     *
+     * @param mc Number of rows of the block
+     * @param kc Number of columns of the block
+     * @param a Pointer to the first element of the block
+     * @param lda Leading dimension of A
+     * @param buffer Destination buffer of size roundUp(mc, MR) * kc
+     */
+    template <Arithmetic T>
+    void packA(size_t mc, size_t kc, const T *a, size_t lda, T *buffer)
+    {
+        constexpr size_t MR = GemmBlocking<T>::MR;
+        for (size_t i = 0; i < mc; i += MR)
+        {
+            size_t mr = std::min(MR, mc - i);
+            for (size_t p = 0; p < kc; p++)
+            {
+                const T *column = a + p * lda + i;
+                for (size_t r = 0; r < mr; r++)
+                    buffer[r] = column[r];
+                for (size_t r = mr; r < MR; r++)
+                    buffer[r] = 0;
+                buffer += MR;
+            }
+        }
+    }
+
+    /**
+     * @brief Pack an mc x kc block of A^T into row micro-panels of height MR
+     *
+     * Same layout as packA, but reads the block from the kc x mc matrix A.
+     *
+     * @param mc Number of rows of the block of A^T
+     * @param kc Number of columns of the block of A^T
+     * @param a Pointer to the first element of the block of A
+     * @param lda Leading dimension of A
+     * @param buffer Destination buffer of size roundUp(mc, MR) * kc
+     */
+    template <Arithmetic T>
+    void packATransposed(size_t mc, size_t kc, const T *a, size_t lda, T *buffer)
+    {
+        constexpr size_t MR = GemmBlocking<T>::MR;
+        for (size_t i = 0; i < mc; i += MR)
+        {
+            size_t mr = std::min(MR, mc - i);
+            for (size_t p = 0; p < kc; p++)
+            {
+                for (size_t r = 0; r < mr; r++)
+                    buffer[r] = a[(i + r) * lda + p];
+                for (size_t r = mr; r < MR; r++)
+                    buffer[r] = 0;
+                buffer += MR;
+            }
+        }
+    }
+
+    /**
+     * @brief Pack a kc x nc block of B into column micro-panels of width NR
+     *
+     * Each micro-panel is stored as kc consecutive rows of NR elements,
+     * columns past nc are padded with zeros.
+     *
+     * @param kc Number of rows of the block
+     * @param nc Number of columns of the block
+     * @param b Pointer to the first element of the block
+     * @param ldb Leading dimension of B
+     * @param buffer Destination buffer of size kc * roundUp(nc, NR)
+     */
+    template <Arithmetic T>
+    void packB(size_t kc, size_t nc, const T *b, size_t ldb, T *buffer)
+    {
+        constexpr size_t NR = GemmBlocking<T>::NR;
+        for (size_t j = 0; j < nc; j += NR)
+        {
+            size_t nr = std::min(NR, nc - j);
+            for (size_t p = 0; p < kc; p++)
+            {
+                for (size_t c = 0; c < nr; c++)
+                    buffer[c] = b[(j + c) * ldb + p];
+                for (size_t c = nr; c < NR; c++)
+                    buffer[c] = 0;
+                buffer += NR;
+            }
+        }
+    }
+
+    /**
+     * @brief Compute an MR x NR tile C = alpha * A * B + beta * C from packed micro-panels
+     *
+     * The accumulator tile is kept in local storage so that the compiler can
+     * map it onto vector registers; only the mr x nr top-left part is written back.
+     *
+     * @param kc Shared dimension of the micro-panels
+     * @param alpha Scale of the product
+     * @param a Packed micro-panel of A
+     * @param b Packed micro-panel of B
+     * @param beta Scale of C, C is not read when beta is zero
+     * @param c Pointer to the tile of C
+     * @param ldc Leading dimension of C
+     * @param mr Number of valid rows of the tile
+     * @param nr Number of valid columns of the tile
+     */
+    template <Arithmetic T>
+    void microkernel(size_t kc, T alpha, const T *a, const T *b, T beta, T *c, size_t ldc, size_t mr, size_t nr)
+    {
+        constexpr size_t MR = GemmBlocking<T>::MR;
+        constexpr size_t NR = GemmBlocking<T>::NR;
+        T ab[NR][MR] = {};
+        for (size_t p = 0; p < kc; p++)
+        {
+            for (size_t j = 0; j < NR; j++)
+                for (size_t i = 0; i < MR; i++)
+                    ab[j][i] += a[i] * b[j];
+            a += MR;
+            b += NR;
+        }
+        for (size_t j = 0; j < nr; j++)
+        {
+            T *column = c + j * ldc;
+            if (beta == T(0))
+                for (size_t i = 0; i < mr; i++)
+                    column[i] = alpha * ab[j][i];
+            else
+                for (size_t i = 0; i < mr; i++)
+                    column[i] = alpha * ab[j][i] + beta * column[i];
+        }
+    }
+
+    /**
+     * @brief Scale an m x n column-major matrix, C is not read when beta is zero
+     *
+     * @param m Number of rows
+     * @param n Number of columns
+     * @param beta Scale factor
+     * @param c Pointer to the matrix data
+     * @param ldc Leading dimension of C
+     */
+    template <Arithmetic T>
+    void scale(size_t m, size_t n, T beta, T *c, size_t ldc)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            T *column = c + j * ldc;
+            for (size_t i = 0; i < m; i++)
+                column[i] = beta == T(0) ? T(0) : beta * column[i];
+        }
+    }
+
+    /**
+     * @brief Blocked product on one block of C, run by a single thread
+     *
+     * @tparam TransposedA Whether a points to the k x m matrix whose transpose is multiplied
+     */
+    template <bool TransposedA, Arithmetic T>
+    void gemmBlock(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc)
+    {
+        using Blocking = GemmBlocking<T>;
+        constexpr size_t MR = Blocking::MR;
+        constexpr size_t NR = Blocking::NR;
+
+        // packing buffers come from the scratch arena of the thread running the block
+        ScratchScope scope;
+        size_t sizeA = Blocking::MC * std::min(Blocking::KC, k);
+        size_t sizeB = std::min(Blocking::KC, k) * ((std::min(Blocking::NC, n) + NR - 1) / NR * NR);
+        T *packedA = ScratchAllocator<T>().allocate(sizeA);
+        T *packedB = ScratchAllocator<T>().allocate(sizeB);
+
+        for (size_t jc = 0; jc < n; jc += Blocking::NC)
+        {
+            size_t nc = std::min(Blocking::NC, n - jc);
+            for (size_t pc = 0; pc < k; pc += Blocking::KC)
+            {
+                size_t kc = std::min(Blocking::KC, k - pc);
+                // the first pass over k applies beta, later passes accumulate
+                T betaPass = pc == 0 ? beta : T(1);
+                packB(kc, nc, b + jc * ldb + pc, ldb, packedB);
+                for (size_t ic = 0; ic < m; ic += Blocking::MC)
+                {
+                    size_t mc = std::min(Blocking::MC, m - ic);
+                    if constexpr (TransposedA)
+                        packATransposed(mc, kc, a + ic * lda + pc, lda, packedA);
+                    else
+                        packA(mc, kc, a + pc * lda + ic, lda, packedA);
+                    for (size_t jr = 0; jr < nc; jr += NR)
+                    {
+                        size_t nr = std::min(NR, nc - jr);
+                        for (size_t ir = 0; ir < mc; ir += MR)
+                        {
+                            size_t mr = std::min(MR, mc - ir);
+                            microkernel(kc, alpha,
+                                        packedA + ir * kc,
+                                        packedB + jr * kc,
+                                        betaPass,
+                                        c + (jc + jr) * ldc + ic + ir, ldc,
+                                        mr, nr);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Multi-threaded GEMM driver
+     *
+     * C is cut into a grid of MC-row by NR-multiple-column tiles, about four
+     * per thread so that work stealing evens out ragged edges, and every
+     * tile is a task packing its own A and B blocks into the scratch arena of
+     * the thread that runs it. When the grid has fewer tiles than threads and k
+     * is long, k is split as well: each slice of k accumulates into a
+     * private copy of C and the copies are summed column by column at the end.
+     *
+     * @tparam TransposedA Whether a points to the k x m matrix whose transpose is multiplied
+     */
+    template <bool TransposedA, Arithmetic T>
+    void gemmParallel(ThreadPool &pool, size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc)
+    {
+        using Blocking = GemmBlocking<T>;
+        constexpr size_t NR = Blocking::NR;
+        const size_t threads = pool.size();
+
+        size_t tileM = Blocking::MC;
+        size_t rowTiles = (m + tileM - 1) / tileM;
+        size_t columnTiles = std::min((4 * threads + rowTiles - 1) / rowTiles, (n + NR - 1) / NR);
+        size_t tileN = std::min(Blocking::NC, ((n + columnTiles - 1) / columnTiles + NR - 1) / NR * NR);
+        columnTiles = (n + tileN - 1) / tileN;
+        size_t tiles = rowTiles * columnTiles;
+
+        size_t sliceK = k;
+        if (tiles < threads && k >= 2 * Blocking::KC)
+        {
+            size_t slices = std::min((threads + tiles - 1) / tiles, k / Blocking::KC);
+            sliceK = ((k + slices - 1) / slices + Blocking::KC - 1) / Blocking::KC * Blocking::KC;
+        }
+        size_t slices = (k + sliceK - 1) / sliceK;
+        ScratchScope scope;
+        T *partial = slices > 1 ? ScratchAllocator<T>().allocate((slices - 1) * m * n) : nullptr;
+
+        pool.parallelFor(tiles * slices, [&](size_t task)
+                         {
+                             size_t slice = task / tiles;
+                             size_t ic = task % tiles % rowTiles * tileM;
+                             size_t jc = task % tiles / rowTiles * tileN;
+                             size_t pc = slice * sliceK;
+                             const T *blockA = TransposedA ? a + ic * lda + pc : a + pc * lda + ic;
+                             const T *blockB = b + jc * ldb + pc;
+                             T *blockC = slice == 0 ? c + jc * ldc + ic : partial + ((slice - 1) * n + jc) * m + ic;
+                             gemmBlock<TransposedA>(std::min(tileM, m - ic), std::min(tileN, n - jc), std::min(sliceK, k - pc),
+                                                    alpha, blockA, lda, blockB, ldb,
+                                                    slice == 0 ? beta : T(0), blockC, slice == 0 ? ldc : m); });
+
+        if (slices > 1)
+            pool.parallelFor(columnTiles, [&](size_t tile)
+                             {
+                                 for (size_t j = tile * tileN; j < std::min(n, (tile + 1) * tileN); j++)
+                                     for (size_t slice = 1; slice < slices; slice++)
+                                         simd::add(c + j * ldc, partial + ((slice - 1) * n + j) * m, c + j * ldc, m); });
+    }
+
+    /**
+     * @brief Blocked GEMM driver shared by gemm and gemmTransposed
+     *
+     * Runs on the shared thread pool unless the policy is sequential, the
+     * product is too small to amortize the scheduling or the pool has a
+     * single thread.
+     *
+     * @tparam TransposedA Whether a points to the k x m matrix whose transpose is multiplied
+     */
+    template <bool TransposedA, Arithmetic T>
+    void gemmBlocked(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc, Execution policy)
+    {
+        if (m == 0 || n == 0)
+            return;
+        if (k == 0 || alpha == T(0))
+        {
+            scale(m, n, beta, c, ldc);
+            return;
+        }
+
+        if (policy == Execution::Parallel && m * n * k >= GemmBlocking<T>::PARALLEL)
+        {
+            ThreadPool &pool = parallel::pool();
+            if (pool.size() > 1)
+            {
+                gemmParallel<TransposedA>(pool, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+                return;
+            }
+        }
+        gemmBlock<TransposedA>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+
+    /**
+     * @brief General matrix-matrix product C = alpha * A * B + beta * C
+     *
+     * All matrices are stored in column-major order. A is m x k, B is k x n and
+     * C is m x n. A and B are packed block by block into contiguous buffers
+     * and every MR x NR tile of C is computed by the register-tiled microkernel.
+     * Large products are spread over the threads of parallel::pool().
+     *
+     * @param m Number of rows of A and C
+     * @param n Number of columns of B and C
+     * @param k Number of columns of A and rows of B
+     * @param alpha Scale of the product
+     * @param a Pointer to A
+     * @param lda Leading dimension of A
+     * @param b Pointer to B
+     * @param ldb Leading dimension of B
+     * @param beta Scale of C, C is not read when beta is zero
+     * @param c Pointer to C
+     * @param ldc Leading dimension of C
+     * @param policy Execution policy
+     */
+    template <Arithmetic T>
+    void gemm(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc, Execution policy = Execution::Parallel)
+    {
+        gemmBlocked<false>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, policy);
+    }
+
+    /**
+     * @brief Transposed matrix-matrix product C = alpha * A^T * B + beta * C
+     *
+     * A is a k x m column-major matrix, its transpose is formed block by
+     * block while packing and never stored whole.
+     *
+     * @param m Number of columns of A and rows of C
+     * @param n Number of columns of B and C
+     * @param k Number of rows of A and B
+     * @param alpha Scale of the product
+     * @param a Pointer to A
+     * @param lda Leading dimension of A
+     * @param b Pointer to B
+     * @param ldb Leading dimension of B
+     * @param beta Scale of C, C is not read when beta is zero
+     * @param c Pointer to C
+     * @param ldc Leading dimension of C
+     * @param policy Execution policy
+     */
+    template <Arithmetic T>
+    void gemmTransposed(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc, Execution policy = Execution::Parallel)
+    {
+        gemmBlocked<true>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, policy);
+    }
+
+    /**
+     * @brief Size of the diagonal blocks solved by the unblocked triangular kernels
+     */
+    inline constexpr size_t triangularBlockSize = 64;
+
+    /**
+     * @brief Solve L * X = B in place for a unit lower triangular L
+     *
+     * L is the strictly lower part of an m x m column-major matrix with an
+     * implicit unit diagonal, B is m x n and is overwritten by X. Diagonal
+     * blocks are solved with axpy updates on contiguous columns of L and the
+     * rows below each block are updated with GEMM.
+     *
+     * @param m Order of L and number of rows of B
+     * @param n Number of columns of B
+     * @param a Pointer to L
+     * @param lda Leading dimension of L
+     * @param b Pointer to B
+     * @param ldb Leading dimension of B
+     * @param policy Execution policy of the GEMM updates
+     */
+    template <Arithmetic T>
+    void trsmLowerUnit(size_t m, size_t n, const T *a, size_t lda, T *b, size_t ldb, Execution policy = Execution::Parallel)
+    {
+        for (size_t k0 = 0; k0 < m; k0 += triangularBlockSize)
+        {
+            size_t kb = std::min(triangularBlockSize, m - k0);
+            for (size_t c = 0; c < n; c++)
+            {
+                T *column = b + c * ldb;
+                for (size_t j = k0; j + 1 < k0 + kb; j++)
+                    simd::axpy(-column[j], a + j * lda + j + 1, column + j + 1, k0 + kb - j - 1);
+            }
+            size_t rest = m - k0 - kb;
+            if (rest > 0)
+                gemm(rest, n, kb, T(-1), a + k0 * lda + k0 + kb, lda, b + k0, ldb, T(1), b + k0 + kb, ldb, policy);
+        }
+    }
+
+    /**
+     * @brief Solve L * X = B in place for a lower triangular L
+     *
+     * Same as trsmLowerUnit, but the diagonal of L is read and divided by.
+     *
+     * @param m Order of L and number of rows of B
+     * @param n Number of columns of B
+     * @param a Pointer to L
+     * @param lda Leading dimension of L
+     * @param b Pointer to B
+     * @param ldb Leading dimension of B
+     * @param policy Execution policy of the GEMM updates
+     */
+    template <Arithmetic T>
+    void trsmLower(size_t m, size_t n, const T *a, size_t lda, T *b, size_t ldb, Execution policy = Execution::Parallel)
+    {
+        for (size_t k0 = 0; k0 < m; k0 += triangularBlockSize)
+        {
+            size_t kb = std::min(triangularBlockSize, m - k0);
+            for (size_t c = 0; c < n; c++)
+            {
+                T *column = b + c * ldb;
+                for (size_t j = k0; j < k0 + kb; j++)
+                {
+                    column[j] /= a[j * lda + j];
+                    simd::axpy(-column[j], a + j * lda + j + 1, column + j + 1, k0 + kb - j - 1);
+                }
+            }
+            size_t rest = m - k0 - kb;
+            if (rest > 0)
+                gemm(rest, n, kb, T(-1), a + k0 * lda + k0 + kb, lda, b + k0, ldb, T(1), b + k0 + kb, ldb, policy);
+        }
+    }
+
+    /**
+     * @brief Solve U * X = B in place for an upper triangular U
+     *
+     * U is the upper part (diagonal included) of an m x m column-major
+     * matrix, B is m x n and is overwritten by X. Blocks are processed from
+     * the bottom up, the rows above each block are updated with GEMM.
+     *
+     * @param m Order of U and number of rows of B
+     * @param n Number of columns of B
+     * @param a Pointer to U
+     * @param lda Leading dimension of U
+     * @param b Pointer to B
+     * @param ldb Leading dimension of B
+     * @param policy Execution policy of the GEMM updates
+     */
+    template <Arithmetic T>
+    void trsmUpper(size_t m, size_t n, const T *a, size_t lda, T *b, size_t ldb, Execution policy = Execution::Parallel)
+    {
+        size_t end = m;
+        while (end > 0)
+        {
+            size_t kb = (end - 1) % triangularBlockSize + 1;
+            size_t k0 = end - kb;
+            for (size_t c = 0; c < n; c++)
+            {
+                T *column = b + c * ldb;
+                for (size_t j = end; j-- > k0;)
+                {
+                    column[j] /= a[j * lda + j];
+                    simd::axpy(-column[j], a + j * lda + k0, column + k0, j - k0);
+                }
+            }
+            if (k0 > 0)
+                gemm(k0, n, kb, T(-1), a + k0 * lda, lda, b + k0, ldb, T(1), b, ldb, policy);
+            end = k0;
+        }
+    }
+
+    /**
+     * @brief Largest block transposed element by element
+     *
+     * A tile's worth of columns of the source and rows of the destination
+     * stay in L1 while the tile is transposed.
+     */
+    template <Arithmetic T>
+    inline constexpr size_t transposeTile = 256 / sizeof(T);
+
+    /**
+     * @brief Out-of-place transpose B = A^T
+     *
+     * Cache-oblivious: the longer dimension is halved recursively until the
+     * block is a tile, so at every level of the memory hierarchy the blocks
+     * being read and written fit without tuning for cache or TLB sizes.
+     * Split points are kept on tile boundaries so that only the borders of
+     * the matrix produce partial tiles.
+     *
+     * @param m Number of rows of A and columns of B
+     * @param n Number of columns of A and rows of B
+     * @param a Pointer to A
+     * @param lda Leading dimension of A
+     * @param b Pointer to B, must not overlap A
+     * @param ldb Leading dimension of B
+     */
+    template <Arithmetic T>
+    void transposeRecursive(size_t m, size_t n, const T *a, size_t lda, T *b, size_t ldb)
+    {
+        constexpr size_t Tile = transposeTile<T>;
+        while (m > Tile || n > Tile)
+        {
+            if (m >= n)
+            {
+                size_t half = m / 2 / Tile * Tile;
+                half = half == 0 ? m / 2 : half;
+                transposeRecursive(half, n, a, lda, b, ldb);
+                a += half;
+                b += half * ldb;
+                m -= half;
+            }
+            else
+            {
+                size_t half = n / 2 / Tile * Tile;
+                half = half == 0 ? n / 2 : half;
+                transposeRecursive(m, half, a, lda, b, ldb);
+                a += half * lda;
+                b += half;
+                n -= half;
+            }
+        }
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < m; i++)
+                b[i * ldb + j] = a[j * lda + i];
+    }
+
+    /**
+     * @brief Out-of-place transpose B = A^T on the shared thread pool
+     *
+     * Panels of columns of A are independent, each one is transposed by
+     * transposeRecursive in its own task.
+     *
+     * @param m Number of rows of A and columns of B
+     * @param n Number of columns of A and rows of B
+     * @param a Pointer to A
+     * @param lda Leading dimension of A
+     * @param b Pointer to B, must not overlap A
+     * @param ldb Leading dimension of B
+     * @param policy Execution policy
+     */
+    template <Arithmetic T>
+    void transpose(size_t m, size_t n, const T *a, size_t lda, T *b, size_t ldb, Execution policy = Execution::Parallel)
+    {
+        constexpr size_t Tile = transposeTile<T>;
+        size_t grain = (parallel::grainSize / std::max<size_t>(m, 1) + Tile - 1) / Tile * Tile;
+        parallel::forRange(policy, n, std::max(grain, Tile), [&](size_t begin, size_t end)
+                           { transposeRecursive(m, end - begin, a + begin * lda, lda, b + begin, ldb); });
+    }
+
+    /**
+     * @brief Exchange an m x n block A with the transpose of an n x m block B
+     *
+     * The blocks must not overlap. Split recursively like transpose.
+     *
+     * @param m Number of rows of A and columns of B
+     * @param n Number of columns of A and rows of B
+     * @param a Pointer to A
+     * @param b Pointer to B
+     * @param ld Leading dimension of both blocks
+     */
+    template <Arithmetic T>
+    void swapTransposed(size_t m, size_t n, T *a, T *b, size_t ld)
+    {
+        constexpr size_t Tile = transposeTile<T>;
+        while (m > Tile || n > Tile)
+        {
+            if (m >= n)
+            {
+                size_t half = m / 2;
+                swapTransposed(half, n, a, b, ld);
+                a += half;
+                b += half * ld;
+                m -= half;
+            }
+            else
+            {
+                size_t half = n / 2;
+                swapTransposed(m, half, a, b, ld);
+                a += half * ld;
+                b += half;
+                n -= half;
+            }
+        }
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < m; i++)
+                std::swap(a[j * ld + i], b[i * ld + j]);
+    }
+
+    /**
+     * @brief Transpose an n x n matrix in place
+     *
+     * The diagonal blocks are transposed recursively and the off-diagonal
+     * blocks are exchanged with swapTransposed, no extra memory is used.
+     *
+     * @param n Order of the matrix
+     * @param a Pointer to the matrix
+     * @param lda Leading dimension of the matrix
+     */
+    template <Arithmetic T>
+    void transposeSquare(size_t n, T *a, size_t lda)
+    {
+        if (n <= transposeTile<T>)
+        {
+            for (size_t j = 1; j < n; j++)
+                for (size_t i = 0; i < j; i++)
+                    std::swap(a[j * lda + i], a[i * lda + j]);
+            return;
+        }
+        size_t half = n / 2;
+        transposeSquare(half, a, lda);
+        transposeSquare(n - half, a + half * lda + half, lda);
+        // A21 (rows half.., columns ..half) with A12 (rows ..half, columns half..)
+        swapTransposed(n - half, half, a + half, a + half * lda, lda);
+    }
+
+    /**
+     * @brief Transpose a contiguous m x n column-major matrix in place into n x m
+     *
+     * Follows the cycles of the permutation p -> p * m mod (m * n - 1), the
+     * inverse of the move of element p = j * m + i to i * n + j. Only one bit
+     * per element is allocated to mark visited positions.
+     *
+     * @param m Number of rows before the transpose
+     * @param n Number of columns before the transpose
+     * @param a Pointer to the matrix data
+     */
+    template <Arithmetic T>
+    void transposeCycles(size_t m, size_t n, T *a)
+    {
+        size_t size = m * n;
+        if (m <= 1 || n <= 1)
+            return;
+        std::vector<bool> visited(size);
+        size_t last = size - 1;
+        for (size_t start = 1; start < last; start++)
+        {
+            if (visited[start])
+                continue;
+            // position q of the result holds the element at source q * m mod last
+            size_t q = start;
+            T first = a[q];
+            while (true)
+            {
+                visited[q] = true;
+                size_t source = q * m % last;
+                if (source == start)
+                {
+                    a[q] = first;
+                    break;
+                }
+                a[q] = a[source];
+                q = source;
+            }
+        }
+    }
+
+}
+
+#endif
@@ -1,7 +1,15 @@
 #ifndef M42_FUNCTIONS_HPP
 #define M42_FUNCTIONS_HPP
 
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+
+#include "simd.hpp"
+#include "ThreadPool.hpp"
 #include "Vector.hpp"
+#include "FixedVector.hpp"
+#include "FixedMatrix.hpp"
 
 namespace m42
 {
@@ -12,10 +20,12 @@ namespace m42
      * @tparam T Type of the vector components
      * @param vectors std::vector of vectors
      * @param coefficients std::vector of coefficients
+     * @param policy Execution policy, chunks of elements are independent
      * @return Vector<T> Linear combination of vectors
      */
     template <Arithmetic T>
-    Vector<T> linearCombination(const std::vector<Vector<T>> &vectors, const std::vector<T> &coefficients)
+    Vector<T> linearCombination(const std::vector<Vector<T>> &vectors, const std::vector<T> &coefficients,
+                                Execution policy = Execution::Parallel)
     {
         if (vectors.size() != coefficients.size())
             throw std::invalid_argument("Vectors and coefficients collections must be of the same size");
@@ -27,14 +37,17 @@ namespace m42
         }
 
         Vector<T> result(vector_size);
-        // using std::fma
-        for (size_t i = 0; i < vector_size; i++)
-        {
-            T sum = 0;
-            for (size_t j = 0; j < vectors.size(); j++)
-                sum = std::fma(vectors[j][i], coefficients[j], sum);
-            result[i] = sum;
-        }
+        size_t grain = parallel::grainSize / std::max<size_t>(vectors.size(), 1);
+        parallel::forRange(policy, vector_size, std::max<size_t>(grain, 1), [&](size_t begin, size_t end)
+                           {
+                               // using std::fma
+                               for (size_t i = begin; i < end; i++)
+                               {
+                                   T sum = 0;
+                                   for (size_t j = 0; j < vectors.size(); j++)
+                                       sum = std::fma(vectors[j][i], coefficients[j], sum);
+                                   result[i] = sum;
+                               } });
 
         return result;
     }
@@ -45,12 +58,14 @@ namespace m42
      * @tparam T Type of the vector components
      * @param vectors Initializer list of vectors
      * @param coefficients Initializer list of coefficients
+     * @param policy Execution policy
      * @return Vector<T> Linear combination of vectors
      */
     template <Arithmetic T>
-    Vector<T> linearCombination(std::initializer_list<Vector<T>> vectors, std::initializer_list<T> coefficients)
+    Vector<T> linearCombination(std::initializer_list<Vector<T>> vectors, std::initializer_list<T> coefficients,
+                                Execution policy = Execution::Parallel)
     {
-        return linearCombination(std::vector<Vector<T>>(vectors), std::vector<T>(coefficients));
+        return linearCombination(std::vector<Vector<T>>(vectors), std::vector<T>(coefficients), policy);
     }
 
     /**
@@ -103,23 +118,116 @@ namespace m42
     }
 
     /**
-     * @brief Computes a perspective projection matrix
+     * @brief Computes cross product of two fixed-size 3-dimensional vectors
+     * 
+     * @tparam T Type of the vector components
+     * @param u First vector
+     * @param v Second vector
+     * @return FixedVector<T, 3> Cross product of the vectors
+     */
+    template <Arithmetic T>
+    constexpr FixedVector<T, 3> crossProduct(const FixedVector<T, 3> &u, const FixedVector<T, 3> &v)
+    {
+        return FixedVector<T, 3>{
+            u[1] * v[2] - u[2] * v[1],
+            u[2] * v[0] - u[0] * v[2],
+            u[0] * v[1] - u[1] * v[0],
+        };
+    }
+
+    /**
+     * @brief Computes a perspective projection matrix without allocating
      * 
      * @param fov Field of view
      * @param aspect Aspect ratio
      * @param near Near clipping plane
      * @param far Far clipping plane
-     * @return Matrix<float> Perspective projection matrix
+     * @return FixedMatrix<float, 4, 4> Perspective projection matrix
      */
-    Matrix<float> makeProjectionMatrix(float fov, float aspect, float near, float far)
+    inline FixedMatrix<float, 4, 4> makeFixedProjectionMatrix(float fov, float aspect, float near, float far)
     {
         float f = 1.0f / std::tan(fov / 2.0f);
-        return Matrix<float>{
+        return FixedMatrix<float, 4, 4>({
             {f / aspect, 0.0f,  0.0f,                        0.0f                              },
             {0.0f,       f,     0.0f,                        0.0f                              },
             {0.0f,       0.0f,  (far + near) / (near - far), (2.0f * far * near) / (near - far)},
             {0.0f,       0.0f, -1.0f,                        0.0f                              },
-        };
+        });
+    }
+
+    /**
+     * @brief Computes a perspective projection matrix
+     * 
+     * @param fov Field of view
+     * @param aspect Aspect ratio
+     * @param near Near clipping plane
+     * @param far Far clipping plane
+     * @return Matrix<float> Perspective projection matrix
+     */
+    inline Matrix<float> makeProjectionMatrix(float fov, float aspect, float near, float far)
+    {
+        return Matrix<float>(makeFixedProjectionMatrix(fov, aspect, near, far).view());
+    }
+
+    /**
+     * @brief Transforms points stored as separate coordinate arrays by a 4x4 matrix
+     * 
+     * SIMD runs across points, one lane per point, and nothing is allocated.
+     * Outputs may be the input arrays to transform in place.
+     * 
+     * @tparam T Type of the coordinates
+     * @param matrix Transform, e.g. from makeFixedProjectionMatrix()
+     * @param x, y, z Input coordinates of n points
+     * @param w Input w coordinates, nullptr for points with w = 1
+     * @param outX, outY, outZ Output coordinates of n points
+     * @param outW Output w coordinates before the divide, nullptr to drop them
+     * @param n Number of points
+     * @param perspectiveDivide Whether to divide x, y and z by the transformed w
+     */
+    template <std::floating_point T>
+    void transformPoints(const FixedMatrix<T, 4, 4> &matrix,
+                         const T *x, const T *y, const T *z, const std::type_identity_t<T> *w,
+                         T *outX, T *outY, T *outZ, std::type_identity_t<T> *outW,
+                         size_t n, bool perspectiveDivide = false)
+    {
+        simd::transform4(matrix.data(), x, y, z, w, outX, outY, outZ, outW, n, perspectiveDivide);
+    }
+
+    /**
+     * @brief Transforms interleaved xyzw points by a 4x4 matrix
+     * 
+     * Points are deinterleaved in tiles on the stack, transformed with the
+     * structure-of-arrays kernel and interleaved again, so the output may
+     * be the input buffer.
+     * 
+     * @tparam T Type of the coordinates
+     * @param matrix Transform, e.g. from makeFixedProjectionMatrix()
+     * @param points n points as x, y, z, w quadruples
+     * @param result Output buffer of n quadruples
+     * @param n Number of points
+     * @param perspectiveDivide Whether to divide x, y and z by the transformed w
+     */
+    template <std::floating_point T>
+    void transformPoints(const FixedMatrix<T, 4, 4> &matrix, const T *points, T *result,
+                         size_t n, bool perspectiveDivide = false)
+    {
+        // four coordinate arrays of one tile stay well within L1
+        constexpr size_t tile = 256;
+        T soa[4][tile];
+        for (size_t p0 = 0; p0 < n; p0 += tile)
+        {
+            size_t count = std::min(tile, n - p0);
+            const T *in = points + p0 * 4;
+            for (size_t c = 0; c < 4; c++)
+                for (size_t i = 0; i < count; i++)
+                    soa[c][i] = in[i * 4 + c];
+            simd::transform4(matrix.data(), soa[0], soa[1], soa[2], soa[3],
+                             soa[0], soa[1], soa[2], soa[3], count, perspectiveDivide);
+            T *out = result + p0 * 4;
+            for (size_t c = 0; c < 4; c++)
+                for (size_t i = 0; i < count; i++)
+                    out[i * 4 + c] = soa[c][i];
+        }
     }
 
 }
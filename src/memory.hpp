@@ -0,0 +1,455 @@
+#ifndef M42_MEMORY_HPP
+#define M42_MEMORY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "common.hpp"
+
+namespace m42
+{
+
+    /**
+     * @brief Alignment of the default storage, one cache line and one AVX-512 register
+     */
+    inline constexpr size_t storageAlignment = 64;
+
+    /**
+     * @brief Allocator returning storage aligned on a fixed boundary
+     *
+     * @tparam T Type of elements
+     * @tparam Alignment Alignment in bytes, a power of two
+     */
+    template <typename T, size_t Alignment = storageAlignment>
+    class AlignedAllocator
+    {
+        static_assert((Alignment & (Alignment - 1)) == 0 && Alignment >= alignof(T),
+                      "Alignment must be a power of two at least alignof(T)");
+
+    public:
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        AlignedAllocator() noexcept = default;
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+        T *allocate(size_t n);
+        void deallocate(T *p, size_t n) noexcept;
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept { return true; }
+    };
+
+    /**
+     * @brief Allocate storage for n elements
+     *
+     * @param n Number of elements
+     * @return T* Pointer aligned on Alignment bytes
+     */
+    template <typename T, size_t Alignment>
+    T *AlignedAllocator<T, Alignment>::allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    /**
+     * @brief Release storage returned by allocate
+     *
+     * @param p Pointer returned by allocate
+     */
+    template <typename T, size_t Alignment>
+    void AlignedAllocator<T, Alignment>::deallocate(T *p, size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    /**
+     * @brief Layout of the columns of a Matrix
+     *
+     * None stores the columns back to back. Aligned pads every column to a
+     * multiple of storageAlignment bytes so that each one starts on an
+     * aligned boundary, at the price of a leading dimension larger than the
+     * height.
+     */
+    enum class Padding
+    {
+        None,
+        Aligned
+    };
+
+    /**
+     * @brief Leading dimension of a column of height elements padded to storageAlignment
+     *
+     * @param height Number of elements in a column
+     * @return size_t height rounded up to a multiple of storageAlignment / sizeof(T)
+     */
+    template <Arithmetic T>
+    constexpr size_t alignedStride(size_t height)
+    {
+        constexpr size_t lanes = storageAlignment / sizeof(T) > 0 ? storageAlignment / sizeof(T) : 1;
+        return (height + lanes - 1) / lanes * lanes;
+    }
+
+    template <Arithmetic T>
+    class VectorView;
+
+    template <Arithmetic T, typename Allocator = AlignedAllocator<T>>
+    class Vector;
+
+    template <Arithmetic T, typename Allocator = AlignedAllocator<T>>
+    class Matrix;
+
+    /**
+     * @brief Bump allocator for short-lived temporaries released in bulk
+     *
+     * Memory is carved out of a list of blocks by advancing an offset, a
+     * mark() records the offset and rewind() returns everything allocated
+     * after it at once. Blocks are kept, so once the arena has grown to the
+     * working set of a loop its iterations no longer allocate. When the
+     * arena is rewound to empty while spread over several blocks, they are
+     * merged into one block of the total size.
+     */
+    class Arena
+    {
+    private:
+        struct Block
+        {
+            unsigned char *data;
+            size_t size;
+        };
+
+        std::vector<Block> _blocks;
+        size_t _block;
+        size_t _offset;
+
+        void addBlock(size_t size);
+
+    public:
+        /**
+         * @brief Position in the arena returned by mark()
+         */
+        struct Mark
+        {
+            size_t block;
+            size_t offset;
+        };
+
+        /**
+         * @brief Size of the first block
+         */
+        static constexpr size_t initialSize = size_t(1) << 16;
+
+        Arena();
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+        ~Arena();
+
+        void *allocate(size_t bytes, size_t alignment = storageAlignment);
+        Mark mark() const;
+        void rewind(Mark mark);
+        size_t capacity() const;
+        size_t blocks() const;
+    };
+
+    /**
+     * @brief Construct an empty arena, the first block is allocated on first use
+     */
+    inline Arena::Arena() : _block(0), _offset(0) {}
+
+    /**
+     * @brief Release every block
+     */
+    inline Arena::~Arena()
+    {
+        for (Block &block : _blocks)
+            ::operator delete(block.data, std::align_val_t(storageAlignment));
+    }
+
+    /**
+     * @brief Append a block of size bytes
+     */
+    inline void Arena::addBlock(size_t size)
+    {
+        auto *data = static_cast<unsigned char *>(::operator new(size, std::align_val_t(storageAlignment)));
+        _blocks.push_back({data, size});
+    }
+
+    /**
+     * @brief Allocate bytes bytes, valid until the arena is rewound past them
+     *
+     * @param bytes Size of the allocation
+     * @param alignment Alignment of the allocation, a power of two up to storageAlignment
+     * @return void* Start of the allocation
+     */
+    inline void *Arena::allocate(size_t bytes, size_t alignment)
+    {
+        if (alignment > storageAlignment || (alignment & (alignment - 1)) != 0)
+            throw std::invalid_argument("Alignment must be a power of two up to storageAlignment");
+        while (_block < _blocks.size())
+        {
+            size_t start = (_offset + alignment - 1) & ~(alignment - 1);
+            if (start <= _blocks[_block].size && bytes <= _blocks[_block].size - start)
+            {
+                _offset = start + bytes;
+                return _blocks[_block].data + start;
+            }
+            _block++;
+            _offset = 0;
+        }
+        size_t size = std::max(bytes, _blocks.empty() ? initialSize : 2 * _blocks.back().size);
+        addBlock(size);
+        _block = _blocks.size() - 1;
+        _offset = bytes;
+        return _blocks.back().data;
+    }
+
+    /**
+     * @brief Get the current position in the arena
+     *
+     * @return Mark Position to pass to rewind()
+     */
+    inline Arena::Mark Arena::mark() const
+    {
+        return {_block, _offset};
+    }
+
+    /**
+     * @brief Release everything allocated since mark was taken
+     *
+     * @param mark Position returned by mark()
+     */
+    inline void Arena::rewind(Mark mark)
+    {
+        _block = mark.block;
+        _offset = mark.offset;
+        if (_block == 0 && _offset == 0 && _blocks.size() > 1)
+        {
+            size_t total = capacity();
+            for (Block &block : _blocks)
+                ::operator delete(block.data, std::align_val_t(storageAlignment));
+            _blocks.clear();
+            addBlock(total);
+        }
+    }
+
+    /**
+     * @brief Get the number of bytes held by the arena
+     *
+     * @return size_t Total size of the blocks
+     */
+    inline size_t Arena::capacity() const
+    {
+        size_t total = 0;
+        for (const Block &block : _blocks)
+            total += block.size;
+        return total;
+    }
+
+    /**
+     * @brief Get the number of blocks held by the arena
+     *
+     * @return size_t Number of blocks
+     */
+    inline size_t Arena::blocks() const
+    {
+        return _blocks.size();
+    }
+
+    namespace scratch
+    {
+
+        /**
+         * @brief Get the scratch arena of the calling thread
+         *
+         * @return Arena& Arena shared by every ScratchScope of the thread
+         */
+        inline Arena &arena()
+        {
+            thread_local Arena instance;
+            return instance;
+        }
+
+        /**
+         * @brief Get the number of ScratchScope open on the calling thread
+         *
+         * @return size_t& Nesting depth, maintained by ScratchScope
+         */
+        inline size_t &depth()
+        {
+            thread_local size_t instance = 0;
+            return instance;
+        }
+
+    }
+
+    /**
+     * @brief Scope releasing the scratch allocations made on this thread during its lifetime
+     *
+     * Objects built with ScratchAllocator must not outlive the innermost
+     * scope that was open when they were allocated, and can only be built
+     * while a scope is open.
+     */
+    class ScratchScope
+    {
+    private:
+        Arena &_arena;
+        Arena::Mark _mark;
+
+    public:
+        ScratchScope();
+        ScratchScope(const ScratchScope &) = delete;
+        ScratchScope &operator=(const ScratchScope &) = delete;
+        ~ScratchScope();
+    };
+
+    /**
+     * @brief Open a scope on the scratch arena of the calling thread
+     */
+    inline ScratchScope::ScratchScope() : _arena(scratch::arena()), _mark(_arena.mark())
+    {
+        scratch::depth()++;
+    }
+
+    /**
+     * @brief Rewind the arena to where it was when the scope was opened
+     */
+    inline ScratchScope::~ScratchScope()
+    {
+        _arena.rewind(_mark);
+        scratch::depth()--;
+    }
+
+    /**
+     * @brief Allocator drawing from the scratch arena of the calling thread
+     *
+     * deallocate() does nothing, the storage is returned when the enclosing
+     * ScratchScope ends. Without an open scope nothing would ever return it,
+     * so allocate() refuses to run outside of one.
+     *
+     * @tparam T Type of elements
+     */
+    template <typename T>
+    class ScratchAllocator
+    {
+        static_assert(alignof(T) <= storageAlignment, "Elements must fit the storage alignment");
+
+    public:
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = ScratchAllocator<U>;
+        };
+
+        ScratchAllocator() noexcept = default;
+        template <typename U>
+        ScratchAllocator(const ScratchAllocator<U> &) noexcept {}
+
+        T *allocate(size_t n);
+        void deallocate(T *p, size_t n) noexcept;
+
+        template <typename U>
+        bool operator==(const ScratchAllocator<U> &) const noexcept { return true; }
+    };
+
+    /**
+     * @brief Allocate storage for n elements from the scratch arena of the calling thread
+     *
+     * @param n Number of elements
+     * @return T* Pointer aligned on storageAlignment bytes
+     */
+    template <typename T>
+    T *ScratchAllocator<T>::allocate(size_t n)
+    {
+        if (scratch::depth() == 0)
+            throw std::logic_error("Scratch allocations need an open ScratchScope");
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T *>(scratch::arena().allocate(n * sizeof(T)));
+    }
+
+    /**
+     * @brief Do nothing, the storage is released with the enclosing ScratchScope
+     */
+    template <typename T>
+    void ScratchAllocator<T>::deallocate(T *, size_t) noexcept {}
+
+    template <Arithmetic T>
+    using ScratchVector = Vector<T, ScratchAllocator<T>>;
+
+    template <Arithmetic T>
+    using ScratchMatrix = Matrix<T, ScratchAllocator<T>>;
+
+    namespace scratch
+    {
+
+        /**
+         * @brief Tell whether two views may share storage
+         *
+         * Compares the address ranges the views span, so interleaved views
+         * of the same storage count as overlapping.
+         *
+         * @return true if an element written through b could be read through a
+         */
+        template <Arithmetic T>
+        bool overlaps(const VectorView<T> &a, const VectorView<T> &b)
+        {
+            if (a.size() == 0 || b.size() == 0)
+                return false;
+            const T *aEnd = a.data() + (a.size() - 1) * a.stride() + 1;
+            const T *bEnd = b.data() + (b.size() - 1) * b.stride() + 1;
+            return std::less<const T *>()(a.data(), bEnd) && std::less<const T *>()(b.data(), aEnd);
+        }
+
+        /**
+         * @brief Run a matrix-vector kernel that needs unit-stride operands on views of any stride
+         *
+         * A strided x is gathered into a scratch vector, a strided y is
+         * computed in one and copied back. Gathering is O(n) next to the
+         * product itself. The kernel writes y while it still reads x, so
+         * when the two overlap y is also computed in scratch storage.
+         *
+         * @param x Operand, read only
+         * @param y Result, overwritten
+         * @param kernel Callable taking (const T *x, T *y) on contiguous storage
+         */
+        template <Arithmetic T, typename Kernel>
+        void contiguousProduct(const VectorView<T> &x, VectorView<T> &y, Kernel kernel)
+        {
+            bool aliased = overlaps(x, y);
+            if (x.isContiguous() && y.isContiguous() && !aliased)
+            {
+                kernel(x.data(), y.data());
+                return;
+            }
+            ScratchScope scope;
+            if (!x.isContiguous())
+            {
+                ScratchVector<T> gathered(x);
+                contiguousProduct<T>(gathered, y, kernel);
+                return;
+            }
+            ScratchVector<T> result(y.size());
+            kernel(x.data(), result.data());
+            y = result;
+        }
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,353 @@
+#ifndef M42_NUMA_HPP
+#define M42_NUMA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "memory.hpp"
+#include "ThreadPool.hpp"
+
+namespace m42
+{
+
+    /**
+     * @brief Placement of the pages of a large allocation across NUMA nodes
+     *
+     * FirstTouch leaves every page on the node of the thread that touches
+     * it first. The storage is zeroed in parallel with the chunking of the
+     * element-wise kernels, which spreads it over the nodes the pool runs
+     * on; the pool steals work and its threads are not pinned, so which
+     * node a chunk lands on is best effort and need not match the thread
+     * that later works on it. Interleaved spreads the pages round-robin
+     * over all nodes, which suits data read by every thread, such as the
+     * operands of a product.
+     */
+    enum class Placement
+    {
+        FirstTouch,
+        Interleaved
+    };
+
+    /**
+     * @brief Page size backing a large allocation
+     *
+     * Transparent asks the kernel to back the mapping with huge pages when
+     * it can, Explicit maps reserved huge pages (hugetlbfs) and falls back
+     * to Transparent when none are available.
+     */
+    enum class HugePages
+    {
+        None,
+        Transparent,
+        Explicit
+    };
+
+    namespace numa
+    {
+
+        /**
+         * @brief Size of a huge page, the 2 MiB of x86-64 and most AArch64 kernels
+         */
+        inline constexpr size_t hugePageSize = size_t(2) << 20;
+
+        /**
+         * @brief Allocations smaller than this come from the aligned heap instead of their own mapping
+         */
+        inline constexpr size_t mappingThreshold = size_t(1) << 20;
+
+        /**
+         * @brief Parse a kernel node list such as "0-3,6" into a bit mask
+         *
+         * @param list Comma-separated node numbers and ranges
+         * @return unsigned long Mask with bit i set for node i, nodes past the width of the mask are ignored
+         */
+        inline unsigned long parseNodeList(const std::string &list)
+        {
+            constexpr size_t bits = std::numeric_limits<unsigned long>::digits;
+            unsigned long mask = 0;
+            size_t position = 0;
+            while (position < list.size())
+            {
+                size_t end = list.find(',', position);
+                if (end == std::string::npos)
+                    end = list.size();
+                std::string item = list.substr(position, end - position);
+                size_t dash = item.find('-');
+                try
+                {
+                    size_t first = std::stoul(item.substr(0, dash));
+                    size_t last = dash == std::string::npos ? first : std::stoul(item.substr(dash + 1));
+                    for (size_t node = first; node <= last && node < bits; node++)
+                        mask |= 1ul << node;
+                }
+                catch (const std::exception &)
+                {
+                    // blank or malformed items, such as the trailing newline, are skipped
+                }
+                position = end + 1;
+            }
+            return mask;
+        }
+
+        /**
+         * @brief Get the NUMA nodes that are online
+         *
+         * @return unsigned long Mask of the online nodes, node 0 alone when the system does not report them
+         */
+        inline unsigned long onlineNodes()
+        {
+            std::ifstream file("/sys/devices/system/node/online");
+            std::string list;
+            std::getline(file, list);
+            unsigned long mask = parseNodeList(list);
+            return mask == 0 ? 1ul : mask;
+        }
+
+        /**
+         * @brief Get the length of the mapping backing bytes bytes
+         *
+         * @param bytes Requested size
+         * @param pages Page size policy
+         * @return size_t bytes rounded up to a whole number of pages
+         */
+        inline size_t mappedLength(size_t bytes, HugePages pages)
+        {
+            size_t granule = pages == HugePages::None ? 4096 : hugePageSize;
+            return (bytes + granule - 1) / granule * granule;
+        }
+
+        /**
+         * @brief Map length bytes of anonymous memory
+         *
+         * Transparent huge pages need the mapping to start on a huge page
+         * boundary, so a larger region is reserved and trimmed to it.
+         *
+         * @param length Length of the mapping, a multiple of the page size
+         * @param pages Page size policy
+         * @return void* Start of the mapping, nullptr when the system has no memory left
+         */
+        inline void *map(size_t length, HugePages pages)
+        {
+#if defined(__linux__)
+            constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+            if (pages == HugePages::Explicit)
+            {
+                void *p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+                if (p != MAP_FAILED)
+                    return p;
+            }
+            if (pages == HugePages::None)
+            {
+                void *p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+                return p == MAP_FAILED ? nullptr : p;
+            }
+            void *raw = ::mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (raw == MAP_FAILED)
+                return nullptr;
+            auto begin = reinterpret_cast<std::uintptr_t>(raw);
+            std::uintptr_t start = (begin + hugePageSize - 1) / hugePageSize * hugePageSize;
+            if (start != begin)
+                ::munmap(raw, start - begin);
+            ::munmap(reinterpret_cast<void *>(start + length), begin + hugePageSize - start);
+            void *p = reinterpret_cast<void *>(start);
+#ifdef MADV_HUGEPAGE
+            ::madvise(p, length, MADV_HUGEPAGE);
+#endif
+            return p;
+#else
+            (void)pages;
+            return ::operator new(length, std::align_val_t(storageAlignment), std::nothrow);
+#endif
+        }
+
+        /**
+         * @brief Release a mapping returned by map
+         */
+        inline void unmap(void *p, size_t length)
+        {
+#if defined(__linux__)
+            ::munmap(p, length);
+#else
+            (void)length;
+            ::operator delete(p, std::align_val_t(storageAlignment));
+#endif
+        }
+
+        /**
+         * @brief Spread the pages of a mapping round-robin over the online nodes
+         *
+         * Placement is a hint: kernels without NUMA support, or without the
+         * permission to set a policy, keep the default placement.
+         *
+         * @param p Start of the mapping
+         * @param length Length of the mapping
+         */
+        inline void interleave(void *p, size_t length)
+        {
+#if defined(__linux__) && defined(SYS_mbind)
+            // MPOL_INTERLEAVE from <linux/mempolicy.h>
+            constexpr int interleavePolicy = 3;
+            unsigned long nodes = onlineNodes();
+            ::syscall(SYS_mbind, p, length, interleavePolicy, &nodes, std::numeric_limits<unsigned long>::digits + 1, 0);
+#else
+            (void)p;
+            (void)length;
+#endif
+        }
+
+    }
+
+    /**
+     * @brief Allocator for matrices large enough to span NUMA nodes
+     *
+     * Allocations of at least numa::mappingThreshold bytes get their own
+     * anonymous mapping with the requested page size and placement, and are
+     * zeroed by the threads of the shared pool in the chunks
+     * parallel::forRange gives the element-wise kernels, a best-effort
+     * spread of first touches across nodes. Smaller ones come
+     * from the aligned heap, which is cheaper and already local.
+     *
+     * @tparam T Type of elements
+     */
+    template <typename T>
+    class NumaAllocator
+    {
+        static_assert(alignof(T) <= storageAlignment, "Elements must fit the storage alignment");
+
+    private:
+        Placement _placement;
+        HugePages _pages;
+
+        template <typename U>
+        friend class NumaAllocator;
+
+    public:
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = NumaAllocator<U>;
+        };
+
+        NumaAllocator(Placement placement = Placement::FirstTouch, HugePages pages = HugePages::Transparent) noexcept;
+        template <typename U>
+        NumaAllocator(const NumaAllocator<U> &other) noexcept;
+
+        Placement placement() const;
+        HugePages pages() const;
+        T *allocate(size_t n);
+        void deallocate(T *p, size_t n) noexcept;
+
+        template <typename U>
+        bool operator==(const NumaAllocator<U> &other) const noexcept;
+    };
+
+    /**
+     * @brief Construct an allocator with the given page placement and size
+     *
+     * @param placement Placement of the pages across nodes
+     * @param pages Page size backing the allocations
+     */
+    template <typename T>
+    NumaAllocator<T>::NumaAllocator(Placement placement, HugePages pages) noexcept : _placement(placement), _pages(pages) {}
+
+    /**
+     * @brief Construct an allocator with the policy of an allocator of another type
+     */
+    template <typename T>
+    template <typename U>
+    NumaAllocator<T>::NumaAllocator(const NumaAllocator<U> &other) noexcept : _placement(other._placement), _pages(other._pages) {}
+
+    /**
+     * @brief Get the placement of the pages across nodes
+     */
+    template <typename T>
+    Placement NumaAllocator<T>::placement() const
+    {
+        return _placement;
+    }
+
+    /**
+     * @brief Get the page size backing the allocations
+     */
+    template <typename T>
+    HugePages NumaAllocator<T>::pages() const
+    {
+        return _pages;
+    }
+
+    /**
+     * @brief Allocate storage for n elements
+     *
+     * Allocations of at least numa::mappingThreshold bytes are mapped and
+     * zeroed by the pool, which is what places their pages. Smaller ones
+     * come uninitialized from AlignedAllocator.
+     *
+     * @param n Number of elements
+     * @return T* Pointer aligned on at least storageAlignment bytes
+     */
+    template <typename T>
+    T *NumaAllocator<T>::allocate(size_t n)
+    {
+        if (n > (std::numeric_limits<size_t>::max() - numa::hugePageSize) / sizeof(T))
+            throw std::bad_array_new_length();
+        size_t bytes = n * sizeof(T);
+        if (bytes < numa::mappingThreshold)
+            return AlignedAllocator<T>().allocate(n);
+
+        size_t length = numa::mappedLength(bytes, _pages);
+        void *p = numa::map(length, _pages);
+        if (!p)
+            throw std::bad_alloc();
+        if (_placement == Placement::Interleaved)
+            numa::interleave(p, length);
+        // the first write decides the node of every page, whichever pool thread runs the chunk
+        auto *bytesOf = static_cast<unsigned char *>(p);
+        parallel::forRange(Execution::Parallel, n, parallel::grainSize, [&](size_t begin, size_t end)
+                           { std::memset(bytesOf + begin * sizeof(T), 0, (end - begin) * sizeof(T)); });
+        return static_cast<T *>(p);
+    }
+
+    /**
+     * @brief Release storage returned by allocate
+     *
+     * @param p Pointer returned by allocate
+     * @param n Number of elements passed to allocate
+     */
+    template <typename T>
+    void NumaAllocator<T>::deallocate(T *p, size_t n) noexcept
+    {
+        size_t bytes = n * sizeof(T);
+        if (bytes < numa::mappingThreshold)
+            AlignedAllocator<T>().deallocate(p, n);
+        else
+            numa::unmap(p, numa::mappedLength(bytes, _pages));
+    }
+
+    /**
+     * @brief Allocators are interchangeable when their mappings have the same page size
+     */
+    template <typename T>
+    template <typename U>
+    bool NumaAllocator<T>::operator==(const NumaAllocator<U> &other) const noexcept
+    {
+        return (_pages == HugePages::None) == (other._pages == HugePages::None);
+    }
+
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef M42_PACKED_HPP
+#define M42_PACKED_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+
+#include "common.hpp"
+#include "simd.hpp"
+
+/**
+ * Kernels on packed triangular storage, the LAPACK "p" formats: the stored
+ * half of an n x n matrix is kept column by column without gaps. In lower
+ * storage column j holds rows j to n - 1, in upper storage rows 0 to j, so
+ * every column is contiguous and the kernels run on whole columns with the
+ * vectorized dot and axpy.
+ */
+namespace m42::packed
+{
+
+    /**
+     * @brief Offset of column j in lower packed storage
+     *
+     * @param n Size of the matrix
+     * @param j Column index
+     * @return size_t Index of element (j, j)
+     */
+    inline size_t lowerOffset(size_t n, size_t j)
+    {
+        return j * (2 * n - j + 1) / 2;
+    }
+
+    /**
+     * @brief Offset of column j in upper packed storage
+     *
+     * @param j Column index
+     * @return size_t Index of element (0, j)
+     */
+    inline size_t upperOffset(size_t j)
+    {
+        return j * (j + 1) / 2;
+    }
+
+    /**
+     * @brief y = A * x, A symmetric with its lower triangle packed
+     *
+     * Column j below the diagonal contributes both to y[j] through a dot
+     * product and to y[j + 1:] through an axpy, so every stored element is
+     * read once.
+     *
+     * @param n Size of the matrix
+     * @param ap Lower packed storage, n * (n + 1) / 2 elements
+     * @param x Dense vector of n elements
+     * @param y Dense vector of n elements, overwritten
+     */
+    template <Arithmetic T>
+    void spmv(size_t n, const T *ap, const T *x, T *y)
+    {
+        std::fill(y, y + n, T(0));
+        for (size_t j = 0; j < n; j++)
+        {
+            const T *column = ap + lowerOffset(n, j);
+            size_t below = n - j - 1;
+            y[j] += column[0] * x[j] + simd::dot(column + 1, x + j + 1, below);
+            simd::axpy(x[j], column + 1, y + j + 1, below);
+        }
+    }
+
+    /**
+     * @brief A = A + alpha * x * x^T, A symmetric with its lower triangle packed
+     *
+     * @param n Size of the matrix
+     * @param alpha Scale of the update
+     * @param x Dense vector of n elements
+     * @param ap Lower packed storage, updated
+     */
+    template <Arithmetic T>
+    void spr(size_t n, T alpha, const T *x, T *ap)
+    {
+        for (size_t j = 0; j < n; j++)
+            simd::axpy(alpha * x[j], x + j, ap + lowerOffset(n, j), n - j);
+    }
+
+    /**
+     * @brief y = A * x, A triangular and packed
+     *
+     * @param n Size of the matrix
+     * @param lower Whether A is lower or upper triangular
+     * @param ap Packed storage, n * (n + 1) / 2 elements
+     * @param x Dense vector of n elements
+     * @param y Dense vector of n elements, overwritten
+     */
+    template <Arithmetic T>
+    void tpmv(size_t n, bool lower, const T *ap, const T *x, T *y)
+    {
+        std::fill(y, y + n, T(0));
+        for (size_t j = 0; j < n; j++)
+            if (lower)
+                simd::axpy(x[j], ap + lowerOffset(n, j), y + j, n - j);
+            else
+                simd::axpy(x[j], ap + upperOffset(j), y, j + 1);
+    }
+
+    /**
+     * @brief Solve A * X = B in place, A triangular and packed
+     *
+     * Column-oriented substitution: once x[j] is known, column j of A is
+     * eliminated from the remaining right-hand side with one axpy.
+     *
+     * @param n Size of the matrix
+     * @param lower Whether A is lower or upper triangular
+     * @param ap Packed storage with a nonzero diagonal
+     * @param nrhs Number of right-hand sides
+     * @param b Right-hand sides, column-major, overwritten by the solutions
+     * @param ldb Leading dimension of b
+     */
+    template <std::floating_point T>
+    void tpsv(size_t n, bool lower, const T *ap, size_t nrhs, T *b, size_t ldb)
+    {
+        for (size_t k = 0; k < nrhs; k++)
+        {
+            T *x = b + k * ldb;
+            if (lower)
+                for (size_t j = 0; j < n; j++)
+                {
+                    const T *column = ap + lowerOffset(n, j);
+                    x[j] /= column[0];
+                    simd::axpy(-x[j], column + 1, x + j + 1, n - j - 1);
+                }
+            else
+                for (size_t j = n; j-- > 0;)
+                {
+                    const T *column = ap + upperOffset(j);
+                    x[j] /= column[j];
+                    simd::axpy(-x[j], column, x, j);
+                }
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,450 @@
+#ifndef M42_SIMD_HPP
+#define M42_SIMD_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+#include "common.hpp"
+
+/**
+ * Kernels are written once against GCC vector extensions and compiled for
+ * several instruction sets with target_clones: the dynamic loader resolves
+ * every kernel once at startup from CPUID, so the same binary runs SSE2,
+ * AVX2 or AVX-512 code depending on the machine.
+ *
+ * The ifunc resolvers behind target_clones crash under ThreadSanitizer,
+ * sanitizer builds pass -DM42_SIMD_DISPATCH= to compile a single clone.
+ */
+#ifndef M42_SIMD_DISPATCH
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define M42_SIMD_DISPATCH __attribute__((target_clones("arch=x86-64-v4", "arch=x86-64-v3", "default")))
+#else
+#define M42_SIMD_DISPATCH
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define M42_SIMD_VECTOR_EXTENSIONS 1
+#else
+#define M42_SIMD_VECTOR_EXTENSIONS 0
+#endif
+
+namespace m42::simd
+{
+
+    /**
+     * @brief Types that have a vector register representation
+     */
+    template <typename T>
+    concept Vectorizable = (M42_SIMD_VECTOR_EXTENSIONS != 0) &&
+                           (std::same_as<T, float> || std::same_as<T, double> ||
+                            (std::integral<T> && !std::same_as<T, bool>));
+
+    /**
+     * @brief Scalar stand-in for types without a vector representation
+     *
+     * @tparam T Type of packet lanes
+     */
+    template <typename T>
+    struct PacketTraits
+    {
+        using type = T;
+        using unaligned = T;
+        static constexpr size_t lanes = 1;
+    };
+
+#if M42_SIMD_VECTOR_EXTENSIONS
+    /**
+     * @brief 64-byte packet of T, one AVX-512 register or several narrower ones
+     *
+     * @tparam T Type of packet lanes
+     */
+    template <Vectorizable T>
+    struct PacketTraits<T>
+    {
+        typedef T type __attribute__((vector_size(64)));
+        typedef T unaligned __attribute__((vector_size(64), aligned(alignof(T)), may_alias));
+        static constexpr size_t lanes = 64 / sizeof(T);
+    };
+#endif
+
+    template <typename T>
+    using Packet = typename PacketTraits<T>::type;
+
+    template <typename T>
+    inline constexpr size_t lanes = PacketTraits<T>::lanes;
+
+    /*
+     * Helpers below take and return packets by reference only: passing
+     * 64-byte vectors by value would depend on the enabled instruction set
+     * and is an ABI hazard across the dispatched clones.
+     */
+
+    /**
+     * @brief Access possibly unaligned memory as a packet
+     */
+    template <typename T>
+    inline const typename PacketTraits<T>::unaligned &packet(const T *p)
+    {
+        return *reinterpret_cast<const typename PacketTraits<T>::unaligned *>(p);
+    }
+
+    /**
+     * @brief Access possibly unaligned memory as a writable packet
+     */
+    template <typename T>
+    inline typename PacketTraits<T>::unaligned &packet(T *p)
+    {
+        return *reinterpret_cast<typename PacketTraits<T>::unaligned *>(p);
+    }
+
+    /**
+     * @brief Replace every lane of a packet with its absolute value
+     */
+    template <typename T>
+    inline void absInPlace(Packet<T> &v)
+    {
+        if constexpr (std::is_signed_v<T>)
+            v = v < 0 ? -v : v;
+    }
+
+    /**
+     * @brief Lane-wise acc = max(acc, v)
+     */
+    template <typename T>
+    inline void maxInPlace(Packet<T> &acc, const Packet<T> &v)
+    {
+        acc = acc > v ? acc : v;
+    }
+
+    /**
+     * @brief Sum of all lanes of a packet
+     */
+    template <typename T>
+    inline T reduceAdd(const Packet<T> &v)
+    {
+        T result = 0;
+        for (size_t l = 0; l < lanes<T>; l++)
+            result += v[l];
+        return result;
+    }
+
+    /**
+     * @brief Maximum of all lanes of a packet
+     */
+    template <typename T>
+    inline T reduceMax(const Packet<T> &v)
+    {
+        T result = v[0];
+        for (size_t l = 1; l < lanes<T>; l++)
+            result = result > v[l] ? result : v[l];
+        return result;
+    }
+
+    /**
+     * @brief Scalar absolute value that is also defined for unsigned types
+     */
+    template <Arithmetic T>
+    inline T scalarAbs(T value)
+    {
+        if constexpr (std::is_signed_v<T>)
+            return value < 0 ? -value : value;
+        else
+            return value;
+    }
+
+    /**
+     * @brief r = a + b
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void add(const T *a, const T *b, T *r, size_t n)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                packet(r + i) = packet(a + i) + packet(b + i);
+        for (; i < n; i++)
+            r[i] = a[i] + b[i];
+    }
+
+    /**
+     * @brief r = a - b
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void subtract(const T *a, const T *b, T *r, size_t n)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                packet(r + i) = packet(a + i) - packet(b + i);
+        for (; i < n; i++)
+            r[i] = a[i] - b[i];
+    }
+
+    /**
+     * @brief r = a * scalar
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void multiply(const T *a, T scalar, T *r, size_t n)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> s = Packet<T>{} + scalar;
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                packet(r + i) = packet(a + i) * s;
+        }
+        for (; i < n; i++)
+            r[i] = a[i] * scalar;
+    }
+
+    /**
+     * @brief r = a / scalar
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void divide(const T *a, T scalar, T *r, size_t n)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> s = Packet<T>{} + scalar;
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                packet(r + i) = packet(a + i) / s;
+        }
+        for (; i < n; i++)
+            r[i] = a[i] / scalar;
+    }
+
+    /**
+     * @brief r = -a
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void negate(const T *a, T *r, size_t n)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                packet(r + i) = -packet(a + i);
+        for (; i < n; i++)
+            r[i] = -a[i];
+    }
+
+    /**
+     * @brief y = alpha * x + y
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void axpy(T alpha, const T *x, T *y, size_t n)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> s = Packet<T>{} + alpha;
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                packet(y + i) = packet(y + i) + s * packet(x + i);
+        }
+        for (; i < n; i++)
+            y[i] += alpha * x[i];
+    }
+
+    /**
+     * @brief r = r + a * b element-wise
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void multiplyAccumulate(const T *a, const T *b, T *r, size_t n)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                packet(r + i) = packet(r + i) + packet(a + i) * packet(b + i);
+        for (; i < n; i++)
+            r[i] += a[i] * b[i];
+    }
+
+    /**
+     * @brief Dot product of a and b
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH T dot(const T *a, const T *b, size_t n)
+    {
+        T result = 0;
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> acc = {};
+            for (; i + lanes<T> <= n; i += lanes<T>)
+                acc += packet(a + i) * packet(b + i);
+            result = reduceAdd<T>(acc);
+        }
+        for (; i < n; i++)
+            result += a[i] * b[i];
+        return result;
+    }
+
+    /**
+     * @brief Sum of squares of a
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH T sumSquares(const T *a, size_t n)
+    {
+        return dot(a, a, n);
+    }
+
+    /**
+     * @brief Sum of absolute values of a
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH T sumAbs(const T *a, size_t n)
+    {
+        T result = 0;
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> acc = {};
+            for (; i + lanes<T> <= n; i += lanes<T>)
+            {
+                Packet<T> v = packet(a + i);
+                absInPlace<T>(v);
+                acc += v;
+            }
+            result = reduceAdd<T>(acc);
+        }
+        for (; i < n; i++)
+            result += scalarAbs(a[i]);
+        return result;
+    }
+
+    /**
+     * @brief Maximum absolute value of a, zero for an empty range
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH T maxAbs(const T *a, size_t n)
+    {
+        T result = 0;
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> acc = {};
+            for (; i + lanes<T> <= n; i += lanes<T>)
+            {
+                Packet<T> v = packet(a + i);
+                absInPlace<T>(v);
+                maxInPlace<T>(acc, v);
+            }
+            result = reduceMax<T>(acc);
+        }
+        for (; i < n; i++)
+            result = std::max(result, scalarAbs(a[i]));
+        return result;
+    }
+
+    /**
+     * @brief Maximum absolute difference between a and b, zero for an empty range
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH T maxAbsDiff(const T *a, const T *b, size_t n)
+    {
+        T result = 0;
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> acc = {};
+            for (; i + lanes<T> <= n; i += lanes<T>)
+            {
+                Packet<T> v = packet(a + i);
+                Packet<T> w = packet(b + i);
+                if constexpr (std::is_signed_v<T>)
+                {
+                    v -= w;
+                    absInPlace<T>(v);
+                }
+                else
+                {
+                    // unsigned lanes would wrap, subtract the smaller one instead
+                    Packet<T> larger = v;
+                    maxInPlace<T>(larger, w);
+                    v = larger - (v + w - larger);
+                }
+                maxInPlace<T>(acc, v);
+            }
+            result = reduceMax<T>(acc);
+        }
+        for (; i < n; i++)
+            result = std::max(result, static_cast<T>(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]));
+        return result;
+    }
+
+    /**
+     * @brief Apply a 4x4 column-major matrix to n points stored as four arrays
+     *
+     * Every lane of a packet is one point, so the 16 coefficients are
+     * broadcast once and each packet costs 16 multiply-adds. Outputs may
+     * alias the inputs of the same component.
+     *
+     * @param m Column-major 4x4 matrix
+     * @param x, y, z Input coordinates
+     * @param w Input w coordinates, nullptr for w = 1
+     * @param ox, oy, oz Output coordinates
+     * @param ow Output w coordinates, nullptr to drop them
+     * @param n Number of points
+     * @param divide Whether to divide x, y and z by the transformed w
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void transform4(const T *m, const T *x, const T *y, const T *z, const T *w,
+                                      T *ox, T *oy, T *oz, T *ow, size_t n, bool divide)
+    {
+        size_t i = 0;
+        if constexpr (Vectorizable<T>)
+        {
+            Packet<T> one = Packet<T>{} + T(1);
+            for (; i + lanes<T> <= n; i += lanes<T>)
+            {
+                Packet<T> in[4] = {packet(x + i), packet(y + i), packet(z + i), w ? packet(w + i) : one};
+                Packet<T> out[4];
+                for (size_t r = 0; r < 4; r++)
+                {
+                    out[r] = in[0] * m[r];
+                    for (size_t c = 1; c < 4; c++)
+                        out[r] += in[c] * m[c * 4 + r];
+                }
+                if (divide)
+                {
+                    Packet<T> scale = one / out[3];
+                    for (size_t r = 0; r < 3; r++)
+                        out[r] *= scale;
+                }
+                packet(ox + i) = out[0];
+                packet(oy + i) = out[1];
+                packet(oz + i) = out[2];
+                if (ow)
+                    packet(ow + i) = out[3];
+            }
+        }
+        for (; i < n; i++)
+        {
+            T in[4] = {x[i], y[i], z[i], w ? w[i] : T(1)};
+            T out[4];
+            for (size_t r = 0; r < 4; r++)
+            {
+                out[r] = in[0] * m[r];
+                for (size_t c = 1; c < 4; c++)
+                    out[r] += in[c] * m[c * 4 + r];
+            }
+            if (divide)
+            {
+                T scale = T(1) / out[3];
+                for (size_t r = 0; r < 3; r++)
+                    out[r] *= scale;
+            }
+            ox[i] = out[0];
+            oy[i] = out[1];
+            oz[i] = out[2];
+            if (ow)
+                ow[i] = out[3];
+        }
+    }
+
+}
+
+#endif
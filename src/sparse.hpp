@@ -0,0 +1,283 @@
+#ifndef M42_SPARSE_HPP
+#define M42_SPARSE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include "common.hpp"
+#include "simd.hpp"
+
+/**
+ * Kernels on compressed sparse storage. A compressed matrix is a list of
+ * major lines (rows for CSR, columns for CSC): line i owns the entries
+ * offsets[i] to offsets[i + 1] of indices and values, sorted by their
+ * minor index, without duplicates.
+ */
+namespace m42::sparse
+{
+
+    /**
+     * @brief Build compressed storage from unordered triplets
+     *
+     * Entries are bucketed by major index with a counting sort, then every
+     * line is sorted by minor index and duplicates are summed.
+     *
+     * @param majors Number of major lines
+     * @param nnz Number of triplets
+     * @param major Major index of every triplet
+     * @param minor Minor index of every triplet
+     * @param values Value of every triplet
+     * @param offsets Resized to majors + 1 line offsets
+     * @param indices Minor index of every stored entry
+     * @param outValues Value of every stored entry
+     */
+    template <Arithmetic T>
+    void compress(size_t majors, size_t nnz, const size_t *major, const size_t *minor, const T *values,
+                  std::vector<size_t> &offsets, std::vector<size_t> &indices, std::vector<T> &outValues)
+    {
+        offsets.assign(majors + 1, 0);
+        for (size_t k = 0; k < nnz; k++)
+            offsets[major[k] + 1]++;
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        indices.resize(nnz);
+        outValues.resize(nnz);
+        for (size_t k = 0; k < nnz; k++)
+        {
+            size_t position = next[major[k]]++;
+            indices[position] = minor[k];
+            outValues[position] = values[k];
+        }
+
+        // sort every line and merge duplicates, compacting in place
+        std::vector<size_t> order;
+        std::vector<T> line;
+        size_t written = 0;
+        for (size_t i = 0; i < majors; i++)
+        {
+            size_t begin = offsets[i];
+            size_t end = offsets[i + 1];
+            offsets[i] = written;
+            if (!std::is_sorted(indices.begin() + begin, indices.begin() + end))
+            {
+                order.resize(end - begin);
+                std::iota(order.begin(), order.end(), begin);
+                std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                                 { return indices[a] < indices[b]; });
+                line.resize(end - begin);
+                for (size_t k = 0; k < order.size(); k++)
+                    line[k] = outValues[order[k]];
+                for (size_t k = 0; k < order.size(); k++)
+                    order[k] = indices[order[k]];
+                std::copy(order.begin(), order.end(), indices.begin() + begin);
+                std::copy(line.begin(), line.end(), outValues.begin() + begin);
+            }
+            for (size_t k = begin; k < end; k++)
+            {
+                if (written > offsets[i] && indices[written - 1] == indices[k])
+                    outValues[written - 1] += outValues[k];
+                else
+                {
+                    indices[written] = indices[k];
+                    outValues[written] = outValues[k];
+                    written++;
+                }
+            }
+        }
+        offsets[majors] = written;
+        indices.resize(written);
+        outValues.resize(written);
+    }
+
+    /**
+     * @brief Swap the major and minor roles of compressed storage
+     *
+     * Turns CSR into CSC of the same matrix and vice versa. Walking the
+     * lines in order leaves every output line sorted.
+     *
+     * @param majors Number of major lines of the input
+     * @param minors Number of minor lines of the input
+     * @param offsets Input line offsets
+     * @param indices Input minor indices
+     * @param values Input values
+     * @param outOffsets Output line offsets, minors + 1 of them
+     * @param outIndices Output minor indices
+     * @param outValues Output values
+     */
+    template <Arithmetic T>
+    void transpose(size_t majors, size_t minors,
+                   const size_t *offsets, const size_t *indices, const T *values,
+                   std::vector<size_t> &outOffsets, std::vector<size_t> &outIndices, std::vector<T> &outValues)
+    {
+        size_t nnz = offsets[majors];
+        outOffsets.assign(minors + 1, 0);
+        for (size_t k = 0; k < nnz; k++)
+            outOffsets[indices[k] + 1]++;
+        std::partial_sum(outOffsets.begin(), outOffsets.end(), outOffsets.begin());
+        std::vector<size_t> next(outOffsets.begin(), outOffsets.end() - 1);
+        outIndices.resize(nnz);
+        outValues.resize(nnz);
+        for (size_t i = 0; i < majors; i++)
+            for (size_t k = offsets[i]; k < offsets[i + 1]; k++)
+            {
+                size_t position = next[indices[k]]++;
+                outIndices[position] = i;
+                outValues[position] = values[k];
+            }
+    }
+
+    /**
+     * @brief Sparse row times dense vector, the inner product of CSR SpMV
+     *
+     * Four independent accumulators hide the latency of the gathered loads.
+     *
+     * @param count Number of entries in the row
+     * @param indices Column index of every entry
+     * @param values Value of every entry
+     * @param x Dense vector
+     * @return T Dot product
+     */
+    template <Arithmetic T>
+    inline T gatherDot(size_t count, const size_t *indices, const T *values, const T *x)
+    {
+        T sum0 = 0;
+        T sum1 = 0;
+        T sum2 = 0;
+        T sum3 = 0;
+        size_t k = 0;
+        for (; k + 4 <= count; k += 4)
+        {
+            sum0 += values[k] * x[indices[k]];
+            sum1 += values[k + 1] * x[indices[k + 1]];
+            sum2 += values[k + 2] * x[indices[k + 2]];
+            sum3 += values[k + 3] * x[indices[k + 3]];
+        }
+        for (; k < count; k++)
+            sum0 += values[k] * x[indices[k]];
+        return (sum0 + sum1) + (sum2 + sum3);
+    }
+
+    /**
+     * @brief CSR matrix-vector product y = A * x
+     *
+     * @param m Number of rows of A and size of y
+     * @param offsets Row offsets of A
+     * @param indices Column indices of A
+     * @param values Values of A
+     * @param x Dense vector of A's width
+     * @param y Dense vector of m elements, overwritten
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void csrmv(size_t m, const size_t *offsets, const size_t *indices, const T *values,
+                                 const T *x, T *y)
+    {
+        for (size_t i = 0; i < m; i++)
+            y[i] = gatherDot(offsets[i + 1] - offsets[i], indices + offsets[i], values + offsets[i], x);
+    }
+
+    /**
+     * @brief CSC matrix-vector product y = A * x
+     *
+     * Every column of A is scattered into y scaled by one element of x.
+     *
+     * @param m Number of rows of A and size of y
+     * @param n Number of columns of A and size of x
+     * @param offsets Column offsets of A
+     * @param indices Row indices of A
+     * @param values Values of A
+     * @param x Dense vector of n elements
+     * @param y Dense vector of m elements, overwritten
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void cscmv(size_t m, size_t n, const size_t *offsets, const size_t *indices, const T *values,
+                                 const T *x, T *y)
+    {
+        std::fill(y, y + m, T(0));
+        for (size_t j = 0; j < n; j++)
+        {
+            T xj = x[j];
+            for (size_t k = offsets[j]; k < offsets[j + 1]; k++)
+                y[indices[k]] += values[k] * xj;
+        }
+    }
+
+    /**
+     * @brief CSR times dense matrix C = A * B, B and C column-major
+     *
+     * Columns of B are processed four at a time so every index and value of
+     * A is loaded once per four products.
+     *
+     * @param m Number of rows of A and C
+     * @param n Number of columns of B and C
+     * @param offsets Row offsets of A
+     * @param indices Column indices of A
+     * @param values Values of A
+     * @param b Pointer to B
+     * @param ldb Leading dimension of B
+     * @param c Pointer to C, overwritten
+     * @param ldc Leading dimension of C
+     */
+    template <Arithmetic T>
+    M42_SIMD_DISPATCH void csrmm(size_t m, size_t n, const size_t *offsets, const size_t *indices, const T *values,
+                                 const T *b, size_t ldb, T *c, size_t ldc)
+    {
+        size_t j = 0;
+        for (; j + 4 <= n; j += 4)
+        {
+            const T *b0 = b + j * ldb;
+            const T *b1 = b0 + ldb;
+            const T *b2 = b1 + ldb;
+            const T *b3 = b2 + ldb;
+            for (size_t i = 0; i < m; i++)
+            {
+                T sum0 = 0;
+                T sum1 = 0;
+                T sum2 = 0;
+                T sum3 = 0;
+                for (size_t k = offsets[i]; k < offsets[i + 1]; k++)
+                {
+                    size_t column = indices[k];
+                    T value = values[k];
+                    sum0 += value * b0[column];
+                    sum1 += value * b1[column];
+                    sum2 += value * b2[column];
+                    sum3 += value * b3[column];
+                }
+                c[j * ldc + i] = sum0;
+                c[(j + 1) * ldc + i] = sum1;
+                c[(j + 2) * ldc + i] = sum2;
+                c[(j + 3) * ldc + i] = sum3;
+            }
+        }
+        for (; j < n; j++)
+            csrmv(m, offsets, indices, values, b + j * ldb, c + j * ldc);
+    }
+
+    /**
+     * @brief CSC times dense matrix C = A * B, B and C column-major
+     *
+     * @param m Number of rows of A and C
+     * @param k Number of columns of A and rows of B
+     * @param n Number of columns of B and C
+     * @param offsets Column offsets of A
+     * @param indices Row indices of A
+     * @param values Values of A
+     * @param b Pointer to B
+     * @param ldb Leading dimension of B
+     * @param c Pointer to C, overwritten
+     * @param ldc Leading dimension of C
+     */
+    template <Arithmetic T>
+    void cscmm(size_t m, size_t k, size_t n, const size_t *offsets, const size_t *indices, const T *values,
+               const T *b, size_t ldb, T *c, size_t ldc)
+    {
+        for (size_t j = 0; j < n; j++)
+            cscmv(m, k, offsets, indices, values, b + j * ldb, c + j * ldc);
+    }
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef M42_TESTS_FIXTURES_HPP
+#define M42_TESTS_FIXTURES_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#include "Matrix.hpp"
+
+/**
+ * Operands shared by the tests. Elements are distinct and well spread,
+ * so blocked and vectorized results can be compared with naive ones up
+ * to rounding.
+ */
+
+/**
+ * @brief Build a matrix whose elements encode their position
+ *
+ * @param seed Shift of every element, different seeds give unrelated matrices
+ * @param padding Column padding of the storage
+ */
+inline m42::Matrix<double> numbered(size_t width, size_t height, double seed = 0.0,
+                                    m42::Padding padding = m42::Padding::None)
+{
+    m42::Matrix<double> a(width, height, padding);
+    for (size_t j = 0; j < width; j++)
+        for (size_t i = 0; i < height; i++)
+            a[j][i] = std::sin(seed + static_cast<double>(i * j + 3 * i + 7 * j + 1));
+    return a;
+}
+
+/**
+ * @brief Build a smooth vector with no zero elements
+ */
+inline m42::Vector<double> numberedVector(size_t n)
+{
+    m42::Vector<double> x(n);
+    for (size_t i = 0; i < n; i++)
+        x[i] = std::cos(static_cast<double>(i) * 0.7) + 1.5;
+    return x;
+}
+
+#endif
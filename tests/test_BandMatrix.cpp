@@ -0,0 +1,210 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "BandMatrix.hpp"
+#include "LU.hpp"
+#include "fixtures.hpp"
+
+using namespace m42;
+
+TEST_CASE("BandMatrix stores its diagonals compactly", "[BandMatrix]")
+{
+    Matrix<int> dense{
+        {1, 2, 0, 0},
+        {3, 4, 5, 0},
+        {6, 7, 8, 9},
+        {0, 10, 11, 12},
+    };
+    BandMatrix<int> band(dense, 2, 1);
+    REQUIRE(band.size() == 4);
+    REQUIRE(band.toDense() == dense);
+    REQUIRE(band.diagonal(0) == Vector<int>{1, 4, 8, 12});
+    REQUIRE(band.diagonal(1) == Vector<int>{2, 5, 9});
+    REQUIRE(band.diagonal(-1) == Vector<int>{3, 7, 11});
+    REQUIRE(band.diagonal(-2) == Vector<int>{6, 10});
+    // reading through a const matrix gives zero outside the band
+    const BandMatrix<int> &constant = band;
+    REQUIRE(constant(3, 1) == 0);
+    REQUIRE(constant(1, 3) == 10);
+
+    band.diagonal(1)[2] = -9;
+    REQUIRE(band(3, 2) == -9);
+    REQUIRE_THROWS_AS(band.diagonal(2), std::out_of_range);
+    REQUIRE_THROWS_AS(band.diagonal(-3), std::out_of_range);
+    REQUIRE_THROWS_AS(band(3, 0) = 1, std::out_of_range);
+    REQUIRE_THROWS_AS(BandMatrix<int>(3, 3, 0), std::invalid_argument);
+}
+
+TEST_CASE("BandMatrix product matches the dense product", "[BandMatrix]")
+{
+    BandMatrix<double> a(numbered(37, 37), 2, 3);
+    Vector<double> x = numberedVector(37);
+    REQUIRE((a * x).isApprox(a.toDense() * x, 1e-12));
+
+    // strided operand and result
+    Matrix<double> rows(37, 2);
+    rows.setRow(0, x);
+    VectorView<double> y = rows.row(1);
+    a.multiply(rows.row(0), y);
+    REQUIRE(Vector<double>(rows.row(1)).isApprox(a.toDense() * x, 1e-12));
+}
+
+TEST_CASE("Banded multiply into its own operand", "[BandMatrix]")
+{
+    Matrix<double> dense{
+        {1, 2, 0},
+        {3, 4, 5},
+        {0, 6, 7},
+    };
+    Vector<double> v{1, 1, 1};
+    BandMatrix<double>(dense, 1, 1).multiply(v, v);
+    REQUIRE(v == Vector<double>{3, 12, 13});
+
+    TridiagonalMatrix<double> t(Vector<double>{3, 6}, Vector<double>{1, 4, 7}, Vector<double>{2, 5});
+    Vector<double> w{1, 1, 1};
+    t.multiply(w, w);
+    REQUIRE(w == Vector<double>{3, 12, 13});
+}
+
+TEST_CASE("Empty BandMatrix has no off-diagonals", "[BandMatrix]")
+{
+    REQUIRE_THROWS_AS(BandMatrix<double>(0, 1, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(BandMatrix<double>(0, 0, 1), std::invalid_argument);
+
+    BandMatrix<double> empty(0, 0, 0);
+    REQUIRE(empty.diagonal(0).size() == 0);
+    Vector<double> x(0);
+    Vector<double> y(0);
+    empty.multiply(x, y);
+    REQUIRE((empty * x).size() == 0);
+    REQUIRE(empty.lu().solve(x).size() == 0);
+}
+
+TEST_CASE("BandLU solves banded systems with pivoting", "[BandMatrix]")
+{
+    for (auto [lower, upper] : {std::pair<size_t, size_t>{1, 1}, {2, 2}, {3, 1}, {0, 2}, {4, 0}})
+    {
+        const size_t n = 50;
+        BandMatrix<double> a(numbered(n, n), lower, upper);
+        for (size_t i = 0; i < n; i++)
+            a(i, i) += lower == 0 || upper == 0 ? 2.0 : 0.0;
+        BandLU<double> lu = a.lu();
+        REQUIRE_FALSE(lu.isSingular());
+        Vector<double> b = numberedVector(n);
+        Vector<double> x = lu.solve(b);
+        REQUIRE((a * x).isApprox(b, 1e-9));
+
+        double dense = LU<double>(a.toDense()).determinant();
+        REQUIRE(std::abs(lu.determinant() - dense) <= 1e-9 * std::abs(dense));
+    }
+
+    // several right-hand sides in a block of a larger matrix
+    BandMatrix<double> a(numbered(20, 20), 2, 1);
+    Matrix<double> storage(5, 24);
+    for (size_t j = 0; j < 5; j++)
+        for (size_t i = 0; i < 24; i++)
+            storage[j][i] = std::sin(static_cast<double>(i + 24 * j));
+    MatrixView<double> b = storage.block(1, 2, 3, 20);
+    Matrix<double> original(b);
+    a.lu().solveInPlace(b);
+    REQUIRE((a.toDense() * b).isAprrox(original, 1e-9));
+
+    BandMatrix<double> singular(3, 1, 1);
+    singular(0, 0) = 1;
+    singular(2, 2) = 1;
+    REQUIRE(singular.lu().isSingular());
+    REQUIRE(singular.lu().determinant() == 0);
+    REQUIRE_THROWS_AS(singular.lu().solve(Vector<double>{1, 2, 3}), std::invalid_argument);
+}
+
+TEST_CASE("TridiagonalMatrix solves with the Thomas algorithm", "[BandMatrix]")
+{
+    const size_t n = 100;
+    Vector<double> lower(n - 1);
+    Vector<double> diagonal(n);
+    Vector<double> upper(n - 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        diagonal[i] = 4.0 + std::sin(static_cast<double>(i));
+        if (i + 1 < n)
+        {
+            lower[i] = -1.0 - 0.01 * static_cast<double>(i % 5);
+            upper[i] = -1.5;
+        }
+    }
+    TridiagonalMatrix<double> a(lower, diagonal, upper);
+    Vector<double> b = numberedVector(n);
+    Vector<double> x = a.solve(b);
+    REQUIRE((a * x).isApprox(b, 1e-12));
+    REQUIRE((a.toDense() * x).isApprox(b, 1e-12));
+
+    // one elimination for every column
+    Matrix<double> rhs(3, n);
+    for (size_t j = 0; j < 3; j++)
+        for (size_t i = 0; i < n; i++)
+            rhs[j][i] = b[i] * static_cast<double>(j + 1);
+    a.solveInPlace(rhs);
+    REQUIRE(Vector<double>(rhs[2]).isApprox(x * 3.0, 1e-12));
+    a.solveInPlace(rhs[0]);
+    REQUIRE((a * Vector<double>(rhs[0])).isApprox(x, 1e-12));
+
+    TridiagonalMatrix<double> zero(3);
+    REQUIRE_THROWS_AS(zero.solve(Vector<double>{1, 2, 3}), std::invalid_argument);
+    REQUIRE_THROWS_AS(TridiagonalMatrix<double>(Vector<double>{1}, Vector<double>{1, 2, 3}, Vector<double>{1, 2}),
+                      std::invalid_argument);
+}
+
+TEST_CASE("Batched tridiagonal solves match individual solves", "[BandMatrix]")
+{
+    const size_t n = 40;
+    const size_t count = 19;
+    Matrix<double> lower(n, count);
+    Matrix<double> diagonal(n, count);
+    Matrix<double> upper(n, count);
+    Matrix<double> b(n, count);
+    for (size_t i = 0; i < n; i++)
+        for (size_t k = 0; k < count; k++)
+        {
+            lower[i][k] = -1.0 + 0.02 * static_cast<double>(k);
+            diagonal[i][k] = 3.0 + std::cos(static_cast<double>(i * k));
+            upper[i][k] = -0.5 - 0.01 * static_cast<double>(i);
+            b[i][k] = std::sin(static_cast<double>(i + n * k));
+        }
+    Matrix<double> x(b);
+    solveTridiagonalBatch<double>(lower, diagonal, upper, x);
+
+    for (size_t k = 0; k < count; k++)
+    {
+        Vector<double> l(n - 1);
+        Vector<double> u(n - 1);
+        for (size_t i = 0; i + 1 < n; i++)
+        {
+            l[i] = lower[i + 1][k];
+            u[i] = upper[i][k];
+        }
+        TridiagonalMatrix<double> a(l, Vector<double>(diagonal.row(k)), u);
+        REQUIRE(Vector<double>(x.row(k)).isApprox(a.solve(b.row(k)), 1e-12));
+    }
+
+    // the unused corners are never read
+    Matrix<double> poisoned(b);
+    for (size_t k = 0; k < count; k++)
+    {
+        lower[0][k] = std::numeric_limits<double>::quiet_NaN();
+        upper[n - 1][k] = std::numeric_limits<double>::infinity();
+    }
+    solveTridiagonalBatch<double>(lower, diagonal, upper, poisoned);
+    REQUIRE(poisoned == x);
+
+    // a NaN pivot is reported like a zero one
+    diagonal[n / 2][count - 1] = std::numeric_limits<double>::quiet_NaN();
+    Matrix<double> nan(b);
+    REQUIRE_THROWS_AS(solveTridiagonalBatch<double>(lower, diagonal, upper, nan), std::invalid_argument);
+    diagonal[n / 2][0] = std::numeric_limits<double>::quiet_NaN();
+    REQUIRE_THROWS_AS(solveTridiagonalBatch<double>(lower, diagonal, upper, nan), std::invalid_argument);
+
+    Matrix<double> wrong(n, count + 1);
+    REQUIRE_THROWS_AS(solveTridiagonalBatch<double>(lower, diagonal, upper, wrong), std::invalid_argument);
+}
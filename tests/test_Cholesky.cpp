@@ -0,0 +1,103 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+#include "Matrix.hpp"
+
+using namespace m42;
+
+/**
+ * @brief Build a symmetric positive definite Gram-like matrix
+ */
+static Matrix<double> spd(size_t n)
+{
+    Matrix<double> a(n, n);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            a[j][i] = 1.0 / (1.0 + static_cast<double>(i > j ? i - j : j - i)) + (i == j ? n : 0.0);
+    return a;
+}
+
+TEST_CASE("Cholesky factorization reconstructs the matrix", "[Cholesky]")
+{
+    // large enough for several blocked panels
+    const size_t n = 150;
+    Matrix<double> a = spd(n);
+    Cholesky<double> cholesky = a.cholesky();
+    Matrix<double> l = cholesky.lower();
+    bool upperIsZero = true;
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < j; i++)
+            upperIsZero = upperIsZero && l[j][i] == 0.0;
+    REQUIRE(upperIsZero);
+    REQUIRE((l * l.transpose()).isAprrox(a, 1e-10));
+}
+
+TEST_CASE("Cholesky factorization reads only the lower triangle", "[Cholesky]")
+{
+    Matrix m{
+        {4.0, 12.0, -16.0},
+        {12.0, 37.0, -43.0},
+        {-16.0, -43.0, 98.0},
+    };
+    Matrix lowerOnly{
+        {4.0, 0.0, 0.0},
+        {12.0, 37.0, 0.0},
+        {-16.0, -43.0, 98.0},
+    };
+    Matrix<double> expected{
+        {2.0, 0.0, 0.0},
+        {6.0, 1.0, 0.0},
+        {-8.0, 5.0, 3.0},
+    };
+    REQUIRE(m.cholesky().lower().isAprrox(expected, 1e-12));
+    REQUIRE(lowerOnly.cholesky().lower().isAprrox(expected, 1e-12));
+    REQUIRE(std::abs(m.cholesky().determinant() - 36.0) < 1e-9);
+    REQUIRE(std::abs(m.cholesky().logDeterminant() - std::log(36.0)) < 1e-12);
+}
+
+TEST_CASE("Solve with Cholesky factorization", "[Cholesky]")
+{
+    const size_t n = 130;
+    Matrix<double> a = spd(n);
+    Cholesky<double> cholesky = a.cholesky();
+
+    Vector<double> b(n);
+    for (size_t i = 0; i < n; i++)
+        b[i] = std::sin(static_cast<double>(i));
+    REQUIRE((a * cholesky.solve(b)).isApprox(b, 1e-10));
+
+    Matrix<double> rhs(20, n);
+    for (size_t j = 0; j < 20; j++)
+        for (size_t i = 0; i < n; i++)
+            rhs[j][i] = std::cos(static_cast<double>(i * 20 + j));
+    REQUIRE((a * cholesky.solve(rhs)).isAprrox(rhs, 1e-10));
+    Matrix<double> storage(21, n + 2);
+    storage.block(1, 2, 20, n) = rhs;
+    cholesky.solveInPlace(storage.block(1, 2, 20, n));
+    REQUIRE((a * Matrix<double>(storage.block(1, 2, 20, n))).isAprrox(rhs, 1e-10));
+    Matrix<double> columns(rhs);
+    cholesky.solveInPlace(columns[3]);
+    REQUIRE((a * Vector<double>(columns[3])).isApprox(rhs[3], 1e-10));
+    REQUIRE(std::abs(cholesky.logDeterminant() - a.lu().logAbsDeterminant()) < 1e-9);
+
+    REQUIRE_THROWS_AS(cholesky.solve(Vector({1.0, 2.0})), std::invalid_argument);
+}
+
+TEST_CASE("Cholesky factorization of invalid matrices", "[Cholesky]")
+{
+    Matrix indefinite{
+        {1.0, 2.0},
+        {2.0, 1.0},
+    };
+    REQUIRE_THROWS_AS(indefinite.cholesky(), std::invalid_argument);
+    REQUIRE_THROWS_AS(Matrix<double>(2, 3).cholesky(), std::invalid_argument);
+
+    Matrix<int> integral{
+        {4, 2},
+        {2, 5},
+    };
+    REQUIRE(integral.cholesky().lower() == Matrix{
+        {2.0, 0.0},
+        {1.0, 2.0},
+    });
+}
@@ -0,0 +1,63 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <type_traits>
+
+#include "functions.hpp"
+
+using namespace m42;
+
+TEST_CASE("FixedMatrix arithmetic is constexpr", "[FixedMatrix]")
+{
+    constexpr FixedMatrix<int, 3, 2> a({
+        {1, 2, 3},
+        {4, 5, 6},
+    });
+    constexpr FixedMatrix<int, 2, 3> b({
+        {1, 0},
+        {0, 1},
+        {1, 1},
+    });
+    static_assert(a(2, 1) == 6);
+    static_assert(a.width() == 3 && a.height() == 2);
+    static_assert(a.row(1) == FixedVector<int, 3>{4, 5, 6});
+    static_assert(a.column(2) == FixedVector<int, 2>{3, 6});
+    static_assert(a * b == FixedMatrix<int, 2, 2>({{4, 5}, {10, 11}}));
+    static_assert(b * a == FixedMatrix<int, 3, 3>({{1, 2, 3}, {4, 5, 6}, {5, 7, 9}}));
+    static_assert(a.transpose() == FixedMatrix<int, 2, 3>({{1, 4}, {2, 5}, {3, 6}}));
+    static_assert(a * FixedVector<int, 3>{1, 1, 1} == FixedVector<int, 2>{6, 15});
+    static_assert(FixedVector<int, 2>{1, 1} * a == FixedVector<int, 3>{5, 7, 9});
+    static_assert((a + a) - a == a && a * 2 == a + a);
+    static_assert(FixedMatrix<int, 3, 3>::identity().trace() == 3);
+    static_assert(sizeof(FixedMatrix<float, 4, 4>) == 16 * sizeof(float));
+    // shapes are part of the type, mismatched products do not compile
+    static_assert(!std::is_invocable_v<std::multiplies<>, FixedMatrix<int, 3, 2>, FixedMatrix<int, 3, 2>>);
+    static_assert(!std::is_invocable_v<std::multiplies<>, FixedMatrix<int, 3, 2>, FixedVector<int, 2>>);
+}
+
+TEST_CASE("FixedMatrix interoperates with Matrix", "[FixedMatrix]")
+{
+    FixedMatrix<double, 3, 3> fixed({
+        {4.0, 12.0, -16.0},
+        {12.0, 37.0, -43.0},
+        {-16.0, -43.0, 98.0},
+    });
+    Matrix<double> dynamic(fixed.view());
+    REQUIRE(dynamic == Matrix<double>{{4.0, 12.0, -16.0}, {12.0, 37.0, -43.0}, {-16.0, -43.0, 98.0}});
+    REQUIRE(Cholesky<double>(fixed.view()).lower() == Matrix<double>{{2.0, 0.0, 0.0}, {6.0, 1.0, 0.0}, {-8.0, 5.0, 3.0}});
+    REQUIRE(FixedMatrix<double, 3, 3>(dynamic) == fixed);
+    REQUIRE(FixedMatrix<double, 2, 2>(dynamic.block(1, 1, 2, 2)) == FixedMatrix<double, 2, 2>({{37.0, -43.0}, {-43.0, 98.0}}));
+    REQUIRE_THROWS_AS((FixedMatrix<double, 2, 3>(dynamic)), std::invalid_argument);
+
+    FixedVector<double, 3> x{1.0, -2.0, 0.5};
+    REQUIRE(Vector<double>((fixed * x).view()) == dynamic * Vector<double>(x.view()));
+    REQUIRE(Matrix<double>((fixed * fixed).view()).isAprrox(dynamic * dynamic));
+}
+
+TEST_CASE("Fixed projection matrix matches the dynamic one", "[FixedMatrix]")
+{
+    FixedMatrix<float, 4, 4> fixed = makeFixedProjectionMatrix(M_PI / 4.0f, 1.0f, 1.0f, 100.0f);
+    REQUIRE(makeProjectionMatrix(M_PI / 4.0f, 1.0f, 1.0f, 100.0f) == fixed.view());
+    FixedVector<float, 4> point = fixed * FixedVector<float, 4>{0.0f, 0.0f, -1.0f, 1.0f};
+    REQUIRE(point[3] == 1.0f);
+    REQUIRE(std::abs(point[2] + 1.0f) < 1e-6f);
+}
@@ -0,0 +1,45 @@
+#include <catch2/catch_test_macros.hpp>
+#include <type_traits>
+
+#include "functions.hpp"
+
+using namespace m42;
+
+TEST_CASE("FixedVector arithmetic is constexpr", "[FixedVector]")
+{
+    constexpr FixedVector<int, 3> a{1, 2, 3};
+    constexpr FixedVector<int, 3> b{4, 5, 6};
+    static_assert(a + b == FixedVector<int, 3>{5, 7, 9});
+    static_assert(b - a == FixedVector<int, 3>{3, 3, 3});
+    static_assert(-a == FixedVector<int, 3>{-1, -2, -3});
+    static_assert(a * 2 == 2 * a);
+    static_assert(b / 2 == FixedVector<int, 3>{2, 2, 3});
+    static_assert(a * b == 32);
+    static_assert(a.normSquared() == 14);
+    static_assert(crossProduct(a, b) == FixedVector<int, 3>{-3, 6, -3});
+    static_assert(FixedVector<int, 3>::size() == 3);
+    static_assert(sizeof(FixedVector<float, 4>) == 4 * sizeof(float));
+    // sizes are part of the type, mixing them does not compile
+    static_assert(!std::is_invocable_v<std::plus<>, FixedVector<int, 3>, FixedVector<int, 4>>);
+    static_assert(!std::is_constructible_v<FixedVector<int, 3>, int, int>);
+
+    FixedVector<double, 3> v{3.0, 0.0, 4.0};
+    REQUIRE(v.norm() == 5.0);
+    v += FixedVector<double, 3>{1.0, 1.0, 1.0};
+    v *= 2.0;
+    REQUIRE(v == FixedVector<double, 3>{8.0, 2.0, 10.0});
+}
+
+TEST_CASE("FixedVector interoperates with Vector", "[FixedVector]")
+{
+    FixedVector<double, 3> fixed{1.0, 2.0, 3.0};
+    Vector<double> dynamic(fixed.view());
+    REQUIRE(dynamic == Vector{1.0, 2.0, 3.0});
+    REQUIRE(crossProduct(dynamic, Vector{4.0, 5.0, 6.0}) == Vector(crossProduct(fixed, FixedVector<double, 3>{4.0, 5.0, 6.0}).view()));
+
+    fixed.view() += dynamic;
+    REQUIRE(fixed == FixedVector<double, 3>{2.0, 4.0, 6.0});
+    REQUIRE(FixedVector<double, 3>(dynamic) == FixedVector<double, 3>{1.0, 2.0, 3.0});
+    REQUIRE_THROWS_AS((FixedVector<double, 2>(dynamic)), std::invalid_argument);
+    REQUIRE(static_cast<std::string>(FixedVector<int, 2>{1, 2}) == "[1 2]");
+}
@@ -0,0 +1,239 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <stdexcept>
+
+#include "Krylov.hpp"
+
+using namespace m42;
+
+/**
+ * @brief 1D Poisson matrix, tridiagonal(-1, 2, -1), symmetric positive definite
+ */
+static CsrMatrix<double> poisson(size_t n)
+{
+    CooMatrix<double> coo(n, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        coo.add(i, i, 2.0);
+        if (i > 0)
+            coo.add(i, i - 1, -1.0);
+        if (i + 1 < n)
+            coo.add(i, i + 1, -1.0);
+    }
+    return CsrMatrix<double>(coo);
+}
+
+/**
+ * @brief 2D convection-diffusion on a k x k grid, nonsymmetric
+ */
+static CsrMatrix<double> convectionDiffusion(size_t k)
+{
+    size_t n = k * k;
+    CooMatrix<double> coo(n, n);
+    for (size_t y = 0; y < k; y++)
+        for (size_t x = 0; x < k; x++)
+        {
+            size_t i = y * k + x;
+            coo.add(i, i, 4.0 + 0.1 * static_cast<double>(i % 7));
+            if (x > 0)
+                coo.add(i, i - 1, -1.4);
+            if (x + 1 < k)
+                coo.add(i, i + 1, -0.6);
+            if (y > 0)
+                coo.add(i, i - k, -1.2);
+            if (y + 1 < k)
+                coo.add(i, i + k, -0.8);
+        }
+    return CsrMatrix<double>(coo);
+}
+
+/**
+ * @brief Relative residual ||b - A * x|| / ||b|| computed from scratch
+ */
+template <typename A>
+static double trueResidual(const A &a, const Vector<double> &b, const Vector<double> &x)
+{
+    Vector<double> r = a * x;
+    r -= b;
+    return r.norm() / b.norm();
+}
+
+/**
+ * @brief Smooth right-hand side with no zero elements
+ */
+static Vector<double> rightHandSide(size_t n)
+{
+    Vector<double> b(n);
+    for (size_t i = 0; i < n; i++)
+        b[i] = std::sin(static_cast<double>(i) * 0.37) + 0.5;
+    return b;
+}
+
+TEST_CASE("Conjugate gradient solves symmetric positive definite systems", "[Krylov]")
+{
+    const size_t n = 200;
+    CsrMatrix<double> a = poisson(n);
+    Vector<double> b = rightHandSide(n);
+    ConjugateGradient<double> cg({.tolerance = 1e-10, .maxIterations = 1000});
+
+    Vector<double> x(n);
+    std::fill(x.data(), x.data() + n, 0.0);
+    SolverStatistics plain = cg.solve(a, b, x);
+    REQUIRE(plain.converged);
+    REQUIRE(plain.iterations <= n);
+    REQUIRE(plain.residual <= 1e-10);
+    REQUIRE(trueResidual(a, b, x) < 1e-8);
+
+    // the workspace is reused, a converged initial guess needs no iteration
+    SolverStatistics again = cg.solve(a, b, x);
+    REQUIRE(again.converged);
+    REQUIRE(again.iterations <= 1);
+
+    std::fill(x.data(), x.data() + n, 0.0);
+    SolverStatistics jacobi = cg.solve(a, b, x, JacobiPreconditioner<double>(a));
+    REQUIRE(jacobi.converged);
+    REQUIRE(trueResidual(a, b, x) < 1e-8);
+
+    // ILU0 of a tridiagonal matrix is its exact LU factorization
+    std::fill(x.data(), x.data() + n, 0.0);
+    SolverStatistics ilu = cg.solve(a, b, x, ILU0<double>(a));
+    REQUIRE(ilu.converged);
+    REQUIRE(ilu.iterations <= 2);
+}
+
+TEST_CASE("Iterative solvers accept dense matrices and callables", "[Krylov]")
+{
+    const size_t n = 30;
+    Matrix<double> dense = poisson(n).toDense();
+    for (size_t i = 0; i < n; i++)
+        dense[i][i] += 0.5;
+    Vector<double> b = rightHandSide(n);
+
+    Vector<double> x(n);
+    std::fill(x.data(), x.data() + n, 0.0);
+    ConjugateGradient<double> cg;
+    REQUIRE(cg.solve(dense, b, x, JacobiPreconditioner<double>(dense)).converged);
+    REQUIRE(trueResidual(dense, b, x) < 1e-8);
+
+    // matrix-free: shifted second difference applied without storing a matrix
+    auto op = [n](const VectorView<double> &in, VectorView<double> &out)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            double v = 2.5 * in[i];
+            if (i > 0)
+                v -= in[i - 1];
+            if (i + 1 < n)
+                v -= in[i + 1];
+            out[i] = v;
+        }
+    };
+    Vector<double> y(n);
+    std::fill(y.data(), y.data() + n, 0.0);
+    GMRES<double> gmres;
+    REQUIRE(gmres.solve(op, b, y).converged);
+    REQUIRE(trueResidual(dense, b, y) < 1e-8);
+}
+
+TEST_CASE("BiCGSTAB and GMRES solve nonsymmetric systems", "[Krylov]")
+{
+    CsrMatrix<double> a = convectionDiffusion(20);
+    const size_t n = a.height();
+    Vector<double> b = rightHandSide(n);
+    ILU0<double> ilu(a);
+
+    BiCGSTAB<double> bicgstab({.tolerance = 1e-10, .maxIterations = 500});
+    Vector<double> x(n);
+    std::fill(x.data(), x.data() + n, 0.0);
+    SolverStatistics plain = bicgstab.solve(a, b, x);
+    REQUIRE(plain.converged);
+    REQUIRE(trueResidual(a, b, x) < 1e-8);
+
+    std::fill(x.data(), x.data() + n, 0.0);
+    SolverStatistics preconditioned = bicgstab.solve(a, b, x, ilu);
+    REQUIRE(preconditioned.converged);
+    REQUIRE(preconditioned.iterations < plain.iterations);
+    REQUIRE(trueResidual(a, b, x) < 1e-8);
+
+    // a short restart still converges, just more slowly
+    GMRES<double> gmres({.tolerance = 1e-10, .maxIterations = 2000, .restart = 10});
+    std::fill(x.data(), x.data() + n, 0.0);
+    SolverStatistics restarted = gmres.solve(a, b, x);
+    REQUIRE(restarted.converged);
+    REQUIRE(trueResidual(a, b, x) < 1e-8);
+
+    std::fill(x.data(), x.data() + n, 0.0);
+    SolverStatistics gmresIlu = gmres.solve(a, b, x, ilu);
+    REQUIRE(gmresIlu.converged);
+    REQUIRE(gmresIlu.iterations < restarted.iterations);
+    REQUIRE(trueResidual(a, b, x) < 1e-8);
+}
+
+TEST_CASE("Iterative solvers work on strided vectors", "[Krylov]")
+{
+    const size_t n = 50;
+    CsrMatrix<double> a = poisson(n);
+    Vector<double> b = rightHandSide(n);
+
+    // right-hand side in row 0, solution in row 1 of a 2 x n matrix
+    Matrix<double> storage(n, 2);
+    std::fill(storage.data(), storage.data() + 2 * n, 0.0);
+    storage.setRow(0, b);
+    VectorView<double> x = storage.row(1);
+    REQUIRE(ConjugateGradient<double>().solve(a, storage.row(0), x).converged);
+    REQUIRE(trueResidual(a, b, Vector<double>(storage.row(1))) < 1e-8);
+    REQUIRE(storage.row(0) == b);
+}
+
+TEST_CASE("Iterative solvers report failures", "[Krylov]")
+{
+    CsrMatrix<double> a = poisson(100);
+    Vector<double> b = rightHandSide(100);
+    Vector<double> x(100);
+    std::fill(x.data(), x.data() + 100, 0.0);
+
+    SolverStatistics capped = ConjugateGradient<double>({.tolerance = 1e-12, .maxIterations = 3}).solve(a, b, x);
+    REQUIRE_FALSE(capped.converged);
+    REQUIRE(capped.iterations == 3);
+    REQUIRE(capped.residual > 1e-12);
+
+    Vector<double> zero(100);
+    std::fill(zero.data(), zero.data() + 100, 0.0);
+    SolverStatistics trivial = BiCGSTAB<double>().solve(a, zero, x);
+    REQUIRE(trivial.converged);
+    REQUIRE(x.normInf() == 0.0);
+
+    Vector<double> wrong(99);
+    REQUIRE_THROWS_AS(GMRES<double>().solve(a, b, wrong), std::invalid_argument);
+    REQUIRE_THROWS_AS(GMRES<double>({.restart = 0}), std::invalid_argument);
+
+    // singular operator: GMRES stops at the breakdown and leaves x finite
+    Matrix<double> singular{
+        {0.0, 0.0},
+        {0.0, 0.0},
+    };
+    Vector<double> e0{1.0, 0.0};
+    Vector<double> guess{0.0, 0.0};
+    SolverStatistics stuck = GMRES<double>().solve(singular, e0, guess);
+    REQUIRE_FALSE(stuck.converged);
+    REQUIRE(stuck.residual == 1.0);
+    REQUIRE(guess == Vector<double>{0.0, 0.0});
+
+    // rank one: the first direction gives the least-squares fit, the second breaks down
+    Matrix<double> rankOne{
+        {1.0, 0.0},
+        {1.0, 0.0},
+    };
+    Vector<double> partial{0.0, 0.0};
+    SolverStatistics best = GMRES<double>().solve(rankOne, e0, partial);
+    REQUIRE_FALSE(best.converged);
+    REQUIRE(std::abs(partial[0] - 0.5) < 1e-12);
+    REQUIRE(partial[1] == 0.0);
+    REQUIRE(std::abs(best.residual - std::sqrt(0.5)) < 1e-12);
+
+    CooMatrix<double> missing(2, 2);
+    missing.add(0, 1, 1.0);
+    missing.add(1, 0, 1.0);
+    REQUIRE_THROWS_AS(ILU0<double>(CsrMatrix<double>(missing)), std::invalid_argument);
+    REQUIRE_THROWS_AS(JacobiPreconditioner<double>(CsrMatrix<double>(missing)), std::invalid_argument);
+}
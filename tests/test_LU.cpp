@@ -0,0 +1,152 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+
+#include "Matrix.hpp"
+
+using namespace m42;
+
+TEST_CASE("LU factorization reconstructs the matrix", "[LU]")
+{
+    // large enough for several blocked panels
+    const size_t n = 150;
+    Matrix<double> a(n, n);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            a[j][i] = std::sin(static_cast<double>(i * n + j)) + (i == j ? 4.0 : 0.0);
+
+    LU<double> lu = a.lu();
+    const Matrix<double> &packed = lu.packed();
+    Matrix<double> l(n, n);
+    Matrix<double> u(n, n);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+        {
+            l[j][i] = i > j ? packed[j][i] : (i == j ? 1.0 : 0.0);
+            u[j][i] = i <= j ? packed[j][i] : 0.0;
+        }
+
+    Matrix<double> permuted(a);
+    for (size_t i = 0; i < n; i++)
+    {
+        Vector<double> tmp = permuted.row(i);
+        permuted.setRow(i, permuted.row(lu.pivots()[i]));
+        permuted.setRow(lu.pivots()[i], tmp);
+    }
+    REQUIRE((l * u).isAprrox(permuted, 1e-10));
+    REQUIRE_FALSE(lu.isSingular());
+}
+
+TEST_CASE("Determinant from LU factorization", "[LU]")
+{
+    Matrix m{
+        {0.0, 2.0, 1.0},
+        {1.0, 0.0, 0.0},
+        {0.0, 0.0, 3.0},
+    };
+    LU<double> lu = m.lu();
+    REQUIRE(lu.determinant() == -6.0);
+    REQUIRE(lu.sign() == -1);
+    REQUIRE(std::abs(lu.logAbsDeterminant() - std::log(6.0)) < 1e-12);
+
+    Matrix<int> singular{
+        {1, 2},
+        {2, 4},
+    };
+    REQUIRE(singular.lu().isSingular());
+    REQUIRE(singular.lu().sign() == 0);
+    REQUIRE(singular.determinant() == 0);
+
+    // the determinant of a large diagonal matrix overflows, its logarithm does not
+    Matrix<double> big(400, 400);
+    for (size_t j = 0; j < 400; j++)
+        for (size_t i = 0; i < 400; i++)
+            big[j][i] = i == j ? 1e10 : 0.0;
+    REQUIRE(std::isinf(big.determinant()));
+    REQUIRE(std::abs(big.lu().logAbsDeterminant() - 400 * std::log(1e10)) < 1e-9);
+
+    // 0 * NaN is NaN, a zero above the diagonal does not skip its column
+    Matrix<double> poisoned{
+        {1.0, 0.0},
+        {std::numeric_limits<double>::quiet_NaN(), 1.0},
+    };
+    REQUIRE(std::isnan(poisoned.lu().determinant()));
+
+    REQUIRE_THROWS_AS(Matrix<double>(2, 3).lu(), std::invalid_argument);
+}
+
+TEST_CASE("Inverse from LU factorization", "[LU]")
+{
+    // large enough for several blocked triangular solves
+    const size_t n = 200;
+    Matrix<double> a(n, n);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            a[j][i] = std::cos(static_cast<double>(3 * i + 7 * j)) + (i == j ? 5.0 : 0.0);
+
+    Matrix<double> identity(n, n);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            identity[j][i] = i == j ? 1.0 : 0.0;
+
+    Matrix<double> inverse = a.lu().inverse();
+    REQUIRE((a * inverse).isAprrox(identity, 1e-10));
+    REQUIRE((inverse * a).isAprrox(identity, 1e-10));
+
+    Matrix<int> integral{
+        {2, 0},
+        {0, 1},
+    };
+    REQUIRE(integral.lu().inverse() == Matrix{
+        {0.5, 0.0},
+        {0.0, 1.0},
+    });
+    REQUIRE_THROWS_AS(Matrix<int>({{1, 2}, {2, 4}}).lu().inverse(), std::invalid_argument);
+}
+
+TEST_CASE("Reuse LU factorization for many right-hand sides", "[LU]")
+{
+    const size_t n = 180;
+    Matrix<double> a(n, n);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            a[j][i] = std::sin(static_cast<double>(5 * i + j)) + (i == j ? 6.0 : 0.0);
+    LU<double> lu = a.lu();
+
+    Vector<double> b(n);
+    for (int step = 0; step < 20; step++)
+    {
+        for (size_t i = 0; i < n; i++)
+            b[i] = std::cos(static_cast<double>(step * n + i));
+        Vector<double> x(b);
+        const double *storage = x.data();
+        lu.solveInPlace(x);
+        REQUIRE(x.data() == storage);
+        REQUIRE((a * x).isApprox(b, 1e-10));
+        REQUIRE(lu.solve(b).isApprox(x, 1e-14));
+    }
+
+    Matrix<double> rhs(70, n);
+    for (size_t j = 0; j < 70; j++)
+        for (size_t i = 0; i < n; i++)
+            rhs[j][i] = static_cast<double>((i * 31 + j * 17) % 11) - 5.0;
+    Matrix<double> x = lu.solve(rhs);
+    REQUIRE((a * x).isAprrox(rhs, 1e-10));
+    REQUIRE(x[42].isApprox(lu.solve(rhs[42]), 1e-12));
+
+    // a column and a block of a larger matrix are solved where they live
+    Matrix<double> storage(71, n + 3);
+    storage.block(1, 3, 70, n) = rhs;
+    lu.solveInPlace(storage.block(1, 3, 70, n));
+    REQUIRE(Matrix<double>(storage.block(1, 3, 70, n)).isAprrox(x, 1e-12));
+    Matrix<double> columns(rhs);
+    lu.solveInPlace(columns[42]);
+    REQUIRE(columns[42].isApprox(x[42], 1e-12));
+
+    Matrix<double> singular(2, 2);
+    for (size_t j = 0; j < 2; j++)
+        for (size_t i = 0; i < 2; i++)
+            singular[j][i] = 1.0;
+    REQUIRE_THROWS_AS(singular.lu().solve(Vector({1.0, 1.0})), std::invalid_argument);
+    REQUIRE_THROWS_AS(lu.solve(Vector({1.0, 1.0})), std::invalid_argument);
+}
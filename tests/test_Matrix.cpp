@@ -1,4 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
 
 #include "Matrix.hpp"
 
@@ -388,6 +392,84 @@ TEST_CASE("Matrix subtraction assignment", "[Matrix]")
     }, 3, 2));
 }
 
+TEST_CASE("Fused matrix expression", "[Matrix]")
+{
+    Matrix<int> a{
+        {1, 2},
+        {3, 4},
+    };
+    Matrix<int> b{
+        {5, 6},
+        {7, 8},
+    };
+    Matrix<int> result(2, 2);
+    const int *data = result.data();
+
+    result = a * 3 - b + a;
+    REQUIRE(result.data() == data);
+    REQUIRE(result == Matrix<int>{
+        {-1, 2},
+        {5, 8},
+    });
+
+    result = -(result - a);
+    REQUIRE(result == Matrix<int>{
+        {2, 0},
+        {-2, -4},
+    });
+
+    Matrix<int> reshaped = Matrix<int>(4, 1);
+    reshaped = a + b;
+    REQUIRE(reshaped.width() == 2);
+    REQUIRE(reshaped.height() == 2);
+    REQUIRE((a + b) * Vector{1, 1} == Vector{14, 22});
+    REQUIRE_THROWS_AS(a + Matrix<int>(2, 1), std::invalid_argument);
+}
+
+TEST_CASE("Print and evaluate a matrix expression", "[Matrix]")
+{
+    Matrix<int> a{
+        {1, 2},
+        {3, 4},
+    };
+
+    std::ostringstream os;
+    os << a + a;
+    REQUIRE(os.str() == "[2 4\n 6 8]");
+    REQUIRE(static_cast<std::string>(-a) == "[-1 -2\n -3 -4]");
+    REQUIRE(format_as(a - a) == "[0 0\n 0 0]");
+
+    Matrix<int> doubled = (a + a).eval();
+    REQUIRE(doubled == a * 2);
+    REQUIRE((a + a).eval().transpose() == Matrix<int>{
+        {2, 6},
+        {4, 8},
+    });
+}
+
+TEST_CASE("Matrix compound assignment works in place", "[Matrix]")
+{
+    Matrix<double> m1{
+        {1.0, 2.0},
+        {3.0, 4.0},
+    };
+    Matrix<double> m2{
+        {0.5, 0.5},
+        {1.0, 1.0},
+    };
+    const double *data = m1.data();
+
+    m1 += m2 * 2.0;
+    m1 -= m2;
+    m1 *= 2.0;
+    REQUIRE(m1.data() == data);
+    REQUIRE(m1 == Matrix<double>{
+        {3.0, 5.0},
+        {8.0, 10.0},
+    });
+    REQUIRE_THROWS_AS(m1 += Matrix<double>(1, 2), std::invalid_argument);
+}
+
 TEST_CASE("Multiply matrix by scalar", "[Matrix]")
 {
     Matrix<int> m1({
@@ -453,6 +535,42 @@ TEST_CASE("Matrix vector multiplication", "[Matrix]")
     };
     Vector v3{4, 2};
     REQUIRE(m3 * v3 == Vector{4, -4});
+
+    // 0 * inf is NaN, a zero element of the vector does not skip its column
+    Matrix<double> infinite{
+        {1.0, std::numeric_limits<double>::infinity()},
+        {2.0, 0.0},
+    };
+    Vector<double> product = infinite * Vector<double>{1.0, 0.0};
+    REQUIRE(std::isnan(product[0]));
+    REQUIRE(product[1] == 2.0);
+}
+
+TEST_CASE("Vector matrix multiplication", "[Matrix]")
+{
+    Matrix m{
+        {1, 2, 3},
+        {4, 5, 6},
+    };
+    REQUIRE(Vector{1, 1} * m == Vector{5, 7, 9});
+    REQUIRE(Vector{2, -1} * m == m.transpose() * Vector{2, -1});
+    REQUIRE(m.row(0) * m.transpose() == Vector{14, 32});
+    REQUIRE_THROWS_AS((Vector{1, 2, 3} * m), std::invalid_argument);
+
+    Matrix<long> big(67, 45);
+    Vector<long> x(67);
+    Vector<long> y(45);
+    for (size_t i = 0; i < 67 * 45; i++)
+        big.data()[i] = static_cast<long>(i % 19) - 9;
+    for (size_t i = 0; i < 67; i++)
+        x[i] = static_cast<long>(i % 5) - 2;
+    for (size_t i = 0; i < 45; i++)
+        y[i] = static_cast<long>(i % 3) - 1;
+    Vector<long> expected(45);
+    for (size_t i = 0; i < 45; i++)
+        expected[i] = big.row(i) * x;
+    REQUIRE(big * x == expected);
+    REQUIRE(y * big == big.transpose() * y);
 }
 
 TEST_CASE("Matrix matrix multiplication", "[Matrix]")
@@ -497,6 +615,37 @@ TEST_CASE("Matrix matrix multiplication", "[Matrix]")
     });
 }
 
+TEST_CASE("Large matrix matrix multiplication", "[Matrix]")
+{
+    // sizes straddle the register tile and cache block edges
+    const size_t m = 141, k = 263, n = 37;
+    Matrix<long> a(k, m);
+    Matrix<long> b(n, k);
+    for (size_t i = 0; i < a.width() * a.height(); i++)
+        a.data()[i] = static_cast<long>(i % 17) - 8;
+    for (size_t i = 0; i < b.width() * b.height(); i++)
+        b.data()[i] = static_cast<long>(i % 13) - 6;
+
+    Matrix<long> expected(n, m);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < m; i++)
+        {
+            long sum = 0;
+            for (size_t p = 0; p < k; p++)
+                sum += a[p][i] * b[j][p];
+            expected[j][i] = sum;
+        }
+    REQUIRE(a * b == expected);
+
+    Matrix<double> product = Matrix<double>(4, 3) * Matrix<double>(0, 4);
+    REQUIRE(product.width() == 0);
+    REQUIRE(product.height() == 3);
+    REQUIRE((Matrix<double>(0, 2) * Matrix<double>(2, 0)) == Matrix<double>{
+        {0.0, 0.0},
+        {0.0, 0.0},
+    });
+}
+
 TEST_CASE("Trace of a matrix", "[Matrix]")
 {
     Matrix m{
@@ -533,6 +682,42 @@ TEST_CASE("Transpose matrix", "[Matrix]")
     });
 }
 
+TEST_CASE("Transpose large matrices", "[Matrix]")
+{
+    // sizes that are not multiples of the tile exercise the borders
+    for (size_t n : {size_t(1), size_t(7), size_t(64), size_t(203)})
+        for (size_t m : {size_t(1), size_t(5), size_t(64), size_t(150)})
+        {
+            Matrix<double> a(n, m);
+            for (size_t j = 0; j < n; j++)
+                for (size_t i = 0; i < m; i++)
+                    a[j][i] = static_cast<double>(i * 1000 + j);
+
+            Matrix<double> t = a.transpose();
+            REQUIRE(t.width() == m);
+            REQUIRE(t.height() == n);
+            bool matches = true;
+            for (size_t j = 0; j < n; j++)
+                for (size_t i = 0; i < m; i++)
+                    matches = matches && t[i][j] == a[j][i];
+            REQUIRE(matches);
+
+            Matrix<double> inPlace(a);
+            const double *storage = inPlace.data();
+            inPlace.transposeInPlace();
+            REQUIRE(inPlace.data() == storage);
+            REQUIRE(inPlace == t);
+        }
+
+    Matrix<float> square(100, 100);
+    for (size_t j = 0; j < 100; j++)
+        for (size_t i = 0; i < 100; i++)
+            square[j][i] = static_cast<float>(i * 100 + j);
+    Matrix<float> expected = square.transpose();
+    square.transposeInPlace();
+    REQUIRE(square == expected);
+}
+
 TEST_CASE("Set row of a matrix", "[Matrix]")
 {
     Matrix m{
@@ -633,6 +818,40 @@ TEST_CASE("Calculate determinant of a matrix", "[Matrix]")
         {28.0, -4.0,  17.0, 1.0},
     };
     REQUIRE(m4.determinant() == 1032);
+
+    // integer determinants stay exact beyond the 53 bits of a double
+    Matrix<long long> large{
+        {94906267, 1},
+        {0, 94906267},
+    };
+    REQUIRE(large.determinant() == 9007199515875289LL);
+    // a zero leading element needs a row interchange
+    Matrix pivoted{
+        {0, 2, 1},
+        {3, 0, 0},
+        {0, 1, 5},
+    };
+    REQUIRE(pivoted.determinant() == -27);
+
+    // 64-bit elements are eliminated in 128 bits, unsigned results wrap
+    Matrix<unsigned long> wrapping{
+        {2, 1, 1},
+        {1, 3, 2},
+        {1, 0, 0},
+    };
+    REQUIRE(wrapping.determinant() == std::numeric_limits<unsigned long>::max());
+    const long long huge = 1LL << 62;
+    Matrix<long long> wide{
+        {huge, 1},
+        {1, huge},
+    };
+    REQUIRE_THROWS_AS(wide.determinant(), std::overflow_error);
+    Matrix<long long> overflowing{
+        {huge, 1, 3},
+        {1, huge, 5},
+        {7, 2, huge},
+    };
+    REQUIRE_THROWS_AS(overflowing.determinant(), std::overflow_error);
 }
 
 TEST_CASE("Inverse of a matrix", "[Matrix]")
@@ -669,6 +888,98 @@ TEST_CASE("Inverse of a matrix", "[Matrix]")
         {-0.781609195, -0.126436782,  0.965517241},
         { 0.143678161,  0.074712644, -0.206896552},
     }, 1e-9));
+
+    Matrix<double> result(3, 3);
+    const double *storage = result.data();
+    m3.inverse(result);
+    REQUIRE(result.data() == storage);
+    REQUIRE(result.isAprrox(m3.inverse(), 1e-12));
+
+    Matrix<double> wrongSize(2, 2);
+    m2.inverse(wrongSize);
+    REQUIRE(wrongSize.width() == 3);
+    REQUIRE(wrongSize.height() == 3);
+
+    Matrix<double> singular{
+        {1.0, 2.0},
+        {2.0, 4.0},
+    };
+    REQUIRE_THROWS_AS(singular.inverse(), std::invalid_argument);
+
+    // unimodular, the inverse is an integer matrix the LU only approximates
+    Matrix<int> lower{
+        {1, 0, 0, 0},
+        {2, 1, 0, 0},
+        {-1, 3, 1, 0},
+        {4, -2, 5, 1},
+    };
+    Matrix<int> upper{
+        {1, 2, -1, 3},
+        {0, 1, 4, -2},
+        {0, 0, 1, 5},
+        {0, 0, 0, 1},
+    };
+    Matrix<int> unimodular = lower * upper;
+    Matrix<int> identity{
+        {1, 0, 0, 0},
+        {0, 1, 0, 0},
+        {0, 0, 1, 0},
+        {0, 0, 0, 1},
+    };
+    REQUIRE(unimodular * unimodular.inverse() == identity);
+    REQUIRE(unimodular.inverse() * unimodular == identity);
+}
+
+TEST_CASE("Solve linear systems", "[Matrix]")
+{
+    Matrix m{
+        {8.0, 5.0, -2.0},
+        {4.0, 7.0,  20.0},
+        {7.0, 6.0,  1.0},
+    };
+    Vector b{1.0, 2.0, 3.0};
+    Vector x = m.solve(b);
+    REQUIRE((m * x).isApprox(b, 1e-12));
+
+    Matrix rhs{
+        {1.0, 0.0},
+        {2.0, 1.0},
+        {3.0, -1.0},
+    };
+    Matrix xs = m.solve(rhs);
+    REQUIRE(xs.width() == 2);
+    REQUIRE((m * xs).isAprrox(rhs, 1e-12));
+
+    Matrix<int> integral{
+        {2, 0},
+        {0, 4},
+    };
+    REQUIRE(integral.solve(Vector{4, 8}) == Vector{2, 2});
+    // the double solution is only close to the integer one
+    Matrix<int> coupled{
+        {3, 7, -2, 5, 1},
+        {-4, 2, 6, 1, -3},
+        {5, -1, 3, -6, 2},
+        {2, 8, -5, 3, 7},
+        {-6, 4, 1, 2, -5},
+    };
+    Vector<int> expected{3, -2, 5, -7, 4};
+    REQUIRE(coupled.solve(coupled * expected) == expected);
+    Matrix<int> columns(2, 5);
+    for (size_t i = 0; i < 5; i++)
+    {
+        columns[0][i] = expected[i];
+        columns[1][i] = 2 * expected[i];
+    }
+    Matrix<int> solutions = coupled.solve(coupled * columns);
+    REQUIRE(solutions == columns);
+    // a block of a larger matrix is solved without copying it out first
+    Matrix<int> padded(3, 7);
+    padded.block(1, 2, 2, 5) = coupled * columns;
+    REQUIRE(coupled.solve(padded.block(1, 2, 2, 5)) == columns);
+
+    REQUIRE_THROWS_AS(m.solve(Vector({1.0, 2.0})), std::invalid_argument);
+    REQUIRE_THROWS_AS(Matrix<double>(2, 3).solve(Vector({1.0, 2.0})), std::invalid_argument);
 }
 
 TEST_CASE("Rank of a matrix", "[Matrix]")
@@ -694,4 +1005,50 @@ TEST_CASE("Rank of a matrix", "[Matrix]")
         {21.0, 18.0, 7.0},
     };
     REQUIRE(m3.rank() == 3);
+
+    // third row is the sum of the first two up to noise
+    Matrix noisy{
+        {1.0, 2.0, 3.0},
+        {4.0, 5.0, 6.0},
+        {5.0, 7.0, 9.0 + 1e-10},
+    };
+    REQUIRE(noisy.rank() == 3);
+    REQUIRE(noisy.rank(1e-8) == 2);
+    REQUIRE(noisy.rank(1e-8, true) == 2);
+    Matrix zero{
+        {0.0, 0.0},
+        {0.0, 0.0},
+    };
+    REQUIRE(zero.rank() == 0);
+
+    Matrix<int> integral{
+        {2, 4, 6},
+        {1, 2, 3},
+    };
+    REQUIRE(integral.rank() == 1);
+    REQUIRE(integral.rank(0.0, true) == 1);
+}
+
+TEST_CASE("Row echelon form in place", "[Matrix]")
+{
+    Matrix m{
+        {8.0, 5.0, -2.0,  4.0,  28.0},
+        {4.0, 2.5,  20.0, 4.0, -4.0},
+        {8.0, 5.0,  1.0,  4.0,  17.0},
+    };
+    Matrix<double> expected = m.rowEchelon();
+    const double *storage = m.data();
+    REQUIRE(m.rowEchelonInPlace() == 3);
+    REQUIRE(m.data() == storage);
+    REQUIRE(m == expected);
+
+    Matrix nearlySingular{
+        {1.0, 2.0},
+        {2.0, 4.0 + 1e-12},
+    };
+    REQUIRE(nearlySingular.rowEchelonInPlace(1e-9) == 1);
+    REQUIRE(nearlySingular.isAprrox(Matrix{
+        {1.0, 2.0},
+        {0.0, 1e-12},
+    }, 1e-9));
 }
@@ -0,0 +1,169 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <sstream>
+
+#include "Matrix.hpp"
+#include "fixtures.hpp"
+
+using namespace m42;
+
+TEST_CASE("MatrixView block refers to the memory of the matrix", "[MatrixView]")
+{
+    Matrix<int> m{
+        {1, 2, 3, 4},
+        {5, 6, 7, 8},
+        {9, 10, 11, 12},
+    };
+    MatrixView<int> block = m.block(1, 1, 2, 2);
+    REQUIRE(block.width() == 2);
+    REQUIRE(block.height() == 2);
+    REQUIRE(block.stride() == 3);
+    REQUIRE_FALSE(block.isContiguous());
+    REQUIRE(block == Matrix<int>{{6, 7}, {10, 11}});
+    REQUIRE(block.trace() == 17);
+    REQUIRE(block.row(1) == Vector<int>{10, 11});
+
+    block[0][0] = 0;
+    block.setRow(1, Vector<int>{-1, -2});
+    REQUIRE(m == Matrix<int>{{1, 2, 3, 4}, {5, 0, 7, 8}, {9, -1, -2, 12}});
+
+    // blocks of blocks keep the stride of the matrix
+    MatrixView<int> inner = block.block(1, 0, 1, 2);
+    REQUIRE(inner.stride() == 3);
+    inner *= 10;
+    REQUIRE(m == Matrix<int>{{1, 2, 3, 4}, {5, 0, 70, 8}, {9, -1, -20, 12}});
+}
+
+TEST_CASE("MatrixView compound assignment", "[MatrixView]")
+{
+    Matrix<int> m{
+        {1, 2, 3},
+        {4, 5, 6},
+        {7, 8, 9},
+    };
+    Matrix<int> ones{{1, 1}, {1, 1}};
+    m.block(0, 1, 2, 2) += ones;
+    REQUIRE(m == Matrix<int>{{1, 2, 3}, {5, 6, 6}, {8, 9, 9}});
+    m.block(0, 2, 3, 1) -= m.block(0, 0, 3, 1);
+    REQUIRE(m == Matrix<int>{{1, 2, 3}, {5, 6, 6}, {7, 7, 6}});
+    m.block(0, 2, 3, 1) = m.block(0, 1, 3, 1);
+    REQUIRE(m == Matrix<int>{{1, 2, 3}, {5, 6, 6}, {5, 6, 6}});
+    REQUIRE_THROWS_AS(m.block(0, 0, 2, 2) += m, std::invalid_argument);
+}
+
+TEST_CASE("MatrixView blocks take part in element-wise expressions", "[MatrixView]")
+{
+    Matrix<int> m{
+        {1, 2, 3},
+        {4, 5, 6},
+        {7, 8, 9},
+    };
+    const MatrixView<int> top = m.block(0, 0, 2, 2);
+    const MatrixView<int> bottom = m.block(1, 1, 2, 2);
+    REQUIRE(Matrix<int>(top + bottom) == Matrix<int>{{6, 8}, {12, 14}});
+    REQUIRE(Matrix<int>(bottom - top * 2) == Matrix<int>{{3, 2}, {0, -1}});
+    REQUIRE(Matrix<int>(-top + m.block(0, 1, 2, 2)) == Matrix<int>{{3, 3}, {3, 3}});
+    REQUIRE_THROWS_AS(top + m, std::invalid_argument);
+
+    // a block mixed with a padded matrix, evaluated into another block
+    Matrix<double> a = numbered(9, 7);
+    Matrix<double> padded(a.block(2, 1, 5, 4), Padding::Aligned);
+    Matrix<double> doubled = a.block(2, 1, 5, 4) + padded;
+    REQUIRE(doubled == Matrix<double>(padded * 2.0));
+    a.block(0, 0, 5, 4) = padded * 2.0;
+    REQUIRE(a.block(0, 0, 5, 4) == doubled);
+}
+
+TEST_CASE("MatrixView products match products of copies", "[MatrixView]")
+{
+    Matrix<double> a = numbered(90, 70);
+    Matrix<double> b = numbered(80, 60);
+    const MatrixView<double> left = a.block(5, 3, 40, 50);
+    const MatrixView<double> right = b.block(7, 11, 30, 40);
+    Matrix<double> leftCopy(left);
+    Matrix<double> rightCopy(right);
+    REQUIRE(leftCopy.isContiguous());
+    REQUIRE((left * right).isAprrox(leftCopy * rightCopy, 1e-12));
+
+    Vector<double> x(40);
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = std::cos(static_cast<double>(i));
+    REQUIRE((left * x).isApprox(leftCopy * x, 1e-12));
+    Vector<double> y(50);
+    for (size_t i = 0; i < y.size(); i++)
+        y[i] = std::cos(static_cast<double>(i * i));
+    REQUIRE((y * left).isApprox(y * leftCopy, 1e-12));
+    REQUIRE_THROWS_AS(left * left, std::invalid_argument);
+
+    // multiply() writes into existing storage, here a row of another matrix
+    Matrix<double> rows(50, 2);
+    VectorView<double> target = rows.row(1);
+    left.multiply(x, target);
+    REQUIRE(Vector<double>(rows.row(1)).isApprox(leftCopy * x, 1e-12));
+    REQUIRE_THROWS_AS(left.multiply(y, target), std::invalid_argument);
+}
+
+TEST_CASE("MatrixView multiply into its own operand", "[MatrixView]")
+{
+    Matrix<double> a{
+        {1, 2},
+        {3, 4},
+    };
+    Vector<double> v{1, 1};
+    a.multiply(v, v);
+    REQUIRE(v == Vector<double>{3, 7});
+
+    // a result overlapping the end of the operand
+    Vector<double> storage{1, 1, 0};
+    VectorView<double> x(storage.data(), 2);
+    VectorView<double> y(storage.data() + 1, 2);
+    a.multiply(x, y);
+    REQUIRE(storage == Vector<double>{1, 3, 7});
+}
+
+TEST_CASE("MatrixView transpose", "[MatrixView]")
+{
+    Matrix<double> a = numbered(50, 40);
+    const MatrixView<double> block = a.block(10, 5, 30, 20);
+    Matrix<double> transposed = block.transpose();
+    REQUIRE(transposed.width() == 20);
+    REQUIRE(transposed.height() == 30);
+    REQUIRE(transposed == Matrix<double>(block).transpose());
+}
+
+TEST_CASE("MatrixView factorizations", "[MatrixView]")
+{
+    const size_t n = 100;
+    Matrix<double> a(n + 20, n + 10);
+    for (size_t j = 0; j < a.width(); j++)
+        for (size_t i = 0; i < a.height(); i++)
+            a[j][i] = 1.0 / (1.0 + std::abs(static_cast<double>(i) - static_cast<double>(j))) + (i == j ? n : 0.0);
+    // the diagonal block is symmetric positive definite
+    const MatrixView<double> block = a.block(7, 7, n, n);
+    Matrix<double> copy(block);
+
+    REQUIRE(LU<double>(block).determinant() == LU<double>(copy).determinant());
+    REQUIRE(Cholesky<double>(block).packed() == copy.cholesky().packed());
+    REQUIRE(QR<double>(a.block(0, 0, n, n + 10)).packed() == Matrix<double>(a.block(0, 0, n, n + 10)).qr().packed());
+}
+
+TEST_CASE("MatrixView printing", "[MatrixView]")
+{
+    Matrix<int> m{
+        {1, 2, 3},
+        {4, 5, 6},
+    };
+    std::ostringstream os;
+    os << m.block(1, 0, 2, 2);
+    REQUIRE(os.str() == "[2 3\n 5 6]");
+}
+
+TEST_CASE("MatrixView range checks", "[MatrixView]")
+{
+    Matrix<int> m(4, 3);
+    REQUIRE_THROWS_AS(m.block(3, 0, 2, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(m.block(0, 2, 1, 2), std::out_of_range);
+    REQUIRE_NOTHROW(m.block(4, 3, 0, 0));
+    int data[6] = {};
+    REQUIRE_THROWS_AS(MatrixView<int>(data, 2, 3, 2), std::invalid_argument);
+}
@@ -0,0 +1,139 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "PackedMatrix.hpp"
+#include "fixtures.hpp"
+
+using namespace m42;
+
+TEST_CASE("SymmetricMatrix stores one triangle", "[PackedMatrix]")
+{
+    Matrix<int> dense{
+        {1, 2, 3},
+        {2, 4, 5},
+        {3, 5, 6},
+    };
+    SymmetricMatrix<int> s(dense);
+    REQUIRE(s.size() == 3);
+    REQUIRE(std::vector<int>(s.data(), s.data() + 6) == std::vector<int>{1, 2, 3, 4, 5, 6});
+    REQUIRE(s.toDense() == dense);
+    REQUIRE(s(0, 2) == 3);
+    REQUIRE(s(2, 0) == 3);
+
+    s(2, 1) = -5;
+    REQUIRE(s(1, 2) == -5);
+    REQUIRE_THROWS_AS(s(3, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(SymmetricMatrix<int>(Matrix<int>(2, 3)), std::invalid_argument);
+}
+
+TEST_CASE("SymmetricMatrix product and rank update", "[PackedMatrix]")
+{
+    const size_t n = 45;
+    Matrix<double> a = numbered(n, n);
+    Matrix<double> symmetric = a + a.transpose();
+    SymmetricMatrix<double> s(symmetric);
+    Vector<double> x = numberedVector(n);
+    REQUIRE((s * x).isApprox(symmetric * x, 1e-12));
+
+    // strided operand and result
+    Matrix<double> rows(n, 2);
+    rows.setRow(0, x);
+    VectorView<double> y = rows.row(1);
+    s.multiply(rows.row(0), y);
+    REQUIRE(Vector<double>(rows.row(1)).isApprox(symmetric * x, 1e-12));
+
+    // accumulate the covariance of a few samples
+    SymmetricMatrix<double> covariance(n);
+    Matrix<double> expected(n, n);
+    std::fill(expected.data(), expected.data() + n * n, 0.0);
+    for (size_t k = 0; k < 4; k++)
+    {
+        Vector<double> sample = a[k];
+        covariance.rankUpdate(0.25, sample);
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < n; i++)
+                expected[j][i] += 0.25 * sample[i] * sample[j];
+    }
+    REQUIRE(covariance.toDense().isAprrox(expected, 1e-12));
+}
+
+TEST_CASE("TriangularMatrix products and solves", "[PackedMatrix]")
+{
+    const size_t n = 40;
+    Matrix<double> a = numbered(n, n);
+    for (size_t i = 0; i < n; i++)
+        a[i][i] += 4.0;
+    Vector<double> x = numberedVector(n);
+
+    for (Triangle triangle : {Triangle::Lower, Triangle::Upper})
+    {
+        TriangularMatrix<double> t(a, triangle);
+        REQUIRE(t.triangle() == triangle);
+        Matrix<double> dense = t.toDense();
+        Matrix<double> expected(a);
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < n; i++)
+                if (triangle == Triangle::Lower ? i < j : i > j)
+                    expected[j][i] = 0.0;
+        REQUIRE(dense == expected);
+
+        Vector<double> b = t * x;
+        REQUIRE(b.isApprox(dense * x, 1e-12));
+        REQUIRE(t.solve(b).isApprox(x, 1e-10));
+
+        // several right-hand sides in a block of a larger matrix
+        Matrix<double> storage(4, n + 3);
+        MatrixView<double> block = storage.block(1, 3, 3, n);
+        for (size_t j = 0; j < 3; j++)
+            for (size_t i = 0; i < n; i++)
+                block[j][i] = b[i] * static_cast<double>(j + 1);
+        t.solveInPlace(block);
+        REQUIRE(Vector<double>(block[2]).isApprox(x * 3.0, 1e-10));
+
+        // a row of a matrix as a strided right-hand side
+        Matrix<double> rows(n, 2);
+        rows.setRow(1, b);
+        t.solveInPlace(rows.row(1));
+        REQUIRE(Vector<double>(rows.row(1)).isApprox(x, 1e-10));
+    }
+}
+
+TEST_CASE("Packed multiply into its own operand", "[PackedMatrix]")
+{
+    Matrix<double> dense{
+        {1, 2},
+        {2, 3},
+    };
+    Vector<double> v{1, 1};
+    SymmetricMatrix<double>(dense).multiply(v, v);
+    REQUIRE(v == Vector<double>{3, 5});
+
+    Vector<double> w{1, 1};
+    TriangularMatrix<double>(dense, Triangle::Lower).multiply(w, w);
+    REQUIRE(w == Vector<double>{1, 5});
+}
+
+TEST_CASE("TriangularMatrix element access and errors", "[PackedMatrix]")
+{
+    TriangularMatrix<double> lower(3, Triangle::Lower);
+    lower(0, 0) = 1;
+    lower(0, 2) = 2;
+    lower(2, 2) = 3;
+    const TriangularMatrix<double> &constant = lower;
+    REQUIRE(constant(2, 0) == 0);
+    REQUIRE(constant(0, 2) == 2);
+    REQUIRE_THROWS_AS(lower(2, 0) = 1, std::out_of_range);
+    REQUIRE_THROWS_AS(constant(3, 0), std::out_of_range);
+
+    // the middle diagonal element is still zero
+    REQUIRE_THROWS_AS(lower.solve(Vector<double>{1, 2, 3}), std::invalid_argument);
+    lower(1, 1) = 1;
+    REQUIRE(lower.solve(Vector<double>{1, 2, 8}) == Vector<double>{1, 2, 2});
+    REQUIRE_THROWS_AS(lower.solve(Vector<double>{1, 2}), std::invalid_argument);
+
+    // 0 * inf is NaN, a zero element of x does not skip its column
+    lower(0, 2) = std::numeric_limits<double>::infinity();
+    REQUIRE(std::isnan((lower * Vector<double>{0, 1, 1})[2]));
+}
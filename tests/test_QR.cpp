@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+#include "Matrix.hpp"
+
+using namespace m42;
+
+TEST_CASE("QR factorization reconstructs the matrix", "[QR]")
+{
+    // several WY blocks and a partial last block
+    const size_t m = 300;
+    const size_t n = 110;
+    Matrix<double> a(n, m);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < m; i++)
+            a[j][i] = std::sin(static_cast<double>(i * j + i + j * j));
+
+    QR<double> qr = a.qr();
+    Matrix<double> q = qr.q();
+    Matrix<double> r = qr.r();
+    REQUIRE(q.width() == n);
+    REQUIRE(q.height() == m);
+    REQUIRE((q * r).isAprrox(a, 1e-10));
+
+    Matrix<double> identity(n, n);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            identity[j][i] = i == j ? 1.0 : 0.0;
+    REQUIRE((q.transpose() * q).isAprrox(identity, 1e-10));
+
+    bool upper = true;
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = j + 1; i < n; i++)
+            upper = upper && r[j][i] == 0.0;
+    REQUIRE(upper);
+}
+
+TEST_CASE("Least-squares solve", "[QR]")
+{
+    // fit y = 2 + 3x exactly, then with symmetric noise around the line
+    Matrix design{
+        {1.0, 0.0},
+        {1.0, 1.0},
+        {1.0, 2.0},
+        {1.0, 3.0},
+    };
+    Vector exact{2.0, 5.0, 8.0, 11.0};
+    REQUIRE(design.lstsq(exact).isApprox(Vector{2.0, 3.0}, 1e-12));
+    Vector noisy{2.5, 4.5, 7.5, 11.5};
+    REQUIRE(design.lstsq(noisy).isApprox(Vector{2.0, 3.0}, 1e-12));
+    Matrix<int> integral{
+        {3, 1},
+        {1, 7},
+        {2, 5},
+        {7, 3},
+    };
+    REQUIRE(integral.lstsq(integral * Vector{3, -4}) == Vector{3, -4});
+
+    // the residual of the solution is orthogonal to the columns
+    const size_t m = 500;
+    const size_t n = 40;
+    Matrix<double> a(n, m);
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < m; i++)
+            a[j][i] = std::cos(static_cast<double>(i * j + i + j * j));
+    Vector<double> b(m);
+    for (size_t i = 0; i < m; i++)
+        b[i] = std::sin(static_cast<double>(i));
+    QR<double> qr = a.qr();
+    Vector<double> x = qr.lstsq(b);
+    Vector<double> residual = b - a * x;
+    REQUIRE((residual * a).normInf() < 1e-9);
+
+    Matrix<double> rhs(3, m);
+    for (size_t j = 0; j < 3; j++)
+        rhs[j] = b * static_cast<double>(j + 1);
+    Matrix<double> xs = qr.lstsq(rhs);
+    REQUIRE(xs[2].isApprox(x * 3.0, 1e-10));
+    Matrix<double> padded(4, m + 2);
+    padded.block(1, 2, 3, m) = rhs;
+    REQUIRE(qr.lstsq(padded.block(1, 2, 3, m)).isAprrox(xs, 1e-12));
+}
+
+TEST_CASE("QR factorization of invalid matrices", "[QR]")
+{
+    REQUIRE_THROWS_AS(Matrix<double>(3, 2).qr(), std::invalid_argument);
+
+    Matrix dependent{
+        {1.0, 2.0},
+        {2.0, 4.0},
+        {3.0, 6.0},
+    };
+    REQUIRE_FALSE(dependent.qr().isFullRank());
+    REQUIRE_THROWS_AS(dependent.lstsq(Vector({1.0, 2.0, 3.0})), std::invalid_argument);
+    REQUIRE_THROWS_AS(Matrix<double>(2, 3).lstsq(Vector({1.0, 2.0})), std::invalid_argument);
+}
@@ -0,0 +1,203 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "SparseMatrix.hpp"
+
+using namespace m42;
+
+/**
+ * @brief Build a dense matrix with roughly one element in three set
+ */
+static Matrix<double> sparseNumbered(size_t width, size_t height)
+{
+    Matrix<double> a(width, height);
+    for (size_t j = 0; j < width; j++)
+        for (size_t i = 0; i < height; i++)
+            a[j][i] = (i * 7 + j * 3) % 3 == 0 ? std::sin(static_cast<double>(i * j + i + j * j + 1)) : 0.0;
+    return a;
+}
+
+/**
+ * @brief Check two dense matrices agree up to rounding
+ */
+static bool near(const MatrixView<double> &a, const MatrixView<double> &b)
+{
+    if (a.width() != b.width() || a.height() != b.height())
+        return false;
+    for (size_t j = 0; j < a.width(); j++)
+        for (size_t i = 0; i < a.height(); i++)
+            if (std::abs(a[j][i] - b[j][i]) > 1e-12)
+                return false;
+    return true;
+}
+
+TEST_CASE("CooMatrix compresses unsorted triplets and sums duplicates", "[SparseMatrix]")
+{
+    CooMatrix<int> coo(4, 3);
+    coo.add(2, 3, 5);
+    coo.add(0, 1, 1);
+    coo.add(2, 0, 4);
+    coo.add(0, 1, 2);
+    coo.add(1, 2, 3);
+    REQUIRE(coo.nonZeros() == 5);
+
+    Matrix<int> expected{
+        {0, 3, 0, 0},
+        {0, 0, 3, 0},
+        {4, 0, 0, 5},
+    };
+    REQUIRE(coo.toDense() == expected);
+
+    CsrMatrix<int> csr(coo);
+    REQUIRE(csr.nonZeros() == 4);
+    REQUIRE(csr.rowOffsets() == std::vector<size_t>{0, 1, 2, 4});
+    REQUIRE(csr.columnIndices() == std::vector<size_t>{1, 2, 0, 3});
+    REQUIRE(csr.values() == std::vector<int>{3, 3, 4, 5});
+    REQUIRE(csr.toDense() == expected);
+
+    CscMatrix<int> csc(coo);
+    REQUIRE(csc.columnOffsets() == std::vector<size_t>{0, 1, 2, 3, 4});
+    REQUIRE(csc.rowIndices() == std::vector<size_t>{2, 0, 1, 2});
+    REQUIRE(csc.values() == std::vector<int>{4, 3, 3, 5});
+    REQUIRE(csc.toDense() == expected);
+}
+
+TEST_CASE("Sparse matrices round-trip through dense storage", "[SparseMatrix]")
+{
+    Matrix<double> dense = sparseNumbered(7, 5);
+    CsrMatrix<double> csr(dense);
+    CscMatrix<double> csc(dense);
+    REQUIRE(csr.toDense() == dense);
+    REQUIRE(csc.toDense() == dense);
+    REQUIRE(csr.nonZeros() == csc.nonZeros());
+
+    // blocks are read through their stride
+    CsrMatrix<double> block(dense.block(1, 2, 4, 3));
+    REQUIRE(block.toDense() == Matrix<double>(dense.block(1, 2, 4, 3)));
+
+    REQUIRE(CscMatrix<double>(csr).toDense() == dense);
+    REQUIRE(CsrMatrix<double>(csc).toDense() == dense);
+    REQUIRE(csr.transpose().toDense() == dense.transpose());
+}
+
+TEST_CASE("Sparse matrix-vector product matches the dense product", "[SparseMatrix]")
+{
+    Matrix<double> dense = sparseNumbered(9, 6);
+    CsrMatrix<double> csr(dense);
+    CscMatrix<double> csc(dense);
+    Vector<double> x(9);
+    for (size_t i = 0; i < 9; i++)
+        x[i] = 1.0 + static_cast<double>(i) / 4;
+    Vector<double> expected = dense * x;
+
+    Vector<double> y = csr * x;
+    for (size_t i = 0; i < 6; i++)
+        REQUIRE(std::abs(y[i] - expected[i]) < 1e-12);
+    y = csc * x;
+    for (size_t i = 0; i < 6; i++)
+        REQUIRE(std::abs(y[i] - expected[i]) < 1e-12);
+
+    // strided operand and result: a row of a matrix in, a row of a matrix out
+    Matrix<double> rows(9, 3);
+    rows.setRow(1, x);
+    Matrix<double> results(6, 2);
+    VectorView<double> out = results.row(0);
+    csr.multiply(rows.row(1), out);
+    for (size_t i = 0; i < 6; i++)
+        REQUIRE(std::abs(results[i][0] - expected[i]) < 1e-12);
+    VectorView<double> other = results.row(1);
+    csc.multiply(rows.row(1), other);
+    for (size_t i = 0; i < 6; i++)
+        REQUIRE(std::abs(results[i][1] - expected[i]) < 1e-12);
+
+    // 0 * inf is NaN in both formats
+    CooMatrix<double> infinite(2, 2);
+    infinite.add(0, 1, std::numeric_limits<double>::infinity());
+    infinite.add(1, 0, 2.0);
+    Vector<double> e0{1.0, 0.0};
+    REQUIRE(std::isnan((CsrMatrix<double>(infinite) * e0)[0]));
+    REQUIRE(std::isnan((CscMatrix<double>(infinite) * e0)[0]));
+    REQUIRE((CscMatrix<double>(infinite) * e0)[1] == 2.0);
+}
+
+TEST_CASE("Sparse multiply into its own operand", "[SparseMatrix]")
+{
+    Matrix<double> dense{
+        {1, 2},
+        {3, 4},
+    };
+    Vector<double> v{1, 1};
+    CsrMatrix<double>(dense).multiply(v, v);
+    REQUIRE(v == Vector<double>{3, 7});
+    Vector<double> w{1, 1};
+    CscMatrix<double>(dense).multiply(w, w);
+    REQUIRE(w == Vector<double>{3, 7});
+}
+
+TEST_CASE("Sparse matrix-matrix product matches the dense product", "[SparseMatrix]")
+{
+    Matrix<double> dense = sparseNumbered(8, 5);
+    Matrix<double> b = sparseNumbered(11, 10);
+    for (size_t j = 0; j < 11; j++)
+        for (size_t i = 0; i < 10; i++)
+            b[j][i] += 0.5;
+    CsrMatrix<double> csr(dense);
+    CscMatrix<double> csc(dense);
+
+    // a block of b with 7 columns exercises both the 4-wide and the tail path
+    MatrixView<double> block = b.block(2, 1, 7, 8);
+    Matrix<double> expected = dense * Matrix<double>(block);
+    REQUIRE(near(csr * block, expected));
+    REQUIRE(near(csc * block, expected));
+
+    Matrix<double> c(9, 7);
+    MatrixView<double> target = c.block(1, 1, 7, 5);
+    csr.multiply(block, target);
+    REQUIRE(near(target, expected));
+}
+
+TEST_CASE("Sparse matrices report bad indices and sizes", "[SparseMatrix]")
+{
+    CooMatrix<double> coo(3, 2);
+    REQUIRE_THROWS_AS(coo.add(2, 0, 1.0), std::out_of_range);
+    REQUIRE_THROWS_AS(coo.add(0, 3, 1.0), std::out_of_range);
+
+    coo.add(1, 2, 1.0);
+    CsrMatrix<double> csr(coo);
+    CscMatrix<double> csc(coo);
+    Vector<double> wrong(2);
+    REQUIRE_THROWS_AS(csr * wrong, std::invalid_argument);
+    REQUIRE_THROWS_AS(csc * wrong, std::invalid_argument);
+    Matrix<double> b(2, 2);
+    REQUIRE_THROWS_AS(csr * b, std::invalid_argument);
+    REQUIRE_THROWS_AS(csc * b, std::invalid_argument);
+}
+
+TEST_CASE("CSR product on a large sparse system", "[SparseMatrix]")
+{
+    const size_t n = 100000;
+    CooMatrix<double> coo(n, n);
+    coo.reserve(3 * n);
+    for (size_t i = 0; i < n; i++)
+    {
+        coo.add(i, i, 2.0);
+        if (i > 0)
+            coo.add(i, i - 1, -1.0);
+        if (i + 1 < n)
+            coo.add(i, i + 1, -1.0);
+    }
+    CsrMatrix<double> csr(coo);
+    REQUIRE(csr.nonZeros() == 3 * n - 2);
+
+    // the second difference of a linear function vanishes inside the domain
+    Vector<double> x(n);
+    for (size_t i = 0; i < n; i++)
+        x[i] = static_cast<double>(i + 1);
+    Vector<double> y = csr * x;
+    REQUIRE(y[0] == 0.0);
+    REQUIRE(y[n / 2] == 0.0);
+    REQUIRE(y[n - 1] == static_cast<double>(n + 1));
+    REQUIRE(CscMatrix<double>(csr) * x == y);
+}
@@ -0,0 +1,167 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "Matrix.hpp"
+#include "LU.hpp"
+#include "Cholesky.hpp"
+#include "QR.hpp"
+#include "functions.hpp"
+#include "fixtures.hpp"
+
+using namespace m42;
+
+/**
+ * @brief C = alpha * A * B + beta * C one dot product at a time
+ */
+static Matrix<double> reference(const Matrix<double> &a, const Matrix<double> &b, double alpha, double beta, const Matrix<double> &c)
+{
+    Matrix<double> r(c);
+    for (size_t j = 0; j < r.width(); j++)
+        for (size_t i = 0; i < r.height(); i++)
+        {
+            double sum = 0;
+            for (size_t p = 0; p < a.width(); p++)
+                sum += a[p][i] * b[j][p];
+            r[j][i] = alpha * sum + beta * c[j][i];
+        }
+    return r;
+}
+
+TEST_CASE("ThreadPool runs every task once", "[ThreadPool]")
+{
+    for (size_t threads : {1, 2, 4})
+    {
+        ThreadPool pool(threads);
+        REQUIRE(pool.size() == threads);
+        std::vector<std::atomic<int>> counts(1000);
+        pool.parallelFor(counts.size(), [&](size_t i)
+                         { counts[i]++; });
+        REQUIRE(std::all_of(counts.begin(), counts.end(), [](const std::atomic<int> &count)
+                            { return count == 1; }));
+
+        // nested loops are run by the waiting threads instead of deadlocking
+        std::atomic<size_t> sum(0);
+        pool.parallelFor(8, [&](size_t i)
+                         { pool.parallelFor(10, [&](size_t j)
+                                            { sum += i * 10 + j; }); });
+        REQUIRE(sum == 79 * 80 / 2);
+
+        REQUIRE_THROWS_AS(pool.parallelFor(16, [](size_t i)
+                                           { if (i == 5) throw std::out_of_range("task"); }),
+                          std::out_of_range);
+    }
+    REQUIRE_THROWS_AS(ThreadPool(0), std::invalid_argument);
+}
+
+TEST_CASE("Multi-threaded GEMM matches the sequential product", "[ThreadPool]")
+{
+    size_t initial = parallel::threads();
+    for (size_t threads : {1, 3, 4})
+    {
+        parallel::setThreads(threads);
+        REQUIRE(parallel::threads() == threads);
+
+        // a grid of output tiles with ragged edges
+        Matrix<double> a = numbered(131, 301, 0.5);
+        Matrix<double> b = numbered(67, 131, 1.5);
+        Matrix<double> c = numbered(67, 301, 2.5);
+        Matrix<double> expected = reference(a, b, 0.5, -2.0, c);
+        blas::gemm(301, 67, 131, 0.5, a.data(), 301, b.data(), 131, -2.0, c.data(), 301);
+        REQUIRE(c.isAprrox(expected, 1e-12));
+
+        // fewer tiles than threads and a long shared dimension split k
+        Matrix<double> tall = numbered(3000, 100, 0.25);
+        Matrix<double> wide = numbered(8, 3000, 0.75);
+        Matrix<double> small = numbered(8, 100, 1.25);
+        expected = reference(tall, wide, 1.0, 3.0, small);
+        blas::gemm(100, 8, 3000, 1.0, tall.data(), 100, wide.data(), 3000, 3.0, small.data(), 100);
+        REQUIRE(small.isAprrox(expected, 1e-10));
+
+        REQUIRE((tall * wide).isAprrox(reference(tall, wide, 1.0, 0.0, small), 1e-10));
+    }
+    parallel::setThreads(initial);
+}
+
+TEST_CASE("Shared pool size comes from M42_NUM_THREADS", "[ThreadPool]")
+{
+    setenv("M42_NUM_THREADS", "3", 1);
+    REQUIRE(parallel::defaultThreads() == 3);
+    setenv("M42_NUM_THREADS", "many", 1);
+    REQUIRE(parallel::defaultThreads() == std::max(1u, std::thread::hardware_concurrency()));
+    unsetenv("M42_NUM_THREADS");
+
+    std::vector<int> covered(100000);
+    parallel::forRange(Execution::Parallel, covered.size(), 1000, [&](size_t begin, size_t end)
+                       { std::fill(covered.begin() + begin, covered.begin() + end, 1); });
+    REQUIRE(std::count(covered.begin(), covered.end(), 1) == 100000);
+    size_t sum = parallel::reduce(
+        Execution::Parallel, 100000, 1000, size_t(0),
+        [](size_t begin, size_t end)
+        { return (begin + end - 1) * (end - begin) / 2; },
+        [](size_t a, size_t b)
+        { return a + b; });
+    REQUIRE(sum == size_t(99999) * 100000 / 2);
+}
+
+TEST_CASE("Parallel and sequential policies agree", "[ThreadPool]")
+{
+    size_t initial = parallel::threads();
+    parallel::setThreads(4);
+
+    Matrix<double> a = numbered(300, 301, 0.5);
+    Matrix<double> b = numbered(300, 301, 1.5);
+    Matrix<double> sequential(300, 301);
+    Matrix<double> concurrent(300, 301);
+    (a * 2.0 - b).evaluateTo(sequential.data(), Execution::Sequential);
+    (a * 2.0 - b).evaluateTo(concurrent.data(), Execution::Parallel);
+    REQUIRE(concurrent == sequential);
+    Matrix<double> sum(a);
+    sum += b;
+    REQUIRE(sum == Matrix<double>(a + b));
+    REQUIRE(a.transpose(Execution::Parallel) == a.transpose(Execution::Sequential));
+
+    Vector<double> x(a.data(), 300 * 301);
+    REQUIRE(std::abs(x.norm(Execution::Parallel) - x.norm(Execution::Sequential)) < 1e-9);
+    REQUIRE(x.normInf(Execution::Parallel) == x.normInf(Execution::Sequential));
+    std::vector<Vector<double>> vectors{x, x * 2.0, x * -0.5};
+    REQUIRE(linearCombination(vectors, {1.0, 0.5, 2.0}, Execution::Parallel) ==
+            linearCombination(vectors, {1.0, 0.5, 2.0}, Execution::Sequential));
+
+    Matrix<double> spd = a.transpose() * a;
+    for (size_t i = 0; i < 300; i++)
+        spd[i][i] += 300.0;
+    REQUIRE(LU<double>(spd, Execution::Parallel).packed().isAprrox(LU<double>(spd, Execution::Sequential).packed(), 1e-9));
+    REQUIRE(Cholesky<double>(spd, Execution::Parallel).packed().isAprrox(Cholesky<double>(spd, Execution::Sequential).packed(), 1e-9));
+    REQUIRE(QR<double>(a, Execution::Parallel).packed().isAprrox(QR<double>(a, Execution::Sequential).packed(), 1e-9));
+
+    parallel::setThreads(initial);
+}
+
+TEST_CASE("Multi-threaded vector operators match the element-wise result", "[ThreadPool]")
+{
+    size_t initial = parallel::threads();
+    const size_t n = 5 * parallel::grainSize + 17;
+    Vector<double> x = numberedVector(n);
+    Vector<double> y = x * 0.5;
+    for (size_t threads : {1, 3, 4})
+    {
+        parallel::setThreads(threads);
+        Vector<double> v(x);
+        v += y;
+        v *= 3.0;
+        v -= x;
+        v /= 2.0;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < n; i++)
+            mismatches += v[i] != ((x[i] + y[i]) * 3.0 - x[i]) / 2.0;
+        REQUIRE(mismatches == 0);
+    }
+    parallel::setThreads(initial);
+}
@@ -1,4 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "VectorView.hpp"
 
@@ -195,3 +198,173 @@ TEST_CASE("Multiplication assignment", "[VectorView]")
     REQUIRE(vectorView[3] == 8);
     REQUIRE(vectorView[4] == 10);
 }
+
+TEST_CASE("Long vector arithmetic and reductions", "[VectorView]")
+{
+    // odd size and offset so that both the vector body and the scalar tail run on unaligned data
+    const size_t size = 1003;
+    std::vector<double> data1(size + 1);
+    std::vector<double> data2(size + 1);
+    std::vector<int> data3(size + 1);
+    for (size_t i = 0; i <= size; i++)
+    {
+        data1[i] = static_cast<double>(i % 11) - 5.0;
+        data2[i] = static_cast<double>(i % 7) * 0.5;
+        data3[i] = static_cast<int>(i % 9) - 4;
+    }
+    VectorView<double> v1(data1.data() + 1, size);
+    VectorView<double> v2(data2.data() + 1, size);
+    VectorView<int> v3(data3.data() + 1, size);
+
+    double dot = 0, sumSquares = 0, sumAbs = 0, maxAbs = 0;
+    int intSumAbs = 0, intMaxAbs = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        dot += v1[i] * v2[i];
+        sumSquares += v1[i] * v1[i];
+        sumAbs += std::abs(v1[i]);
+        maxAbs = std::max(maxAbs, std::abs(v1[i]));
+        intSumAbs += std::abs(v3[i]);
+        intMaxAbs = std::max(intMaxAbs, std::abs(v3[i]));
+    }
+
+    REQUIRE(v1 * v2 == dot);
+    REQUIRE(v1.norm() == std::sqrt(sumSquares));
+    REQUIRE(v1.norm1() == sumAbs);
+    REQUIRE(v1.normInf() == maxAbs);
+    REQUIRE(v3.norm1() == intSumAbs);
+    REQUIRE(v3.normInf() == intMaxAbs);
+
+    Vector<double> sum = v1 + v2;
+    Vector<double> difference = v1 - v2;
+    Vector<double> scaled = v1 * 3.0;
+    for (size_t i = 0; i < size; i++)
+    {
+        REQUIRE(sum[i] == v1[i] + v2[i]);
+        REQUIRE(difference[i] == v1[i] - v2[i]);
+        REQUIRE(scaled[i] == v1[i] * 3.0);
+    }
+
+    REQUIRE(v1.isApprox(sum - v2));
+    difference[size - 1] += 1e-3;
+    REQUIRE_FALSE(v1.isApprox(difference + v2, 1e-4));
+}
+
+TEST_CASE("Fused vector expression", "[VectorView]")
+{
+    int data1[]{1, 2, 3};
+    int data2[]{4, 5, 6};
+    int data3[]{7, 8, 9};
+    int out[]{0, 0, 0};
+
+    VectorView<int> b(data1, 3);
+    VectorView<int> c(data2, 3);
+    VectorView<int> d(data3, 3);
+    VectorView<int> a(out, 3);
+
+    a = b + c * 2 - d;
+    REQUIRE(a.data() == out);
+    REQUIRE(a == Vector{2, 4, 6});
+
+    // the destination may appear in its own expression
+    a = -(a + b) / 3;
+    REQUIRE(a == Vector{-1, -2, -3});
+
+    REQUIRE((b + c) * (d - c) == 3 * (5 + 7 + 9));
+    REQUIRE_THROWS_AS(a = b + Vector({1, 2}), std::invalid_argument);
+}
+
+TEST_CASE("Print and evaluate a vector expression", "[VectorView]")
+{
+    Vector<int> a{1, 2, 3};
+    Vector<int> b{4, 5, 6};
+
+    std::ostringstream os;
+    os << a + b;
+    REQUIRE(os.str() == "[5 7 9]");
+    REQUIRE(static_cast<std::string>(a - b) == "[-3 -3 -3]");
+    REQUIRE(format_as(a * 2) == "[2 4 6]");
+
+    Vector<int> sum = (a + b).eval();
+    REQUIRE(sum == Vector{5, 7, 9});
+    REQUIRE((Vector<double>{3.0, 0.0} + Vector<double>{0.0, 4.0}).eval().norm() == 5.0);
+}
+
+TEST_CASE("Compound assignment works in place", "[VectorView]")
+{
+    double data1[]{1.0, 2.0, 3.0};
+    double data2[]{4.0, 5.0, 6.0};
+
+    VectorView<double> v1(data1, 3);
+    VectorView<double> v2(data2, 3);
+
+    v1 += v2 * 2.0;
+    REQUIRE(v1.data() == data1);
+    REQUIRE(v1 == Vector{9.0, 12.0, 15.0});
+
+    v1 -= v2 + v2;
+    REQUIRE(v1 == Vector{1.0, 2.0, 3.0});
+
+    (v1 *= 4.0) /= 2.0;
+    REQUIRE(data1[0] == 2.0);
+    REQUIRE(data1[1] == 4.0);
+    REQUIRE(data1[2] == 6.0);
+
+    REQUIRE_THROWS_AS(v1 += Vector({1.0, 2.0}), std::invalid_argument);
+}
+
+TEST_CASE("Strided views", "[VectorView]")
+{
+    int data[]{1, 2, 3, 4, 5, 6, 7, 8, 9};
+    VectorView<int> every3(data, 3, 3);
+    VectorView<int> every4(data, 3, 4);
+    REQUIRE(every3.stride() == 3);
+    REQUIRE_FALSE(every3.isContiguous());
+    REQUIRE(every3 == Vector{1, 4, 7});
+    REQUIRE(every3[2] == 7);
+    REQUIRE(every3.norm1() == 12);
+    REQUIRE(every4.normInf() == 9);
+    REQUIRE(every3 * every4 == 1 + 4 * 5 + 7 * 9);
+
+    Vector<int> copy(every4);
+    REQUIRE(copy == Vector{1, 5, 9});
+
+    // element-wise expressions write through the stride
+    VectorView<int>(data + 1, 3, 3) = every3 + every4;
+    REQUIRE(Vector<int>(data, 9) == Vector{1, 2, 3, 4, 9, 6, 7, 16, 9});
+    every3 *= 2;
+    every3 -= copy;
+    REQUIRE(every3 == Vector{1, 3, 5});
+    REQUIRE_THROWS_AS(VectorView<int>(data, 3, 0), std::invalid_argument);
+}
+
+TEST_CASE("Rows and diagonals are views of the matrix", "[VectorView]")
+{
+    Matrix<double> m{
+        {4.0, 1.0, 2.0},
+        {1.0, 5.0, 3.0},
+        {2.0, 3.0, 6.0},
+    };
+    VectorView<double> row = m.row(1);
+    REQUIRE(row.stride() == 3);
+    REQUIRE(row == Vector{1.0, 5.0, 3.0});
+    row *= 2.0;
+    REQUIRE(m[1][1] == 10.0);
+    row /= 2.0;
+
+    VectorView<double> diagonal = m.diagonal();
+    REQUIRE(diagonal == Vector{4.0, 5.0, 6.0});
+    diagonal += Vector{1.0, 1.0, 1.0};
+    REQUIRE(m.trace() == 18.0);
+
+    Vector<double> x{1.0, 2.0, 3.0};
+    REQUIRE((m * row).isApprox(m * Vector<double>(row)));
+    REQUIRE((row * m).isApprox(Vector<double>(row) * m));
+    LU<double> lu = m.lu();
+    Matrix<double> solutions(3, 3);
+    solutions.row(2) = m * x;
+    lu.solveInPlace(solutions.row(2));
+    REQUIRE(solutions.row(2).isApprox(x));
+    REQUIRE(Matrix<double>{{2.0, 1.0}, {3.0, 4.0}}.diagonal().size() == 2);
+    REQUIRE(Matrix<double>(3, 2).diagonal().size() == 2);
+}
@@ -110,3 +110,45 @@ TEST_CASE("Projection matrix")
     }
     file.close();
 }
+
+TEST_CASE("Batched point transform", "[functions]")
+{
+    // not a multiple of any packet width, so the scalar tail runs too
+    const size_t n = 1000 + 3;
+    FixedMatrix<float, 4, 4> projection = makeFixedProjectionMatrix(M_PI / 3.0f, 1.5f, 0.5f, 50.0f);
+    std::vector<float> x(n), y(n), z(n), interleaved(4 * n);
+    for (size_t i = 0; i < n; i++)
+    {
+        x[i] = std::sin(static_cast<float>(i));
+        y[i] = std::cos(static_cast<float>(i * i));
+        z[i] = -1.0f - static_cast<float>(i % 40);
+        interleaved[4 * i] = x[i];
+        interleaved[4 * i + 1] = y[i];
+        interleaved[4 * i + 2] = z[i];
+        interleaved[4 * i + 3] = 1.0f;
+    }
+    std::vector<float> ox(n), oy(n), oz(n), ow(n);
+    transformPoints(projection, x.data(), y.data(), z.data(), nullptr, ox.data(), oy.data(), oz.data(), ow.data(), n, true);
+    transformPoints(projection, interleaved.data(), interleaved.data(), n, true);
+
+    bool matches = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        FixedVector<float, 4> expected = projection * FixedVector<float, 4>{x[i], y[i], z[i], 1.0f};
+        float scale = 1.0f / expected[3];
+        float tolerance = 1e-5f * (1.0f + std::abs(expected[0] * scale) + std::abs(expected[2] * scale));
+        matches = matches &&
+                  std::abs(ox[i] - expected[0] * scale) < tolerance &&
+                  std::abs(oy[i] - expected[1] * scale) < tolerance &&
+                  std::abs(oz[i] - expected[2] * scale) < tolerance &&
+                  ow[i] == expected[3] &&
+                  interleaved[4 * i] == ox[i] && interleaved[4 * i + 1] == oy[i] &&
+                  interleaved[4 * i + 2] == oz[i] && interleaved[4 * i + 3] == ow[i];
+    }
+    REQUIRE(matches);
+
+    // without the divide the transform is exact for the identity
+    transformPoints(FixedMatrix<float, 4, 4>::identity(), x.data(), y.data(), z.data(), nullptr, ox.data(), oy.data(), oz.data(), nullptr, n);
+    REQUIRE(ox == x);
+    REQUIRE(oz == z);
+}
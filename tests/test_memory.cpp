@@ -0,0 +1,193 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "memory.hpp"
+#include "Matrix.hpp"
+#include "LU.hpp"
+#include "fixtures.hpp"
+
+using namespace m42;
+
+/**
+ * @brief Allocator counting the elements it hands out
+ */
+template <typename T>
+struct CountingAllocator
+{
+    using value_type = T;
+
+    std::shared_ptr<size_t> live = std::make_shared<size_t>(0);
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &other) : live(other.live) {}
+
+    T *allocate(size_t n)
+    {
+        *live += n;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        *live -= n;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U> &other) const { return live == other.live; }
+};
+
+static bool aligned(const void *p)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % storageAlignment == 0;
+}
+
+TEST_CASE("Storage is aligned", "[memory]")
+{
+    for (size_t n : {1, 3, 17, 1000})
+    {
+        REQUIRE(aligned(Vector<double>(n).data()));
+        REQUIRE(aligned(Vector<float>(n).data()));
+        REQUIRE(aligned(Matrix<double>(n, 3).data()));
+    }
+    REQUIRE(alignedStride<double>(1) == 8);
+    REQUIRE(alignedStride<double>(8) == 8);
+    REQUIRE(alignedStride<float>(17) == 32);
+    REQUIRE(Vector<double>().data() == nullptr);
+}
+
+TEST_CASE("Padded matrices", "[memory]")
+{
+    Matrix<double> a = numbered(7, 13, 0.0, Padding::Aligned);
+    Matrix<double> b = numbered(7, 13);
+    REQUIRE(a.stride() == 16);
+    REQUIRE(a.isPadded());
+    REQUIRE(!b.isPadded());
+    for (size_t j = 0; j < a.width(); j++)
+        REQUIRE(aligned(&a[j][0]));
+    REQUIRE(a == b);
+
+    // copies keep the padding, expressions are evaluated column by column
+    Matrix<double> copy(a);
+    REQUIRE(copy.stride() == 16);
+    copy = a * 2.0 - b;
+    REQUIRE(copy.stride() == 16);
+    REQUIRE(copy == b);
+    copy += a;
+    REQUIRE(copy == Matrix<double>(b * 2.0));
+    REQUIRE(Matrix<double>(a + b) == Matrix<double>(b * 2.0));
+
+    Matrix<double> square = numbered(13, 13, 0.0, Padding::Aligned);
+    REQUIRE((square * a).isAprrox(numbered(13, 13) * b, 1e-12));
+    REQUIRE(a.transpose() == b.transpose());
+    Matrix<double> transposed(a);
+    transposed.transposeInPlace();
+    REQUIRE(transposed.stride() == 8);
+    REQUIRE(transposed == b.transpose());
+
+    for (size_t i = 0; i < 13; i++)
+        square[i][i] += 10.0;
+    Matrix<double> x = square.solve(a);
+    REQUIRE((square * x).isAprrox(b, 1e-10));
+    REQUIRE(square.inverse().isAprrox(LU<double>(square).inverse(), 1e-12));
+    REQUIRE(square.rank() == 13);
+}
+
+TEST_CASE("Custom allocators", "[memory]")
+{
+    CountingAllocator<double> allocator;
+    {
+        Vector<double, CountingAllocator<double>> v(10, allocator);
+        REQUIRE(*allocator.live == 10);
+        for (size_t i = 0; i < v.size(); i++)
+            v[i] = static_cast<double>(i);
+        Vector<double, CountingAllocator<double>> w = v;
+        REQUIRE(*allocator.live == 20);
+        w = v + v;
+        REQUIRE(w[3] == 6.0);
+
+        Matrix<double, CountingAllocator<double>> m(4, 5, Padding::Aligned, allocator);
+        REQUIRE(*allocator.live == 20 + 4 * 8);
+        m = numbered(4, 5) * 3.0;
+        REQUIRE(m.stride() == 8);
+        REQUIRE(m == Matrix<double>(numbered(4, 5) * 3.0));
+        Matrix<double, CountingAllocator<double>> moved(std::move(m));
+        REQUIRE(*allocator.live == 20 + 4 * 8);
+        REQUIRE(moved.allocator() == allocator);
+    }
+    REQUIRE(*allocator.live == 0);
+}
+
+TEST_CASE("Arena rewinds to marks", "[memory]")
+{
+    Arena arena;
+    REQUIRE(arena.capacity() == 0);
+    Arena::Mark empty = arena.mark();
+    auto *first = static_cast<double *>(arena.allocate(10 * sizeof(double)));
+    REQUIRE(reinterpret_cast<std::uintptr_t>(first) % storageAlignment == 0);
+    Arena::Mark mark = arena.mark();
+    void *second = arena.allocate(3, 1);
+    REQUIRE(static_cast<unsigned char *>(second) == reinterpret_cast<unsigned char *>(first + 10));
+    arena.rewind(mark);
+    REQUIRE(arena.allocate(3, 1) == second);
+
+    // growing past the first block adds blocks, rewinding to empty merges them
+    arena.allocate(Arena::initialSize);
+    arena.allocate(3 * Arena::initialSize);
+    REQUIRE(arena.blocks() == 3);
+    size_t capacity = arena.capacity();
+    arena.rewind(empty);
+    REQUIRE(arena.blocks() == 1);
+    REQUIRE(arena.capacity() == capacity);
+    REQUIRE_THROWS_AS(arena.allocate(8, 3), std::invalid_argument);
+}
+
+TEST_CASE("Temporaries of algorithms come from the scratch arena", "[memory]")
+{
+    Matrix<double> a = numbered(40, 40);
+    for (size_t i = 0; i < 40; i++)
+        a[i][i] += 8.0;
+    Matrix<double> rows(40, 3);
+    for (size_t j = 0; j < 40; j++)
+        rows[j][1] = static_cast<double>(j);
+
+    Arena &arena = scratch::arena();
+    auto work = [&]
+    {
+        double determinant = a.determinant();
+        double cofactor = a.cofactor(2, 3);
+        size_t rank = a.rank();
+        Vector<double> product = rows.row(1) * a;
+        return determinant + cofactor + static_cast<double>(rank) + product[0];
+    };
+    double expected = work();
+    size_t capacity = arena.capacity();
+    REQUIRE(capacity > 0);
+    REQUIRE(arena.blocks() == 1);
+    // steady state: the arena neither grows nor keeps anything
+    for (int i = 0; i < 3; i++)
+        REQUIRE(work() == expected);
+    REQUIRE(arena.capacity() == capacity);
+    REQUIRE(arena.mark().block == 0);
+    REQUIRE(arena.mark().offset == 0);
+
+    REQUIRE(std::abs(a.determinant() - LU<double>(a).determinant()) <= 1e-9 * std::abs(a.determinant()));
+    REQUIRE(std::abs(a.cofactor(2, 3) + a.getSubmatrix(2, 3).determinant()) < 1e-6);
+
+    {
+        ScratchScope scope;
+        ScratchMatrix<double> temporary(a);
+        ScratchVector<double> column(temporary[0]);
+        REQUIRE(arena.mark().offset >= 40 * 41 * sizeof(double));
+        REQUIRE(column[0] == a[0][0]);
+    }
+    REQUIRE(arena.mark().offset == 0);
+
+    // nothing would release an allocation made outside of a scope
+    REQUIRE_THROWS_AS(ScratchVector<double>(8), std::logic_error);
+    REQUIRE(arena.mark().offset == 0);
+}
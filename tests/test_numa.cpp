@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cstdint>
+
+#include "numa.hpp"
+#include "Matrix.hpp"
+
+using namespace m42;
+
+TEST_CASE("Node lists are parsed into masks", "[numa]")
+{
+    REQUIRE(numa::parseNodeList("0") == 1ul);
+    REQUIRE(numa::parseNodeList("0-2,4\n") == 0b10111ul);
+    REQUIRE(numa::parseNodeList("") == 0ul);
+    REQUIRE((numa::onlineNodes() & 1ul) == 1ul);
+    REQUIRE(numa::mappedLength(1, HugePages::None) == 4096);
+    REQUIRE(numa::mappedLength(numa::hugePageSize + 1, HugePages::Transparent) == 2 * numa::hugePageSize);
+}
+
+TEST_CASE("NumaAllocator backs large matrices", "[numa]")
+{
+    size_t initial = parallel::threads();
+    parallel::setThreads(3);
+    for (Placement placement : {Placement::FirstTouch, Placement::Interleaved})
+        for (HugePages pages : {HugePages::None, HugePages::Transparent, HugePages::Explicit})
+        {
+            NumaAllocator<double> allocator(placement, pages);
+            REQUIRE(allocator.placement() == placement);
+            Matrix<double, NumaAllocator<double>> a(300, 500, Padding::None, allocator);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(a.data()) % storageAlignment == 0);
+            if (pages == HugePages::Transparent)
+                REQUIRE(reinterpret_cast<std::uintptr_t>(a.data()) % numa::hugePageSize == 0);
+            // pages are zeroed when they are placed
+            REQUIRE(std::all_of(a.data(), a.data() + 300 * 500, [](double x)
+                                { return x == 0.0; }));
+
+            Matrix<double> b(300, 500);
+            for (size_t j = 0; j < 300; j++)
+                for (size_t i = 0; i < 500; i++)
+                    b[j][i] = static_cast<double>(i + j);
+            a = b * 2.0;
+            a += b;
+            REQUIRE(a == Matrix<double>(b * 3.0));
+
+            // small allocations come from the heap
+            Vector<float, NumaAllocator<float>> small(16, NumaAllocator<float>(allocator));
+            REQUIRE(reinterpret_cast<std::uintptr_t>(small.data()) % storageAlignment == 0);
+        }
+    parallel::setThreads(initial);
+}